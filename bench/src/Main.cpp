@@ -0,0 +1,737 @@
+/*
+**   Copyright 2021 Maxime Rayé
+**
+**   Licensed under the Apache License, Version 2.0 (the "License");
+**   you may not use this file except in compliance with the License.
+**   You may obtain a copy of the License at
+**
+**       http://www.apache.org/licenses/LICENSE-2.0
+**
+**   Unless required by applicable law or agreed to in writing, software
+**   distributed under the License is distributed on an "AS IS" BASIS,
+**   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**   See the License for the specific language governing permissions and
+**   limitations under the License.
+*/
+
+/*
+ * Throughput benchmarks, printed as JSON so that results can be diffed between versions:
+ *  - noise kernels, in ns/sample
+ *  - Generator::generate(), in Mpixels/s, for several image sizes, octave counts and thread counts
+ *  - Generator::generateInto(), in Mpixels/s, for raw and quantized samples written to a caller buffer
+ *  - Generator::saveToPGM(), in MB/s, for every output format
+ *  - Generator::mapToPGM() against generate() + saveToPGM(), in Mpixels/s from settings to file
+ *  - TileCache::renderViewport() while panning, in Mpixels/s, against rendering every frame with generateRegion()
+ * Every case runs a few warm-up iterations, then reports statistics over the measured repetitions.
+ */
+
+#include <cmath>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdio>
+#include <fstream>
+#include <numeric>
+#include <iostream>
+#include <algorithm>
+#include <functional>
+
+#include <argparse.hpp>
+
+#include <noisegen/Generator.hpp>
+#include <noisegen/Settings.hpp>
+#include <noisegen/Simd.hpp>
+#include <noisegen/TileCache.hpp>
+
+namespace {
+using Clock = std::chrono::steady_clock;
+using DurationSeconds = std::chrono::duration<double>;
+
+struct BenchmarkSettings
+{
+    uint32_t warmup{2};
+    uint32_t repetitions{10};
+    bool bQuick{false};
+    std::string outputFile{};
+    std::string scratchFile{"noisegen_bench.pgm"};
+};
+
+struct Statistics
+{
+    double min{};
+    double median{};
+    double mean{};
+    double stddev{};
+    double max{};
+};
+
+struct Result
+{
+    std::string name{};
+    std::string parameters{};  // JSON object members, without braces
+    std::string unit{};
+    Statistics statistics{};
+};
+
+Statistics computeStatistics(std::vector<double> values)
+{
+    Statistics statistics{};
+
+    std::sort(values.begin(), values.end());
+    statistics.min = values.front();
+    statistics.max = values.back();
+    statistics.median = values.size() % 2 == 1
+                          ? values[values.size() / 2]
+                          : (values[values.size() / 2 - 1] + values[values.size() / 2]) / 2.0;
+    statistics.mean = std::accumulate(values.cbegin(), values.cend(), 0.0) / static_cast<double>(values.size());
+
+    double variance = 0.0;
+    for (const double value : values)
+        variance += (value - statistics.mean) * (value - statistics.mean);
+    statistics.stddev = std::sqrt(variance / static_cast<double>(values.size()));
+
+    return statistics;
+}
+
+/**
+ * Run func warmup + repetitions times, and convert each measured duration with toMetric
+ */
+Statistics measure(const BenchmarkSettings &settings, const std::function<void()> &func,
+                   const std::function<double(double seconds)> &toMetric)
+{
+    for (uint32_t i = 0; i < settings.warmup; ++i)
+        func();
+
+    std::vector<double> metrics{};
+    metrics.reserve(settings.repetitions);
+
+    for (uint32_t i = 0; i < settings.repetitions; ++i)
+    {
+        const auto start = Clock::now();
+        func();
+        const DurationSeconds duration = Clock::now() - start;
+
+        metrics.push_back(toMetric(duration.count()));
+    }
+    return computeStatistics(std::move(metrics));
+}
+
+noisegen::Settings makeSettings(uint32_t size, uint32_t octaves, uint32_t threads)
+{
+    noisegen::Settings settings{};
+
+    settings.width = size;
+    settings.height = size;
+    settings.octaves = octaves;
+    settings.threads = threads;
+    settings.bUseKenPerlinPermutations = true;
+    return settings;
+}
+
+// Results of the kernels are accumulated here so that the compiler can't drop the calls
+volatile double g_sink = 0.0;
+
+void benchmarkKernels(const BenchmarkSettings &settings, std::vector<Result> &results)
+{
+    const size_t sampleCount = settings.bQuick ? size_t{1} << 16U : size_t{1} << 20U;
+    const noisegen::Generator generator{makeSettings(1, 1, 1)};
+
+    auto simplexSettings = makeSettings(1, 1, 1);
+    simplexSettings.basis = noisegen::Basis::Simplex;
+    const noisegen::Generator simplexGenerator{simplexSettings};
+
+    std::mt19937 engine{42};
+    std::uniform_real_distribution<double> distribution{0.0, 256.0};
+
+    std::vector<double> xs(sampleCount), ys(sampleCount), zs(sampleCount), out(sampleCount);
+    std::generate(xs.begin(), xs.end(), [&] { return distribution(engine); });
+    std::generate(ys.begin(), ys.end(), [&] { return distribution(engine); });
+    std::generate(zs.begin(), zs.end(), [&] { return distribution(engine); });
+
+    const std::vector<float> xsFloat(xs.cbegin(), xs.cend());
+    const std::vector<float> ysFloat(ys.cbegin(), ys.cend());
+    const std::vector<float> zsFloat(zs.cbegin(), zs.cend());
+    std::vector<float> outFloat(sampleCount);
+
+    // Sorted row coordinates, 64 samples per lattice cell (a low octave of a large image)
+    std::vector<double> rowXs(sampleCount);
+    for (size_t i = 0; i < sampleCount; ++i)
+        rowXs[i] = static_cast<double>(i) / 64.0;
+    const std::vector<float> rowXsFloat(rowXs.cbegin(), rowXs.cend());
+
+    const auto nsPerSample = [&](double seconds) { return seconds * 1e9 / static_cast<double>(sampleCount); };
+    const std::string parameters = "\"samples\": " + std::to_string(sampleCount);
+
+    const std::vector<std::pair<std::string, std::function<void()>>> kernels{
+      {"noise3D",
+       [&] {
+           double sum = 0.0;
+           for (size_t i = 0; i < sampleCount; ++i)
+               sum += generator.noise3D(xs[i], ys[i], zs[i]);
+           g_sink = g_sink + sum;
+       }},
+      {"noise2D",
+       [&] {
+           double sum = 0.0;
+           for (size_t i = 0; i < sampleCount; ++i)
+               sum += generator.noise2D(xs[i], ys[i]);
+           g_sink = g_sink + sum;
+       }},
+      {"noise3DBatch<double>",
+       [&] {
+           generator.noise3DBatch(xs.data(), ys.data(), zs.data(), out.data(), sampleCount);
+           g_sink = g_sink + out.back();
+       }},
+      {"noise3DBatch<float>",
+       [&] {
+           generator.noise3DBatch(xsFloat.data(), ysFloat.data(), zsFloat.data(), outFloat.data(), sampleCount);
+           g_sink = g_sink + static_cast<double>(outFloat.back());
+       }},
+      {"noise2DBatch<double>",
+       [&] {
+           generator.noise2DBatch(xs.data(), ys.data(), out.data(), sampleCount);
+           g_sink = g_sink + out.back();
+       }},
+      {"noise2DBatch<float>",
+       [&] {
+           generator.noise2DBatch(xsFloat.data(), ysFloat.data(), outFloat.data(), sampleCount);
+           g_sink = g_sink + static_cast<double>(outFloat.back());
+       }},
+      {"simplex3D",
+       [&] {
+           double sum = 0.0;
+           for (size_t i = 0; i < sampleCount; ++i)
+               sum += simplexGenerator.noise3D(xs[i], ys[i], zs[i]);
+           g_sink = g_sink + sum;
+       }},
+      {"simplex3DBatch<double>",
+       [&] {
+           simplexGenerator.noise3DBatch(xs.data(), ys.data(), zs.data(), out.data(), sampleCount);
+           g_sink = g_sink + out.back();
+       }},
+      {"simplex3DBatch<float>",
+       [&] {
+           simplexGenerator.noise3DBatch(xsFloat.data(), ysFloat.data(), zsFloat.data(), outFloat.data(), sampleCount);
+           g_sink = g_sink + static_cast<double>(outFloat.back());
+       }},
+      {"simplex2DBatch<double>",
+       [&] {
+           simplexGenerator.noise2DBatch(xs.data(), ys.data(), out.data(), sampleCount);
+           g_sink = g_sink + out.back();
+       }},
+      {"simplex2DBatch<float>",
+       [&] {
+           simplexGenerator.noise2DBatch(xsFloat.data(), ysFloat.data(), outFloat.data(), sampleCount);
+           g_sink = g_sink + static_cast<double>(outFloat.back());
+       }},
+      {"noise3DRow<double>",
+       [&] {
+           generator.noise3DRow(rowXs.data(), 0.5, 0.25, out.data(), sampleCount);
+           g_sink = g_sink + out.back();
+       }},
+      {"noise3DRow<float>",
+       [&] {
+           generator.noise3DRow(rowXsFloat.data(), 0.5F, 0.25F, outFloat.data(), sampleCount);
+           g_sink = g_sink + static_cast<double>(outFloat.back());
+       }},
+      {"noise2DRow<double>",
+       [&] {
+           generator.noise2DRow(rowXs.data(), 0.5, out.data(), sampleCount);
+           g_sink = g_sink + out.back();
+       }},
+      {"noise2DRow<float>",
+       [&] {
+           generator.noise2DRow(rowXsFloat.data(), 0.5F, outFloat.data(), sampleCount);
+           g_sink = g_sink + static_cast<double>(outFloat.back());
+       }},
+    };
+
+    for (const auto &[name, kernel] : kernels)
+    {
+        std::cerr << "kernel " << name << '\n';
+        results.push_back({name, parameters, "ns/sample", measure(settings, kernel, nsPerSample)});
+    }
+}
+
+template<typename Real>
+Statistics measureGenerate(const BenchmarkSettings &settings, const noisegen::Settings &generatorSettings)
+{
+    noisegen::BasicGenerator<Real> generator{generatorSettings};
+    const double megapixels = static_cast<double>(generatorSettings.width) * generatorSettings.height / 1e6;
+
+    return measure(
+      settings, [&] { generator.generate(); }, [&](double seconds) { return megapixels / seconds; });
+}
+
+void benchmarkGenerate(const BenchmarkSettings &settings, std::vector<Result> &results)
+{
+    const std::vector<uint32_t> sizes = settings.bQuick ? std::vector<uint32_t>{512, 1024}
+                                                        : std::vector<uint32_t>{512, 2048, 4096};
+    const std::vector<uint32_t> octaveCounts = settings.bQuick ? std::vector<uint32_t>{8}
+                                                               : std::vector<uint32_t>{1, 4, 8, 12};
+    std::vector<uint32_t> threadCounts{1};
+    if (std::thread::hardware_concurrency() > 1)
+        threadCounts.push_back(std::thread::hardware_concurrency());
+
+    for (const uint32_t size : sizes)
+    {
+        for (const uint32_t octaves : octaveCounts)
+        {
+            for (const uint32_t threads : threadCounts)
+            {
+                for (const auto precision : {noisegen::Precision::Double, noisegen::Precision::Float})
+                {
+                    std::cerr << "generate " << size << 'x' << size << " octaves=" << octaves
+                              << " threads=" << threads << " precision=" << noisegen::toString(precision) << '\n';
+
+                    const auto generatorSettings = makeSettings(size, octaves, threads);
+
+                    results.push_back({"generate",
+                                       "\"width\": " + std::to_string(size) + ", \"height\": " + std::to_string(size)
+                                         + ", \"octaves\": " + std::to_string(octaves)
+                                         + ", \"threads\": " + std::to_string(threads) + ", \"precision\": \""
+                                         + noisegen::toString(precision) + '"',
+                                       "Mpixels/s",
+                                       precision == noisegen::Precision::Float
+                                         ? measureGenerate<float>(settings, generatorSettings)
+                                         : measureGenerate<double>(settings, generatorSettings)});
+                }
+            }
+        }
+    }
+}
+
+void benchmarkGenerateInto(const BenchmarkSettings &settings, std::vector<Result> &results)
+{
+    const uint32_t size = settings.bQuick ? 1024 : 2048;
+    const auto megapixels = static_cast<double>(size) * size / 1e6;
+
+    auto generatorSettings = makeSettings(size, 8, 0);
+    generatorSettings.normalization = noisegen::Normalization::Analytic;
+    const noisegen::Generator generator{generatorSettings};
+
+    std::vector<double> raw(static_cast<size_t>(size) * size);
+    std::vector<uint8_t> quantized(static_cast<size_t>(size) * size);
+
+    const std::vector<std::pair<const char *, std::function<void()>>> cases{
+      {"f64", [&] { generator.generateInto(raw.data()); }},
+      {"u8", [&] { generator.generateInto(quantized.data()); }},
+    };
+
+    for (const auto &[type, func] : cases)
+    {
+        std::cerr << "generateInto " << size << 'x' << size << ' ' << type << '\n';
+
+        results.push_back({"generateInto",
+                           "\"width\": " + std::to_string(size) + ", \"height\": " + std::to_string(size)
+                             + ", \"type\": \"" + type + '"',
+                           "Mpixels/s", measure(settings, func, [&](double seconds) { return megapixels / seconds; })});
+    }
+}
+
+/**
+ * Height plus derivatives: fused analytic derivatives against central differences over the generated image
+ */
+void benchmarkDerivatives(const BenchmarkSettings &settings, std::vector<Result> &results)
+{
+    const uint32_t size = settings.bQuick ? 1024 : 2048;
+    const auto megapixels = static_cast<double>(size) * size / 1e6;
+
+    auto generatorSettings = makeSettings(size, 8, 0);
+    generatorSettings.normalization = noisegen::Normalization::Analytic;
+    noisegen::Generator generator{generatorSettings};
+
+    std::vector<double> dxs(static_cast<size_t>(size) * size);
+    std::vector<double> dys(static_cast<size_t>(size) * size);
+
+    const auto finiteDifferences = [&] {
+        generator.generate();
+
+        const auto &image = generator.getImage();
+        const double scale = size / 2.0;
+        generator.getThreadPool().parallelFor(size, [&](uint32_t y, uint32_t) {
+            const double *above = image.row(y > 0 ? y - 1 : y);
+            const double *row = image.row(y);
+            const double *below = image.row(y + 1 < size ? y + 1 : y);
+
+            for (uint32_t x = 0; x < size; ++x)
+            {
+                const size_t index = static_cast<size_t>(y) * size + x;
+                dxs[index] = (row[x + 1 < size ? x + 1 : x] - row[x > 0 ? x - 1 : x]) * scale;
+                dys[index] = (below[x] - above[x]) * scale;
+            }
+        });
+    };
+
+    const std::vector<std::pair<const char *, std::function<void()>>> cases{
+      {"generate", [&] { generator.generate(); }},
+      {"generate+finiteDifferences", finiteDifferences},
+      {"generateDerivatives", [&] { generator.generateDerivatives(); }},
+    };
+
+    for (const auto &[method, func] : cases)
+    {
+        std::cerr << "derivatives " << size << 'x' << size << ' ' << method << '\n';
+
+        results.push_back({"derivatives",
+                           "\"width\": " + std::to_string(size) + ", \"height\": " + std::to_string(size)
+                             + ", \"method\": \"" + method + '"',
+                           "Mpixels/s", measure(settings, func, [&](double seconds) { return megapixels / seconds; })});
+    }
+}
+
+void benchmarkPipeline(const BenchmarkSettings &settings, std::vector<Result> &results)
+{
+    const uint32_t size = settings.bQuick ? 1024 : 2048;
+    const auto megapixels = static_cast<double>(size) * size / 1e6;
+
+    // The fused graph against its two fields rendered by their own passes, then combined in a third one
+    const auto makeGenerator = [&](const std::string &pipeline) {
+        auto generatorSettings = makeSettings(size, 8, 0);
+        generatorSettings.normalization = noisegen::Normalization::Analytic;
+        generatorSettings.pipeline = pipeline;
+        return std::make_unique<noisegen::Generator>(generatorSettings);
+    };
+    const auto fused = makeGenerator("0.7 * ridged(octaves=6) + 0.3 * warp(fbm(), amount=0.2)");
+    const auto ridged = makeGenerator("ridged(octaves=6)");
+    const auto warped = makeGenerator("warp(fbm(), amount=0.2)");
+
+    std::vector<double> combined(static_cast<size_t>(size) * size);
+    const auto separatePasses = [&] {
+        ridged->generate();
+        warped->generate();
+
+        ridged->getThreadPool().parallelFor(size, [&](uint32_t y, uint32_t) {
+            const double *a = ridged->getImage().row(y);
+            const double *b = warped->getImage().row(y);
+            double *out = combined.data() + static_cast<size_t>(y) * size;
+
+            for (uint32_t x = 0; x < size; ++x)
+                out[x] = 0.7 * a[x] + 0.3 * b[x];
+        });
+    };
+
+    const std::vector<std::pair<const char *, std::function<void()>>> cases{
+      {"separate passes", separatePasses},
+      {"fused", [&] { fused->generate(); }},
+    };
+
+    for (const auto &[method, func] : cases)
+    {
+        std::cerr << "pipeline " << size << 'x' << size << ' ' << method << '\n';
+
+        results.push_back({"pipeline",
+                           "\"width\": " + std::to_string(size) + ", \"height\": " + std::to_string(size)
+                             + ", \"method\": \"" + method + '"',
+                           "Mpixels/s", measure(settings, func, [&](double seconds) { return megapixels / seconds; })});
+    }
+}
+
+void benchmarkPyramid(const BenchmarkSettings &settings, std::vector<Result> &results)
+{
+    const uint32_t size = settings.bQuick ? 1024 : 2048;
+    const auto megapixels = static_cast<double>(size) * size / 1e6;
+
+    auto generatorSettings = makeSettings(size, 8, 0);
+    generatorSettings.normalization = noisegen::Normalization::Analytic;
+    noisegen::Generator generator{generatorSettings};
+
+    // What the pyramid replaces: the full image, then every level box-filtered from the previous one
+    std::vector<noisegen::NoiseImage> levels{};
+    const auto downsample = [&] {
+        generator.generate();
+
+        levels.clear();
+        levels.reserve(noisegen::Generator::pyramidLevelCount(size, size));  // previous stays valid
+        const noisegen::NoiseImage *previous = &generator.getImage();
+        while (previous->width() > 1 || previous->height() > 1)
+        {
+            const uint32_t width = previous->width() / 2 + previous->width() % 2;
+            const uint32_t height = previous->height() / 2 + previous->height() % 2;
+            auto &level = levels.emplace_back(width, height);
+
+            generator.getThreadPool().parallelFor(height, [&](uint32_t y, uint32_t) {
+                const double *above = previous->row(2 * y);
+                const double *below = previous->row(std::min(2 * y + 1, previous->height() - 1));
+
+                for (uint32_t x = 0; x < width; ++x)
+                {
+                    const uint32_t right = std::min(2 * x + 1, previous->width() - 1);
+                    level.row(y)[x] = (above[2 * x] + above[right] + below[2 * x] + below[right]) * 0.25;
+                }
+            });
+            previous = &level;
+        }
+    };
+
+    const std::vector<std::pair<const char *, std::function<void()>>> cases{
+      {"generate+downsample", downsample},
+      {"generatePyramid", [&] { generator.generatePyramid(); }},
+    };
+
+    for (const auto &[method, func] : cases)
+    {
+        std::cerr << "pyramid " << size << 'x' << size << ' ' << method << '\n';
+
+        results.push_back({"pyramid",
+                           "\"width\": " + std::to_string(size) + ", \"height\": " + std::to_string(size)
+                             + ", \"method\": \"" + method + '"',
+                           "Mpixels/s", measure(settings, func, [&](double seconds) { return megapixels / seconds; })});
+    }
+}
+
+void benchmarkProgressive(const BenchmarkSettings &settings, std::vector<Result> &results)
+{
+    const uint32_t size = settings.bQuick ? 1024 : 2048;
+    const std::string parameters = "\"width\": " + std::to_string(size) + ", \"height\": " + std::to_string(size);
+    const auto toMilliseconds = [](double seconds) { return seconds * 1e3; };
+
+    noisegen::Generator generator{makeSettings(size, 12, 0)};
+
+    // Latency of the first preview (generateProgressive()'s default minimum size), the full render being the baseline
+    std::vector<double> previewLatencies{};
+    Clock::time_point start{};
+    uint32_t runCount = 0;
+    const auto progressive = [&] {
+        // The first calls of measure() are its warm-up runs, their latencies are left out
+        bool bPreviewed = runCount++ < settings.warmup;
+        start = Clock::now();
+        generator.generateProgressive([&](const noisegen::Generator::ProgressiveStage &) {
+            if (!bPreviewed)
+            {
+                const DurationSeconds latency = Clock::now() - start;
+                previewLatencies.push_back(latency.count() * 1e3);
+                bPreviewed = true;
+            }
+        });
+    };
+
+    std::cerr << "progressive " << size << 'x' << size << '\n';
+
+    results.push_back({"progressive", parameters + ", \"method\": \"generate\"", "ms",
+                       measure(settings, [&] { generator.generate(); }, toMilliseconds)});
+    results.push_back({"progressive", parameters + ", \"method\": \"generateProgressive\"", "ms",
+                       measure(settings, progressive, toMilliseconds)});
+
+    results.push_back({"progressive", parameters + ", \"method\": \"first preview\"", "ms",
+                       computeStatistics(std::move(previewLatencies))});
+}
+
+void benchmarkSave(const BenchmarkSettings &settings, std::vector<Result> &results)
+{
+    const uint32_t size = settings.bQuick ? 1024 : 2048;
+
+    for (const auto format : {noisegen::ImageFormat::PGMAscii, noisegen::ImageFormat::PGMBinary8,
+                              noisegen::ImageFormat::PGMBinary16, noisegen::ImageFormat::PNG8,
+                              noisegen::ImageFormat::PNG16})
+    {
+        std::cerr << "saveToPGM " << noisegen::toString(format) << '\n';
+
+        auto generatorSettings = makeSettings(size, 8, 0);
+        generatorSettings.format = format;
+        generatorSettings.outputFile = settings.scratchFile;
+
+        noisegen::Generator generator{generatorSettings};
+        generator.generate();
+        generator.saveToPGM();
+
+        std::ifstream file{settings.scratchFile, std::ios::binary | std::ios::ate};
+        auto megabytes = static_cast<double>(file.tellg()) / 1e6;
+        file.close();
+
+        // PNG: samples encoded rather than the compressed size, comparable with p5 and p5-16
+        if (noisegen::isPNGFormat(format))
+            megabytes = static_cast<double>(size) * size * (noisegen::is16BitFormat(format) ? 2 : 1) / 1e6;
+
+        results.push_back({"saveToPGM",
+                           "\"width\": " + std::to_string(size) + ", \"height\": " + std::to_string(size)
+                             + ", \"format\": \"" + noisegen::toString(format) + '"',
+                           "MB/s",
+                           measure(
+                             settings, [&] { generator.saveToPGM(); },
+                             [&](double seconds) { return megabytes / seconds; })});
+    }
+
+    std::remove(settings.scratchFile.c_str());
+}
+
+void benchmarkViewport(const BenchmarkSettings &settings, std::vector<Result> &results)
+{
+    constexpr uint32_t Width = 1280;
+    constexpr uint32_t Height = 720;
+    constexpr int64_t PanStep = 24;  // Samples per frame, a new column of tiles every few frames
+    constexpr int32_t Zoom = 2;
+
+    const noisegen::Generator generator{makeSettings(Width, 8, 0)};
+    const double scale = std::ldexp(1.0 / 256, -Zoom);
+    const auto megapixels = static_cast<double>(Width) * Height / 1e6;
+    noisegen::Generator::Image image{};
+
+    for (const bool bCached : {false, true})
+    {
+        std::cerr << "viewport " << Width << 'x' << Height << " cached=" << bCached << '\n';
+
+        noisegen::TileCache cache{uint64_t{256} << 20U};
+        int64_t x = 0;
+
+        const auto frame = [&] {
+            if (bCached)
+                cache.renderViewport(generator, Zoom, x, 0, Width, Height, image);
+            else
+                generator.generateRegion(static_cast<double>(x) * scale, 0.0, scale, Width, Height, image);
+            x += PanStep;
+        };
+
+        results.push_back({"viewport",
+                           "\"width\": " + std::to_string(Width) + ", \"height\": " + std::to_string(Height)
+                             + ", \"pan\": " + std::to_string(PanStep)
+                             + ", \"cached\": " + (bCached ? "true" : "false"),
+                           "Mpixels/s",
+                           measure(settings, frame, [&](double seconds) { return megapixels / seconds; })});
+    }
+}
+
+void benchmarkMapToPGM(const BenchmarkSettings &settings, std::vector<Result> &results)
+{
+    const uint32_t size = settings.bQuick ? 1024 : 4096;
+    const auto megapixels = static_cast<double>(size) * size / 1e6;
+
+    for (const auto format : {noisegen::ImageFormat::PGMBinary8, noisegen::ImageFormat::PGMBinary16})
+    {
+        auto generatorSettings = makeSettings(size, 8, 0);
+        generatorSettings.format = format;
+        generatorSettings.normalization = noisegen::Normalization::Analytic;
+        generatorSettings.outputFile = settings.scratchFile;
+
+        noisegen::Generator generator{generatorSettings};
+
+        const std::vector<std::pair<const char *, std::function<void()>>> cases{
+          {"generate+saveToPGM",
+           [&] {
+               generator.generate();
+               generator.saveToPGM();
+           }},
+          {"mapToPGM", [&] { generator.mapToPGM(); }},
+        };
+
+        for (const auto &[method, func] : cases)
+        {
+            std::cerr << method << ' ' << size << 'x' << size << ' ' << noisegen::toString(format) << '\n';
+
+            results.push_back({"writeImage",
+                               "\"width\": " + std::to_string(size) + ", \"height\": " + std::to_string(size)
+                                 + ", \"format\": \"" + noisegen::toString(format) + "\", \"method\": \"" + method
+                                 + '"',
+                               "Mpixels/s",
+                               measure(settings, func, [&](double seconds) { return megapixels / seconds; })});
+        }
+    }
+
+    std::remove(settings.scratchFile.c_str());
+}
+
+void writeJson(std::ostream &os, const BenchmarkSettings &settings, const std::vector<Result> &results)
+{
+    os << "{\n"
+       << "  \"instructionSet\": \"" << noisegen::simd::toString(noisegen::simd::activeInstructionSet()) << "\",\n"
+       << "  \"hardwareThreads\": " << std::thread::hardware_concurrency() << ",\n"
+       << "  \"warmup\": " << settings.warmup << ",\n"
+       << "  \"repetitions\": " << settings.repetitions << ",\n"
+       << "  \"results\": [\n";
+
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const auto &[name, parameters, unit, statistics] = results[i];
+
+        os << "    {\"name\": \"" << name << "\", " << parameters << ", \"unit\": \"" << unit << "\""
+           << ", \"min\": " << statistics.min << ", \"median\": " << statistics.median
+           << ", \"mean\": " << statistics.mean << ", \"stddev\": " << statistics.stddev
+           << ", \"max\": " << statistics.max << '}' << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+
+    os << "  ]\n}\n";
+}
+
+BenchmarkSettings parseArguments(int argc, const char *const *const argv)
+{
+    BenchmarkSettings settings{};
+
+    constexpr auto strToUInt32 = [](const std::string &value) { return static_cast<uint32_t>(std::stoul(value)); };
+
+    argparse::ArgumentParser program{argv[0]};
+
+    program
+      .add_argument("-w", "--warmup")               //
+      .help("untimed iterations before measuring")  //
+      .default_value(settings.warmup)               //
+      .action(strToUInt32);
+    program
+      .add_argument("-r", "--repetitions")  //
+      .help("timed iterations per case")    //
+      .default_value(settings.repetitions)  //
+      .action(strToUInt32);
+    program
+      .add_argument("-q", "--quick")                    //
+      .help("fewer and smaller cases, for CI runs")  //
+      .default_value(settings.bQuick)                   //
+      .implicit_value(true);
+    program
+      .add_argument("-o", "--output")                 //
+      .help("JSON output file, stdout by default")  //
+      .default_value(settings.outputFile);
+    program
+      .add_argument("--scratch-file")                 //
+      .help("temporary file used by saveToPGM cases")  //
+      .default_value(settings.scratchFile);
+
+    program.parse_args(argc, argv);
+
+    settings.warmup = program.get<uint32_t>("--warmup");
+    settings.repetitions = std::max(program.get<uint32_t>("--repetitions"), 1U);
+    settings.bQuick = program.get<bool>("--quick");
+    settings.outputFile = program.get<std::string>("--output");
+    settings.scratchFile = program.get<std::string>("--scratch-file");
+
+    return settings;
+}
+}  // namespace
+
+int main(int argc, const char *const *const argv)
+{
+    BenchmarkSettings settings{};
+
+    try
+    {
+        settings = parseArguments(argc, argv);
+    } catch (const std::exception &e)
+    {
+        std::cerr << "error: " << e.what() << '\n';
+        return 1;
+    }
+
+    std::vector<Result> results{};
+
+    benchmarkKernels(settings, results);
+    benchmarkGenerate(settings, results);
+    benchmarkGenerateInto(settings, results);
+    benchmarkDerivatives(settings, results);
+    benchmarkPipeline(settings, results);
+    benchmarkPyramid(settings, results);
+    benchmarkProgressive(settings, results);
+    benchmarkSave(settings, results);
+    benchmarkMapToPGM(settings, results);
+    benchmarkViewport(settings, results);
+
+    if (settings.outputFile.empty())
+        writeJson(std::cout, settings, results);
+    else
+    {
+        std::ofstream file{settings.outputFile};
+        writeJson(file, settings, results);
+    }
+
+    return 0;
+}
@@ -0,0 +1,121 @@
+/*
+**   Copyright 2021 Maxime Rayé
+**
+**   Licensed under the Apache License, Version 2.0 (the "License");
+**   you may not use this file except in compliance with the License.
+**   You may obtain a copy of the License at
+**
+**       http://www.apache.org/licenses/LICENSE-2.0
+**
+**   Unless required by applicable law or agreed to in writing, software
+**   distributed under the License is distributed on an "AS IS" BASIS,
+**   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**   See the License for the specific language governing permissions and
+**   limitations under the License.
+*/
+
+#include "Client.hpp"
+
+#ifndef _WIN32
+
+    #include <cerrno>
+    #include <vector>
+    #include <cstdlib>
+    #include <cstring>
+    #include <algorithm>
+    #include <stdexcept>
+
+    #include <unistd.h>
+    #include <sys/un.h>
+    #include <sys/socket.h>
+
+    #include <noisegen/Exception.hpp>
+
+Client::Client(const std::string &socketPath)
+{
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path))
+        throw noisegen::Exception{"socket path too long: " + socketPath};
+    std::copy(socketPath.cbegin(), socketPath.cend(), address.sun_path);
+
+    m_socket = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (m_socket < 0 || ::connect(m_socket, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0)
+    {
+        const std::string error = std::strerror(errno);
+        if (m_socket >= 0)
+            ::close(m_socket);
+        throw noisegen::Exception{"can't connect to " + socketPath + ": " + error};
+    }
+}
+
+Client::~Client()
+{
+    ::close(m_socket);
+}
+
+Client::Response Client::request(const std::string &line)
+{
+    const std::string data = line + '\n';
+    for (size_t written = 0; written < data.size();)
+    {
+        const ssize_t n = ::write(m_socket, data.data() + written, data.size() - written);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            throw noisegen::Exception{std::string{"can't send the request: "} + std::strerror(errno)};
+        written += static_cast<size_t>(n);
+    }
+
+    Response response{};
+
+    size_t end = 0;
+    while ((end = m_buffer.find('\n')) == std::string::npos)
+        read(m_buffer.size() + 1);
+    response.header = m_buffer.substr(0, end);
+    m_buffer.erase(0, end + 1);
+
+    try
+    {
+        response.members = JsonParser{response.header}.parseObject();
+    } catch (const std::invalid_argument &e)
+    {
+        throw noisegen::Exception{"invalid response: " + std::string{e.what()}};
+    }
+
+    // Errors have no bytes, images written to a file on the server side have 0
+    if (const auto bytes = response.members.find("bytes"); bytes != response.members.end())
+    {
+        const std::string &raw = bytes->second.raw;
+        if (raw.empty() || raw.find_first_not_of("0123456789") != std::string::npos)
+            throw noisegen::Exception{"invalid response: bytes must be an unsigned integer"};
+
+        const auto size = static_cast<size_t>(std::strtoull(raw.c_str(), nullptr, 10));
+        read(size);
+        response.payload = m_buffer.substr(0, size);
+        m_buffer.erase(0, size);
+    }
+    return response;
+}
+
+/**
+ * Receive until m_buffer holds at least size bytes
+ */
+void Client::read(size_t size)
+{
+    std::vector<char> chunk(size_t{64} << 10U);
+
+    while (m_buffer.size() < size)
+    {
+        const ssize_t n = ::read(m_socket, chunk.data(), chunk.size());
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0)
+            throw noisegen::Exception{std::string{"can't receive the response: "} + std::strerror(errno)};
+        if (n == 0)
+            throw noisegen::Exception{"connection closed by the server"};
+        m_buffer.append(chunk.data(), static_cast<size_t>(n));
+    }
+}
+
+#endif
@@ -0,0 +1,56 @@
+/*
+**   Copyright 2021 Maxime Rayé
+**
+**   Licensed under the Apache License, Version 2.0 (the "License");
+**   you may not use this file except in compliance with the License.
+**   You may obtain a copy of the License at
+**
+**       http://www.apache.org/licenses/LICENSE-2.0
+**
+**   Unless required by applicable law or agreed to in writing, software
+**   distributed under the License is distributed on an "AS IS" BASIS,
+**   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**   See the License for the specific language governing permissions and
+**   limitations under the License.
+*/
+
+#pragma once
+
+#include <map>
+#include <string>
+
+#include "Json.hpp"
+
+/**
+ * `noisegencli request`: a client of `noisegencli serve` (see Server.hpp), one connection on which requests are
+ * answered in order. Throws noisegen::Exception when the socket fails.
+ */
+class Client final
+{
+public:
+    struct Response
+    {
+        std::string header{};                       // response line, without the newline
+        std::map<std::string, JsonValue> members{};  // of the header
+        std::string payload{};                      // image bytes, empty unless the image was sent back on the socket
+    };
+
+    explicit Client(const std::string &socketPath);
+    ~Client();
+
+    Client(Client &&) = delete;
+    Client(const Client &) = delete;
+    Client &operator=(Client &&) = delete;
+    Client &operator=(const Client &) = delete;
+
+    /**
+     * Send one request line and wait for its response
+     */
+    Response request(const std::string &line);
+
+private:
+    int m_socket{-1};
+    std::string m_buffer{};  // bytes received past the last response
+
+    void read(size_t size);
+};
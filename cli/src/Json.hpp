@@ -0,0 +1,225 @@
+/*
+**   Copyright 2021 Maxime Rayé
+**
+**   Licensed under the Apache License, Version 2.0 (the "License");
+**   you may not use this file except in compliance with the License.
+**   You may obtain a copy of the License at
+**
+**       http://www.apache.org/licenses/LICENSE-2.0
+**
+**   Unless required by applicable law or agreed to in writing, software
+**   distributed under the License is distributed on an "AS IS" BASIS,
+**   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**   See the License for the specific language governing permissions and
+**   limitations under the License.
+*/
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+/**
+ * Value of an object member, the protocol only needs flat objects
+ */
+struct JsonValue
+{
+    std::string raw{};             // source text, echoed back for "id"
+    std::string string{};          // unescaped content of strings
+    std::vector<double> numbers{};  // content of arrays of numbers
+    bool bString{false};
+};
+
+/**
+ * Parser for one line of the protocol of `noisegencli serve` (requests and responses): an object whose values are
+ * strings, numbers, booleans, null or arrays of numbers. Throws std::invalid_argument on anything else.
+ */
+class JsonParser final
+{
+public:
+    explicit JsonParser(const std::string &text) : m_text{text} {}
+
+    std::map<std::string, JsonValue> parseObject()
+    {
+        std::map<std::string, JsonValue> members{};
+
+        expect('{');
+        if (peek() == '}')
+            ++m_position;
+        else
+        {
+            do
+            {
+                std::string key = parseString();
+                expect(':');
+                members[std::move(key)] = parseValue();
+            } while (accept(','));
+            expect('}');
+        }
+
+        if (peek() != '\0')
+            throw std::invalid_argument{"trailing characters after the object"};
+        return members;
+    }
+
+private:
+    const std::string &m_text;
+    size_t m_position{0};
+
+    char peek()
+    {
+        while (m_position < m_text.size() && std::strchr(" \t\r\n", m_text[m_position]) != nullptr)
+            ++m_position;
+        return m_position < m_text.size() ? m_text[m_position] : '\0';
+    }
+
+    bool accept(char c)
+    {
+        if (peek() != c)
+            return false;
+        ++m_position;
+        return true;
+    }
+
+    void expect(char c)
+    {
+        if (!accept(c))
+            throw std::invalid_argument{std::string{"expected '"} + c + "' at offset " + std::to_string(m_position)};
+    }
+
+    std::string parseString()
+    {
+        expect('"');
+
+        std::string out{};
+        while (m_position < m_text.size() && m_text[m_position] != '"')
+        {
+            char c = m_text[m_position++];
+            if (c == '\\')
+            {
+                if (m_position >= m_text.size())
+                    break;
+
+                switch (c = m_text[m_position++])
+                {
+                case 'b': c = '\b'; break;
+                case 'f': c = '\f'; break;
+                case 'n': c = '\n'; break;
+                case 'r': c = '\r'; break;
+                case 't': c = '\t'; break;
+                case 'u': throw std::invalid_argument{"\\u escapes are not supported"};
+                default: break;  // '"', '\\' and '/' stand for themselves
+                }
+            }
+            out += c;
+        }
+        expect('"');
+        return out;
+    }
+
+    JsonValue parseValue()
+    {
+        JsonValue value{};
+        const size_t start = m_position;
+
+        if (peek() == '"')
+        {
+            value.string = parseString();
+            value.bString = true;
+        } else if (accept('['))
+        {
+            if (!accept(']'))
+            {
+                do
+                    value.numbers.push_back(std::stod(parseToken()));
+                while (accept(','));
+                expect(']');
+            }
+        } else
+            parseToken();
+
+        value.raw = m_text.substr(start, m_position - start);
+        value.raw.erase(0, value.raw.find_first_not_of(" \t"));
+        return value;
+    }
+
+    /**
+     * Number, true, false or null
+     */
+    std::string parseToken()
+    {
+        peek();
+        const size_t start = m_position;
+        while (m_position < m_text.size() && std::strchr("+-.0123456789eEtrufalsn", m_text[m_position]) != nullptr)
+            ++m_position;
+
+        std::string token = m_text.substr(start, m_position - start);
+        if (token == "true" || token == "false" || token == "null")
+            return token;
+
+        // Numbers are echoed back, e.g. as the request id: strtod() alone would accept "+1", ".5", "01" or "1e999"
+        if (!isNumber(token) || !std::isfinite(std::strtod(token.c_str(), nullptr)))
+            throw std::invalid_argument{"unexpected value at offset " + std::to_string(start)};
+        return token;
+    }
+
+    /**
+     * Number grammar of RFC 8259: -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+     */
+    static bool isNumber(const std::string &token) noexcept
+    {
+        size_t i = 0;
+        const auto digits = [&token, &i]() {
+            const size_t first = i;
+            while (i < token.size() && token[i] >= '0' && token[i] <= '9')
+                ++i;
+            return i - first;
+        };
+
+        if (i < token.size() && token[i] == '-')
+            ++i;
+        if (i < token.size() && token[i] == '0')
+            ++i;
+        else if (digits() == 0)
+            return false;
+
+        if (i < token.size() && token[i] == '.')
+        {
+            ++i;
+            if (digits() == 0)
+                return false;
+        }
+
+        if (i < token.size() && (token[i] == 'e' || token[i] == 'E'))
+        {
+            ++i;
+            if (i < token.size() && (token[i] == '+' || token[i] == '-'))
+                ++i;
+            if (digits() == 0)
+                return false;
+        }
+        return i == token.size();
+    }
+};
+
+/**
+ * Escape text for a JSON string, control characters become spaces
+ */
+inline std::string escapeJson(const std::string &text)
+{
+    std::string out{};
+    out.reserve(text.size());
+
+    for (const char c : text)
+    {
+        if (c == '"' || c == '\\')
+            out += '\\';
+        out += static_cast<unsigned char>(c) < 0x20 ? ' ' : c;
+    }
+    return out;
+}
@@ -14,13 +14,28 @@
 **   limitations under the License.
 */
 
+#include <tuple>
+#include <future>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <iostream>
+#include <string_view>
+#include <stdexcept>
+
 #include <argparse.hpp>
 
 #include <noisegen/Generator.hpp>
 #include <noisegen/Settings.hpp>
+#include <noisegen/PGMWriter.hpp>
 #include <noisegen/ScopedProfiler.hpp>
 #include <noisegen/Exception.hpp>
 
+#include "Client.hpp"
+#include "Parsing.hpp"
+#include "Server.hpp"
+
 static noisegen::Settings parseArguments(int argc, const char *const *const argv)
 {
     NOISEGEN_SCOPED_PROFILER("parseArguments()");
@@ -56,16 +71,87 @@ static noisegen::Settings parseArguments(int argc, const char *const *const argv
       .help("noise persistence")            //
       .default_value(settings.persistence)  //
       .action(strToDouble);
+    program
+      .add_argument("--pipeline")                                                                    //
+      .help("noise graph replacing the octave sum, e.g. \"ridged(octaves=6) + 0.3 * warp(fbm())\"")  //
+      .default_value(settings.pipeline);
+    program
+      .add_argument("--pipeline-file")                     //
+      .help("read the --pipeline expression from a file")  //
+      .default_value(std::string{});
     program
       .add_argument("-n", "--count")  //
       .help("generate N images")      //
       .default_value(settings.count)  //
       .action(strToUInt32);
     program
-      .add_argument("-k", "--kenperlin")                                     //
-      .help("use Ken Perlin's permutation array instead of a shuffled one")  //
-      .default_value(settings.bUseKenPerlinPermutations)                     //
+      .add_argument("-t", "--threads")                      //
+      .help("worker threads, 0 for one per hardware thread")  //
+      .default_value(settings.threads)                        //
+      .action(strToUInt32);
+    program
+      .add_argument("-f", "--format")                                                                             //
+      .help("output format: p5 or p5-16 (binary PGM), p2 (ASCII PGM), png or png-16, raw or raw-16 (no header)")  //
+      .default_value(std::string{noisegen::toString(settings.format)});
+    program
+      .add_argument("--depth", "--frames")                                                                      //
+      .help("render N z slices (a volume or the frames of an animation), numbered files or a single raw file")  //
+      .default_value(settings.depth)                                                                            //
+      .action(strToUInt32);
+    program
+      .add_argument("--dz")                                                //
+      .help("z distance between slices, 0 for the distance between rows")  //
+      .default_value(settings.sliceSpacing)                                //
+      .action(strToDouble);
+    program
+      .add_argument("--basis")                                                       //
+      .help("noise basis: perlin (2^n corners) or simplex (n + 1 corners, faster)")  //
+      .default_value(std::string{noisegen::toString(settings.basis)});
+    program
+      .add_argument("--precision")                                          //
+      .help("sample precision: float (faster, half the memory) or double")  //
+      .default_value(std::string{noisegen::toString(settings.precision)});
+    program
+      .add_argument("--max-memory")                                                 //
+      .help("render in bands using at most this much sample memory (e.g. 512M, 2G)")  //
+      .default_value(std::string{"0"});
+    program
+      .add_argument("--range")                                                          //
+      .help("normalize with a fixed MIN,MAX range instead of the image min/max pass")  //
+      .default_value(std::string{});
+    program
+      .add_argument("--analytic-range")                                                    //
+      .help("normalize with the theoretical range of the octave sum, no min/max pass")  //
+      .default_value(false)                                                               //
+      .implicit_value(true);
+    program
+      .add_argument("-k", "--kenperlin")                                                      //
+      .help("use Ken Perlin's permutation array instead of a shuffled one, not with --seed")  //
+      .default_value(settings.bUseKenPerlinPermutations)                                      //
+      .implicit_value(true);
+    program
+      .add_argument("-s", "--seed")                                                                     //
+      .help("derive the permutations from this seed, image k of --count uses seed + k (reproducible)")  //
+      .default_value(std::string{});
+    program
+      .add_argument("--pyramid")                                                                        //
+      .help("also render the LOD levels down to 1x1, each with only the octaves it resolves (planar)")  //
+      .default_value(settings.bPyramid)                                                                 //
+      .implicit_value(true);
+    program
+      .add_argument("--mmap")                                                                     //
+      .help("render binary formats straight into the memory-mapped output file, no write phase")  //
+      .default_value(settings.bMemoryMap)                                                         //
       .implicit_value(true);
+    program
+      .add_argument("--normal-map")                                                              //
+      .help("also write the normal map to this binary PPM, from analytic derivatives (planar)")  //
+      .default_value(settings.normalMapFile);
+    program
+      .add_argument("--normal-strength")                                 //
+      .help("height of the normalized range in pixels, for --normal-map")  //
+      .default_value(settings.normalStrength)                              //
+      .action(strToDouble);
     program
       .add_argument("-d", "--dry-run")       //
       .help("don't write anything to disk")  //
@@ -92,17 +178,266 @@ static noisegen::Settings parseArguments(int argc, const char *const *const argv
     settings.octaves = program.get<uint32_t>("--octaves");
     settings.persistence = program.get<double>("--persistence");
     settings.outputFile = program.get<std::string>("--output");
+    settings.normalMapFile = program.get<std::string>("--normal-map");
+    settings.normalStrength = program.get<double>("--normal-strength");
     settings.count = program.get<uint32_t>("--count");
+    settings.depth = program.get<uint32_t>("--depth");
+    settings.sliceSpacing = program.get<double>("--dz");
+    settings.threads = program.get<uint32_t>("--threads");
     settings.bDryRun = program.get<bool>("--dry-run");
+    settings.bPyramid = program.get<bool>("--pyramid");
+    settings.bMemoryMap = program.get<bool>("--mmap");
     settings.bUseKenPerlinPermutations = program.get<bool>("--kenperlin");
 
+    try
+    {
+        settings.format = parseImageFormat(program.get<std::string>("--format"));
+        settings.basis = parseBasis(program.get<std::string>("--basis"));
+        settings.precision = parsePrecision(program.get<std::string>("--precision"));
+        settings.maxMemory = parseByteSize(program.get<std::string>("--max-memory"));
+
+        if (const auto seed = program.get<std::string>("--seed"); !seed.empty())
+            settings.seed = parseSeed(seed);
+
+        if (program.get<bool>("--analytic-range"))
+            settings.normalization = noisegen::Normalization::Analytic;
+        if (const auto range = program.get<std::string>("--range"); !range.empty())
+        {
+            std::tie(settings.rangeMin, settings.rangeMax) = parseRange(range);
+            settings.normalization = noisegen::Normalization::Fixed;
+        }
+        if (const auto pipeline = program.get<std::string>("--pipeline"); !pipeline.empty())
+            settings.pipeline = parsePipeline(pipeline);
+        if (const auto pipelineFile = program.get<std::string>("--pipeline-file"); !pipelineFile.empty())
+            settings.pipeline = readPipelineFile(pipelineFile);
+
+        if (settings.bUseKenPerlinPermutations && settings.seed.has_value())
+            throw std::invalid_argument{"--kenperlin and --seed both choose the permutations, pass only one"};
+        if (!settings.normalMapFile.empty() && settings.depth > 1)
+            throw std::invalid_argument{"--normal-map needs a planar image, not --depth"};
+        if (!settings.normalMapFile.empty() && !settings.pipeline.empty())
+            throw std::invalid_argument{"--normal-map needs the octave sum, not a --pipeline"};
+        if (settings.bPyramid && (settings.depth > 1 || !settings.pipeline.empty() || !settings.normalMapFile.empty()))
+            throw std::invalid_argument{"--pyramid needs a planar image of the octave sum, without --normal-map"};
+    } catch (const std::logic_error &e)
+    {
+        std::cerr << program;
+        std::cerr << "\nerror: invalid argument: " << e.what() << '\n';
+        throw noisegen::ArgumentParseException{};
+    }
+
     return settings;
 }
 
+/**
+ * Generate settings.count images, each one with its own permutations (derived from settings.seed + index if set).
+ * Image k is written to disk by another thread while image k + 1 is being generated.
+ */
+template<typename Real>
+static void generateImages(const noisegen::Settings &settings)
+{
+    NOISEGEN_SCOPED_PROFILER("generateImages()");
+
+    std::future<void> pendingWrite{};
+
+    for (uint32_t index = 0; index < settings.count; ++index)
+    {
+        noisegen::Settings imageSettings = settings;
+        imageSettings.outputFile = noisegen::numberedFileName(settings.outputFile, index, settings.count);
+        if (settings.seed.has_value())
+            imageSettings.seed = settings.seed.value() + index;
+        if (!settings.normalMapFile.empty())
+            imageSettings.normalMapFile = noisegen::numberedFileName(settings.normalMapFile, index, settings.count);
+
+        auto generator = std::make_unique<noisegen::BasicGenerator<Real>>(std::move(imageSettings));
+
+        if (settings.depth > 1)
+        {
+            // Volumes interleave generation and writing slice by slice, or band by band under --max-memory
+            generator->generateVolume();
+            continue;
+        }
+        if (!settings.normalMapFile.empty())
+        {
+            // The derivatives are rendered with the image, both are kept in memory
+            generator->generateDerivatives();
+            generator->saveToPGM();
+            generator->saveNormalMap();
+            continue;
+        }
+        if (settings.bPyramid)
+        {
+            // Every level is kept in memory, the finer ones reuse the coarser ones
+            generator->generatePyramid();
+            generator->savePyramid();
+            continue;
+        }
+        if (settings.bMemoryMap)
+        {
+            // Workers store the pixels in the file themselves, nothing is left to write
+            generator->mapToPGM();
+            continue;
+        }
+        if (!generator->fitsInMemory())
+        {
+            // Streaming already interleaves generation and writing, band by band
+            generator->streamToPGM();
+            continue;
+        }
+
+        generator->generate();
+
+        // At most one image waiting for the disk, bounds memory usage to two images
+        if (pendingWrite.valid())
+            pendingWrite.get();
+        pendingWrite = std::async(std::launch::async, [generator = std::move(generator)] { generator->saveToPGM(); });
+    }
+
+    if (pendingWrite.valid())
+        pendingWrite.get();
+}
+
+/**
+ * `noisegencli serve --socket PATH`, see Server.hpp
+ * @param argv arguments after "serve", argv[0] being "serve"
+ */
+static int serve(int argc, const char *const *const argv)
+{
+    constexpr auto strToUInt32 = [](const std::string &value) { return static_cast<uint32_t>(std::stoul(value)); };
+
+    argparse::ArgumentParser program{"noisegencli serve"};
+
+    program
+      .add_argument("--socket")                             //
+      .help("path of the Unix domain socket to listen on")  //
+      .required();
+    program
+      .add_argument("-t", "--threads")                        //
+      .help("render threads, 0 for one per hardware thread")  //
+      .default_value(0U)                                      //
+      .action(strToUInt32);
+    program
+      .add_argument("--output-dir")                                                            //
+      .help("directory the \"output\" paths of requests are relative to, refused without it")  //
+      .default_value(std::string{});
+
+    try
+    {
+        program.parse_args(argc, argv);
+    } catch (const std::exception &e)
+    {
+        std::cerr << program;
+        std::cerr << "\nerror: " << e.what() << '\n';
+        return 1;
+    }
+
+#ifdef _WIN32
+    std::cerr << "error: serve needs Unix domain sockets, not supported on Windows\n";
+    return 1;
+#else
+    try
+    {
+        Server server{program.get<std::string>("--socket"), program.get<uint32_t>("--threads"),
+                      program.get<std::string>("--output-dir")};
+        server.run();
+    } catch (const noisegen::Exception &e)
+    {
+        std::cerr << "error: " << e.what() << '\n';
+        return 1;
+    }
+    return 0;
+#endif
+}
+
+/**
+ * `noisegencli request --socket PATH`: send the request lines read on stdin to `noisegencli serve` and print the
+ * responses, a stand-in for real clients to exercise the protocol
+ * @param argv arguments after "request", argv[0] being "request"
+ * @return 1 if a request failed
+ */
+static int request(int argc, const char *const *const argv)
+{
+    argparse::ArgumentParser program{"noisegencli request"};
+
+    program
+      .add_argument("--socket")                  //
+      .help("path of the socket of the server")  //
+      .required();
+    program
+      .add_argument("--save")                                                                     //
+      .help("directory to write the images sent back into, as N.pgm, N.png or N.raw for line N")  //
+      .default_value(std::string{});
+
+    try
+    {
+        program.parse_args(argc, argv);
+    } catch (const std::exception &e)
+    {
+        std::cerr << program;
+        std::cerr << "\nerror: " << e.what() << '\n';
+        return 1;
+    }
+
+#ifdef _WIN32
+    std::cerr << "error: request needs Unix domain sockets, not supported on Windows\n";
+    return 1;
+#else
+    const auto saveDirectory = program.get<std::string>("--save");
+    int status = 0;
+
+    try
+    {
+        Client client{program.get<std::string>("--socket")};
+
+        std::string line{};
+        for (uint32_t lineNumber = 1; std::getline(std::cin, line); ++lineNumber)
+        {
+            if (line.find_first_not_of(" \t\r") == std::string::npos)
+                continue;
+
+            const auto response = client.request(line);
+            std::cout << response.header << '\n';
+
+            const auto responseStatus = response.members.find("status");
+            if (responseStatus == response.members.end() || responseStatus->second.string != "ok")
+                status = 1;
+            if (saveDirectory.empty() || response.payload.empty())
+                continue;
+
+            const auto responseFormat = response.members.find("format");
+            if (responseFormat == response.members.end())
+                throw noisegen::Exception{"invalid response: image without a format"};
+
+            const std::string &format = responseFormat->second.string;
+            std::string extension{"pgm"};
+            if (format.compare(0, 3, "png") == 0)
+                extension = "png";
+            else if (format.compare(0, 3, "raw") == 0)
+                extension = "raw";
+            const std::string path = saveDirectory + '/' + std::to_string(lineNumber) + '.' + extension;
+
+            std::ofstream file{path, std::ios::binary};
+            if (!file.write(response.payload.data(), static_cast<std::streamsize>(response.payload.size())))
+                throw noisegen::Exception{"can't write " + path};
+        }
+    } catch (const noisegen::Exception &e)
+    {
+        std::cerr << "error: " << e.what() << '\n';
+        return 1;
+    }
+    return status;
+#endif
+}
+
 int main(int argc, const char *const *const argv)
 {
     NOISEGEN_SCOPED_PROFILER("main()");
 
+    if (argc > 1 && std::string_view{argv[1]} == "serve")
+        return serve(argc - 1, argv + 1);
+    if (argc > 1 && std::string_view{argv[1]} == "request")
+        return request(argc - 1, argv + 1);
+
     noisegen::Settings settings;
 
     try
@@ -113,10 +448,17 @@ int main(int argc, const char *const *const argv)
         return 1;
     }
 
-    noisegen::Generator generator{settings};
-
-    generator.generate();
-    generator.saveToPGM();
+    try
+    {
+        if (settings.precision == noisegen::Precision::Float)
+            generateImages<float>(settings);
+        else
+            generateImages<double>(settings);
+    } catch (const noisegen::Exception &e)
+    {
+        std::cerr << "error: " << e.what() << '\n';
+        return 1;
+    }
 
     return 0;
 }
@@ -0,0 +1,173 @@
+/*
+**   Copyright 2021 Maxime Rayé
+**
+**   Licensed under the Apache License, Version 2.0 (the "License");
+**   you may not use this file except in compliance with the License.
+**   You may obtain a copy of the License at
+**
+**       http://www.apache.org/licenses/LICENSE-2.0
+**
+**   Unless required by applicable law or agreed to in writing, software
+**   distributed under the License is distributed on an "AS IS" BASIS,
+**   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**   See the License for the specific language governing permissions and
+**   limitations under the License.
+*/
+
+#include <cmath>
+#include <cctype>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+#include <noisegen/Pipeline.hpp>
+#include <noisegen/Exception.hpp>
+
+#include "Parsing.hpp"
+
+noisegen::ImageFormat parseImageFormat(const std::string &value)
+{
+    for (const auto format :
+         {noisegen::ImageFormat::PGMAscii, noisegen::ImageFormat::PGMBinary8, noisegen::ImageFormat::PGMBinary16,
+          noisegen::ImageFormat::Raw8, noisegen::ImageFormat::Raw16, noisegen::ImageFormat::PNG8,
+          noisegen::ImageFormat::PNG16})
+    {
+        if (value == noisegen::toString(format))
+            return format;
+    }
+    throw std::invalid_argument{"unknown format: " + value};
+}
+
+noisegen::Basis parseBasis(const std::string &value)
+{
+    for (const auto basis : {noisegen::Basis::Perlin, noisegen::Basis::Simplex})
+    {
+        if (value == noisegen::toString(basis))
+            return basis;
+    }
+    throw std::invalid_argument{"unknown basis: " + value};
+}
+
+noisegen::Precision parsePrecision(const std::string &value)
+{
+    for (const auto precision : {noisegen::Precision::Float, noisegen::Precision::Double})
+    {
+        if (value == noisegen::toString(precision))
+            return precision;
+    }
+    throw std::invalid_argument{"unknown precision: " + value};
+}
+
+noisegen::Normalization parseNormalization(const std::string &value)
+{
+    for (const auto normalization :
+         {noisegen::Normalization::MinMax, noisegen::Normalization::Fixed, noisegen::Normalization::Analytic})
+    {
+        if (value == noisegen::toString(normalization))
+            return normalization;
+    }
+    throw std::invalid_argument{"unknown normalization: " + value};
+}
+
+uint64_t parseByteSize(const std::string &value)
+{
+    // Same as parseSeed(): stoull() would accept " -1M" and wrap around
+    if (value.empty() || std::isdigit(static_cast<unsigned char>(value.front())) == 0)
+        throw std::invalid_argument{"invalid size: " + value};
+
+    size_t suffixPos{};
+    const uint64_t number = std::stoull(value, &suffixPos);
+    const std::string suffix = value.substr(suffixPos);
+    unsigned shift{};
+
+    if (suffix.empty() || suffix == "B")
+        shift = 0;
+    else if (suffix == "K" || suffix == "KiB")
+        shift = 10;
+    else if (suffix == "M" || suffix == "MiB")
+        shift = 20;
+    else if (suffix == "G" || suffix == "GiB")
+        shift = 30;
+    else if (suffix == "T" || suffix == "TiB")
+        shift = 40;
+    else
+        throw std::invalid_argument{"unknown size suffix: " + suffix};
+
+    if (number > (std::numeric_limits<uint64_t>::max() >> shift))
+        throw std::out_of_range{"size too large: " + value};
+    return number << shift;
+}
+
+uint64_t parseSeed(const std::string &value)
+{
+    // stoull() skips whitespace and accepts a sign, " -1" would wrap around
+    if (value.empty() || std::isdigit(static_cast<unsigned char>(value.front())) == 0)
+        throw std::invalid_argument{"invalid seed: " + value};
+
+    size_t end{};
+    uint64_t seed{};
+    try
+    {
+        seed = std::stoull(value, &end);
+    } catch (const std::out_of_range &)
+    {
+        throw std::invalid_argument{"seed out of range for 64 bits: " + value};
+    }
+
+    if (end != value.size())
+        throw std::invalid_argument{"invalid seed: " + value};
+    return seed;
+}
+
+std::pair<double, double> parseRange(const std::string &value)
+{
+    const auto comma = value.find(',');
+
+    if (comma == std::string::npos)
+        throw std::invalid_argument{"expected MIN,MAX range: " + value};
+
+    // stod() stops at the first invalid character and accepts inf, which the quantizers can't scale by
+    const auto bound = [&value](const std::string &text) {
+        size_t end{};
+        double number{};
+        try
+        {
+            number = std::stod(text, &end);
+        } catch (const std::logic_error &)
+        {
+            throw std::invalid_argument{"invalid range: " + value};
+        }
+        if (end != text.size() || !std::isfinite(number))
+            throw std::invalid_argument{"invalid range: " + value};
+        return number;
+    };
+
+    const auto range = std::make_pair(bound(value.substr(0, comma)), bound(value.substr(comma + 1)));
+
+    if (!(range.first < range.second))
+        throw std::invalid_argument{"empty range: " + value};
+    return range;
+}
+
+std::string parsePipeline(const std::string &value)
+{
+    try
+    {
+        static_cast<void>(noisegen::Pipeline::compile(value));
+    } catch (const noisegen::Exception &e)
+    {
+        throw std::invalid_argument{e.what()};
+    }
+    return value;
+}
+
+std::string readPipelineFile(const std::string &path)
+{
+    std::ifstream file{path};
+    std::ostringstream content{};
+
+    if (!(file && content << file.rdbuf()))
+        throw std::invalid_argument{"can't read the pipeline file " + path};
+    return parsePipeline(content.str());
+}
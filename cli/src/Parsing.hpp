@@ -0,0 +1,57 @@
+/*
+**   Copyright 2021 Maxime Rayé
+**
+**   Licensed under the Apache License, Version 2.0 (the "License");
+**   you may not use this file except in compliance with the License.
+**   You may obtain a copy of the License at
+**
+**       http://www.apache.org/licenses/LICENSE-2.0
+**
+**   Unless required by applicable law or agreed to in writing, software
+**   distributed under the License is distributed on an "AS IS" BASIS,
+**   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**   See the License for the specific language governing permissions and
+**   limitations under the License.
+*/
+
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <utility>
+
+#include <noisegen/Settings.hpp>
+
+/*
+ * Parsers of option values, shared by the command line and the requests of `noisegencli serve`.
+ * All of them throw std::invalid_argument (or std::out_of_range) on invalid values.
+ */
+
+/**
+ * Parse a name returned by noisegen::toString()
+ */
+[[nodiscard]] noisegen::ImageFormat parseImageFormat(const std::string &value);
+[[nodiscard]] noisegen::Basis parseBasis(const std::string &value);
+[[nodiscard]] noisegen::Precision parsePrecision(const std::string &value);
+[[nodiscard]] noisegen::Normalization parseNormalization(const std::string &value);
+/**
+ * Parse a byte size such as "4096", "512M" or "2G" (binary multiples)
+ */
+[[nodiscard]] uint64_t parseByteSize(const std::string &value);
+/**
+ * Parse a decimal seed, the whole string must be a non-negative number
+ */
+[[nodiscard]] uint64_t parseSeed(const std::string &value);
+/**
+ * Parse a "MIN,MAX" normalization range
+ */
+[[nodiscard]] std::pair<double, double> parseRange(const std::string &value);
+/**
+ * Check that a pipeline expression compiles (see noisegen/Pipeline.hpp)
+ * @return value
+ */
+[[nodiscard]] std::string parsePipeline(const std::string &value);
+/**
+ * parsePipeline() of the content of a file
+ */
+[[nodiscard]] std::string readPipelineFile(const std::string &path);
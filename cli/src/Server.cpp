@@ -0,0 +1,511 @@
+/*
+**   Copyright 2021 Maxime Rayé
+**
+**   Licensed under the Apache License, Version 2.0 (the "License");
+**   you may not use this file except in compliance with the License.
+**   You may obtain a copy of the License at
+**
+**       http://www.apache.org/licenses/LICENSE-2.0
+**
+**   Unless required by applicable law or agreed to in writing, software
+**   distributed under the License is distributed on an "AS IS" BASIS,
+**   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**   See the License for the specific language governing permissions and
+**   limitations under the License.
+*/
+
+#include "Server.hpp"
+
+#ifndef _WIN32
+
+    #include <map>
+    #include <cmath>
+    #include <cerrno>
+    #include <cctype>
+    #include <limits>
+    #include <csignal>
+    #include <cstdlib>
+    #include <cstring>
+    #include <fstream>
+    #include <sstream>
+    #include <iostream>
+    #include <algorithm>
+    #include <stdexcept>
+
+    #include <poll.h>
+    #include <unistd.h>
+    #include <sys/un.h>
+    #include <sys/stat.h>
+    #include <sys/socket.h>
+
+    #include <noisegen/Pipeline.hpp>
+    #include <noisegen/Generator.hpp>
+    #include <noisegen/PGMWriter.hpp>
+    #include <noisegen/Exception.hpp>
+    #include <noisegen/ScopedProfiler.hpp>
+
+    #include "Json.hpp"
+    #include "Parsing.hpp"
+
+namespace {
+constexpr size_t MaxLineSize = size_t{1} << 20U;
+constexpr uint64_t MaxPixels = uint64_t{1} << 28U;
+// Past 2^64 the octave frequencies are lost in double precision anyway. Also the budget of a pipeline, whose fractal
+// nodes add up their octaves.
+constexpr uint32_t MaxOctaves = 64;
+
+volatile std::sig_atomic_t s_bInterrupted = 0;
+
+void onSignal(int)
+{
+    s_bInterrupted = 1;
+}
+
+const std::string &stringMember(const std::string &key, const JsonValue &value)
+{
+    if (!value.bString)
+        throw std::invalid_argument{key + " must be a string"};
+    return value.string;
+}
+
+uint32_t uint32Member(const std::string &key, const JsonValue &value)
+{
+    const auto isDigit = [](char c) { return std::isdigit(static_cast<unsigned char>(c)) != 0; };
+    if (value.raw.empty() || !std::all_of(value.raw.begin(), value.raw.end(), isDigit))
+        throw std::invalid_argument{key + " must be an unsigned integer"};
+
+    // Saturates at ULLONG_MAX on overflow, which is out of range as well
+    const unsigned long long number = std::strtoull(value.raw.c_str(), nullptr, 10);
+    if (number > std::numeric_limits<uint32_t>::max())
+        throw std::invalid_argument{key + " is out of range"};
+    return static_cast<uint32_t>(number);
+}
+
+double doubleMember(const std::string &key, const JsonValue &value)
+{
+    // Strings keep their quotes in raw, arrays their brackets: only numbers are read entirely
+    char *end{};
+    const double number = std::strtod(value.raw.c_str(), &end);
+    if (value.raw.empty() || end != value.raw.c_str() + value.raw.size() || !std::isfinite(number))
+        throw std::invalid_argument{key + " must be a number"};
+    return number;
+}
+
+/**
+ * Octaves evaluated per pixel by all the fractal nodes of a pipeline
+ */
+uint64_t pipelineOctaves(const std::string &source)
+{
+    const auto pipeline = noisegen::Pipeline::compile(source);
+    uint64_t octaves = 0;
+
+    for (const auto &instruction : pipeline.getInstructions())
+    {
+        if (instruction.op == noisegen::Pipeline::Op::Fractal)
+            octaves += instruction.octaves;
+    }
+    return octaves;
+}
+
+bool boolMember(const std::string &key, const JsonValue &value)
+{
+    if (value.raw != "true" && value.raw != "false")
+        throw std::invalid_argument{key + " must be true or false"};
+    return value.raw == "true";
+}
+
+/**
+ * Resolve "output" inside the output directory: relative paths only, without ".." components
+ * @param outputDirectory empty if the server doesn't write files
+ */
+std::string outputPath(const std::string &outputDirectory, const std::string &path)
+{
+    if (outputDirectory.empty())
+        throw std::invalid_argument{"output is disabled, the server was started without --output-dir"};
+    if (path.empty() || path.front() == '/')
+        throw std::invalid_argument{"output must be a relative path"};
+
+    for (size_t start = 0; start <= path.size();)
+    {
+        const size_t end = std::min(path.find('/', start), path.size());
+        if (path.compare(start, end - start, "..") == 0)
+            throw std::invalid_argument{"output must not contain .."};
+        start = end + 1;
+    }
+    return outputDirectory + '/' + path;
+}
+
+/**
+ * @param outputDirectory where "output" paths are resolved, empty if the server doesn't write files
+ * @param bInline set to whether the image goes back on the socket, i.e. there is no "output"
+ */
+noisegen::Settings toSettings(const std::map<std::string, JsonValue> &request, const std::string &outputDirectory,
+                              bool &bInline)
+{
+    noisegen::Settings settings{};
+    bInline = true;
+
+    if (request.count("width") == 0 || request.count("height") == 0)
+        throw std::invalid_argument{"width and height are required"};
+
+    for (const auto &[key, value] : request)
+    {
+        if (key == "id")
+            continue;
+        if (key == "width")
+            settings.width = uint32Member(key, value);
+        else if (key == "height")
+            settings.height = uint32Member(key, value);
+        else if (key == "octaves")
+            settings.octaves = uint32Member(key, value);
+        else if (key == "persistence")
+            settings.persistence = doubleMember(key, value);
+        else if (key == "pipeline")
+            settings.pipeline = parsePipeline(stringMember(key, value));
+        else if (key == "seed")
+            settings.seed = parseSeed(value.raw);
+        else if (key == "kenperlin")
+            settings.bUseKenPerlinPermutations = boolMember(key, value);
+        else if (key == "basis")
+            settings.basis = parseBasis(stringMember(key, value));
+        else if (key == "precision")
+            settings.precision = parsePrecision(stringMember(key, value));
+        else if (key == "format")
+            settings.format = parseImageFormat(stringMember(key, value));
+        else if (key == "normalization")
+            settings.normalization = parseNormalization(stringMember(key, value));
+        else if (key == "output")
+        {
+            settings.outputFile = outputPath(outputDirectory, stringMember(key, value));
+            bInline = false;
+        } else if (key == "range")
+        {
+            if (value.numbers.size() != 2 || !(value.numbers[0] < value.numbers[1]))
+                throw std::invalid_argument{"range must be [min, max]"};
+            settings.rangeMin = value.numbers[0];
+            settings.rangeMax = value.numbers[1];
+            settings.normalization = noisegen::Normalization::Fixed;
+        } else
+            throw std::invalid_argument{"unknown member: " + key};
+    }
+
+    if (uint64_t{settings.width} * settings.height > MaxPixels)
+        throw std::invalid_argument{"image too large"};
+    if (settings.bUseKenPerlinPermutations && settings.seed.has_value())
+        throw std::invalid_argument{"kenperlin and seed both choose the permutations, pass only one"};
+    if (settings.octaves > MaxOctaves)
+        throw std::invalid_argument{"octaves must be at most " + std::to_string(MaxOctaves)};
+    if (!settings.pipeline.empty() && pipelineOctaves(settings.pipeline) > MaxOctaves)
+        throw std::invalid_argument{"octaves must be at most " + std::to_string(MaxOctaves)
+                                    + " for all the nodes of the pipeline together"};
+    return settings;
+}
+
+bool writeAll(int socket, const std::string &data)
+{
+    size_t written = 0;
+
+    while (written < data.size())
+    {
+        const ssize_t n = ::write(socket, data.data() + written, data.size() - written);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        written += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+double milliseconds(std::chrono::steady_clock::duration duration)
+{
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+}  // namespace
+
+Server::Server(std::string socketPath, uint32_t threads, std::string outputDirectory)
+    : m_socketPath{std::move(socketPath)},
+      m_threads{threads},
+      m_outputDirectory{std::move(outputDirectory)},
+      m_pool{noisegen::ThreadPool::shared(threads)}
+{
+    for (uint32_t workerIndex = 0; workerIndex < m_pool->size(); ++workerIndex)
+        m_workerPools.push_back(std::make_shared<noisegen::ThreadPool>(1));
+}
+
+Server::~Server()
+{
+    {
+        const std::lock_guard lock{m_queueMutex};
+        m_bStop = true;
+    }
+    m_queueCondition.notify_all();
+
+    if (m_scheduler.joinable())
+        m_scheduler.join();
+
+    // Nobody renders anymore, wake up the connections still waiting for a job
+    {
+        const std::lock_guard lock{m_queueMutex};
+
+        for (const auto &job : m_queue)
+        {
+            job->error = "server is shutting down";
+            job->done.set_value();
+        }
+        m_queue.clear();
+    }
+
+    closeConnections(false);
+
+    if (m_socket >= 0)
+    {
+        ::close(m_socket);
+        ::unlink(m_socketPath.c_str());
+    }
+}
+
+void Server::run()
+{
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (m_socketPath.size() >= sizeof(address.sun_path))
+        throw noisegen::Exception{"socket path too long: " + m_socketPath};
+    std::copy(m_socketPath.cbegin(), m_socketPath.cend(), address.sun_path);
+
+    // A socket left behind by a previous instance would make bind() fail, anything else is kept
+    struct stat status{};
+    if (::stat(m_socketPath.c_str(), &status) == 0 && S_ISSOCK(status.st_mode))
+        ::unlink(m_socketPath.c_str());
+
+    m_socket = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (m_socket < 0 || ::bind(m_socket, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0
+        || ::listen(m_socket, SOMAXCONN) != 0)
+        throw noisegen::Exception{"can't listen on " + m_socketPath + ": " + std::strerror(errno)};
+
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    m_scheduler = std::thread{&Server::schedule, this};
+    std::cerr << "listening on " << m_socketPath << " with " << m_pool->size() << " render threads\n";
+
+    while (s_bInterrupted == 0)
+    {
+        // Woken up regularly to check for signals and to clean up finished connections
+        pollfd listening{m_socket, POLLIN, 0};
+        if (::poll(&listening, 1, 200) > 0)
+        {
+            if (const int socket = ::accept(m_socket, nullptr, nullptr); socket >= 0)
+            {
+                auto &connection = m_connections.emplace_back();
+                connection.socket = socket;
+                connection.thread = std::thread{&Server::serveConnection, this, std::ref(connection)};
+            }
+        }
+        closeConnections(true);
+    }
+}
+
+void Server::schedule()
+{
+    while (true)
+    {
+        std::vector<std::shared_ptr<Job>> jobs{};
+        {
+            std::unique_lock lock{m_queueMutex};
+            m_queueCondition.wait(lock, [this] { return m_bStop || !m_queue.empty(); });
+
+            if (m_bStop)
+                return;
+            jobs.assign(m_queue.cbegin(), m_queue.cend());
+            m_queue.clear();
+        }
+
+        NOISEGEN_SCOPED_PROFILER_ARG("Server::schedule() - batch", static_cast<int64_t>(jobs.size()));
+
+        // Small images first, one per worker: a whole batch takes about as long as a single large image
+        const auto large = std::stable_partition(jobs.begin(), jobs.end(), [](const auto &job) {
+            return uint64_t{job->settings.width} * job->settings.height <= BatchPixels;
+        });
+        m_pool->parallelFor(static_cast<uint32_t>(large - jobs.begin()), [&](uint32_t index, uint32_t workerIndex) {
+            render(*jobs[index], m_workerPools[workerIndex]);
+        });
+
+        for (auto job = large; job != jobs.end(); ++job)
+            render(**job, m_pool);
+    }
+}
+
+void Server::submit(const std::shared_ptr<Job> &job)
+{
+    job->submitTime = Clock::now();
+    {
+        const std::lock_guard lock{m_queueMutex};
+
+        if (!m_bStop)
+        {
+            m_queue.push_back(job);
+            m_queueCondition.notify_one();
+            return;
+        }
+    }
+    job->error = "server is shutting down";
+    job->done.set_value();
+}
+
+void Server::render(Job &job, const std::shared_ptr<noisegen::ThreadPool> &pool) const noexcept
+{
+    job.startTime = Clock::now();
+
+    try
+    {
+        if (job.settings.precision == noisegen::Precision::Float)
+            renderImage<float>(job, pool);
+        else
+            renderImage<double>(job, pool);
+    } catch (const std::exception &e)
+    {
+        job.error = e.what();
+    }
+
+    job.endTime = Clock::now();
+    job.done.set_value();
+}
+
+template<typename Real>
+void Server::renderImage(Job &job, const std::shared_ptr<noisegen::ThreadPool> &pool) const
+{
+    NOISEGEN_SCOPED_PROFILER("Server::renderImage()");
+
+    const auto &settings = job.settings;
+
+    noisegen::BasicGenerator<Real> generator{settings};
+    generator.setThreadPool(pool);
+    job.seed = generator.getSeed().value_or(0);
+
+    typename noisegen::BasicGenerator<Real>::Image image{settings.width, settings.height};
+    const auto [minValue, maxValue] = generator.generateInto(image.data(), image.stride());
+
+    if (job.bInline)
+    {
+        std::ostringstream stream{};
+        {
+            noisegen::PGMWriter writer{stream, settings.format, settings.width, settings.height, minValue, maxValue,
+                                       pool};
+            writer.writeRows(image, image.height());
+            writer.finish();
+        }
+        job.payload = stream.str();
+        return;
+    }
+
+    std::ofstream file{settings.outputFile, std::ios::binary};
+    if (!file)
+        throw noisegen::Exception{"can't open " + settings.outputFile};
+
+    noisegen::PGMWriter writer{file, settings.format, settings.width, settings.height, minValue, maxValue, pool};
+    writer.writeRows(image, image.height());
+    writer.finish();
+}
+
+void Server::serveConnection(Connection &connection)
+{
+    std::string buffer{};
+    std::vector<char> chunk(size_t{64} << 10U);
+
+    while (true)
+    {
+        const ssize_t n = ::read(connection.socket, chunk.data(), chunk.size());
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            break;
+
+        buffer.append(chunk.data(), static_cast<size_t>(n));
+
+        size_t lineEnd{};
+        bool bConnected = true;
+        while (bConnected && (lineEnd = buffer.find('\n')) != std::string::npos)
+        {
+            const std::string line = buffer.substr(0, lineEnd);
+            buffer.erase(0, lineEnd + 1);
+
+            if (line.find_first_not_of(" \t\r") != std::string::npos)
+                bConnected = handleRequest(connection.socket, line);
+        }
+
+        if (!bConnected)
+            break;
+        if (buffer.size() > MaxLineSize)
+        {
+            writeAll(connection.socket, "{\"id\": null, \"status\": \"error\", \"message\": \"request too long\"}\n");
+            break;
+        }
+    }
+
+    connection.bFinished = true;
+}
+
+bool Server::handleRequest(int socket, const std::string &line)
+{
+    NOISEGEN_SCOPED_PROFILER("Server::handleRequest()");
+
+    std::string id{"null"};
+    auto job = std::make_shared<Job>();
+
+    try
+    {
+        const auto request = JsonParser{line}.parseObject();
+        if (const auto it = request.find("id"); it != request.end())
+            id = it->second.raw;
+
+        job->settings = toSettings(request, m_outputDirectory, job->bInline);
+        job->settings.threads = m_threads;  // generators start on m_pool, rather than creating another shared pool
+    } catch (const std::exception &e)
+    {
+        return writeAll(socket, "{\"id\": " + id + ", \"status\": \"error\", \"message\": \"" + escapeJson(e.what())
+                                  + "\"}\n");
+    }
+
+    auto done = job->done.get_future();
+    submit(job);
+    done.wait();
+
+    if (!job->error.empty())
+    {
+        return writeAll(socket, "{\"id\": " + id + ", \"status\": \"error\", \"message\": \""
+                                  + escapeJson(job->error) + "\"}\n");
+    }
+
+    std::ostringstream header{};
+    header << "{\"id\": " << id << ", \"status\": \"ok\", \"format\": \"" << noisegen::toString(job->settings.format)
+           << "\", \"seed\": " << job->seed << ", \"bytes\": " << job->payload.size()
+           << ", \"queue_ms\": " << milliseconds(job->startTime - job->submitTime)
+           << ", \"render_ms\": " << milliseconds(job->endTime - job->startTime)
+           << ", \"latency_ms\": " << milliseconds(job->endTime - job->submitTime) << "}\n";
+
+    return writeAll(socket, header.str()) && writeAll(socket, job->payload);
+}
+
+void Server::closeConnections(bool bFinishedOnly)
+{
+    for (auto connection = m_connections.begin(); connection != m_connections.end();)
+    {
+        if (bFinishedOnly && !connection->bFinished)
+        {
+            ++connection;
+            continue;
+        }
+
+        // Wakes up a connection blocked in read()
+        if (!connection->bFinished)
+            ::shutdown(connection->socket, SHUT_RDWR);
+
+        connection->thread.join();
+        ::close(connection->socket);
+        connection = m_connections.erase(connection);
+    }
+}
+
+#endif
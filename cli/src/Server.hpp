@@ -0,0 +1,131 @@
+/*
+**   Copyright 2021 Maxime Rayé
+**
+**   Licensed under the Apache License, Version 2.0 (the "License");
+**   you may not use this file except in compliance with the License.
+**   You may obtain a copy of the License at
+**
+**       http://www.apache.org/licenses/LICENSE-2.0
+**
+**   Unless required by applicable law or agreed to in writing, software
+**   distributed under the License is distributed on an "AS IS" BASIS,
+**   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**   See the License for the specific language governing permissions and
+**   limitations under the License.
+*/
+
+#pragma once
+
+#include <list>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <condition_variable>
+
+#include <noisegen/Settings.hpp>
+#include <noisegen/ThreadPool.hpp>
+
+/**
+ * `noisegencli serve`: a long-running process answering generation requests on a Unix domain socket, so that the
+ * process launch, the argument parsing and the thread pool start-up are only paid once.
+ *
+ * Protocol, newline-delimited JSON, requests on one connection are answered in order:
+ *  - request: one flat object per line, with the CLI option names: {"id": 7, "width": 256, "height": 256,
+ *    "octaves": 8, "persistence": 0.5, "seed": 42, "basis": "simplex", "precision": "float", "format": "p5",
+ *    "normalization": "analytic", "range": [-1, 1], "kenperlin": false, "pipeline": "ridged(octaves=6)",
+ *    "output": "images/42.pgm"}, only width and height are required. octaves is at most 64,
+ *    kenperlin and seed exclude each other.
+ *  - response: {"id": 7, "status": "ok", "format": "p5", "seed": 42, "bytes": 65551, "queue_ms": 0.01,
+ *    "render_ms": 1.2, "latency_ms": 1.3}, followed by the bytes of the image in that format, unless it was written
+ *    to "output" (then bytes is 0). Failures answer {"id": 7, "status": "error", "message": "..."}.
+ *  - output: a path relative to the --output-dir of the server, without "..", rejected if it has none, so that
+ *    clients can't write anywhere else the server can.
+ * `noisegencli request --socket PATH` (see Client.hpp) sends the request lines read on stdin and prints the responses.
+ *
+ * One thread per connection parses requests and writes responses, a single scheduler renders them: requests of at
+ * most BatchPixels pixels are batched, each one rendered single-threaded on a worker of the pool; larger ones get
+ * the whole pool, one at a time.
+ */
+class Server final
+{
+public:
+    static constexpr uint64_t BatchPixels = 256 * 256;
+
+    /**
+     * @param threads size of the render pool, 0 for one thread per hardware thread
+     * @param outputDirectory where requests may write their "output" files, empty to only answer on the socket
+     */
+    Server(std::string socketPath, uint32_t threads, std::string outputDirectory);
+    ~Server();
+
+    Server(Server &&) = delete;
+    Server(const Server &) = delete;
+    Server &operator=(Server &&) = delete;
+    Server &operator=(const Server &) = delete;
+
+    /**
+     * Serve until SIGINT or SIGTERM
+     */
+    void run();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Job
+    {
+        noisegen::Settings settings{};
+        bool bInline{true};  // image sent back on the socket rather than written to settings.outputFile
+
+        Clock::time_point submitTime{};
+        Clock::time_point startTime{};
+        Clock::time_point endTime{};
+        uint64_t seed{};
+        std::string payload{};
+        std::string error{};
+        std::promise<void> done{};
+    };
+
+    const std::string m_socketPath;
+    const uint32_t m_threads;
+    const std::string m_outputDirectory;
+    std::shared_ptr<noisegen::ThreadPool> m_pool;
+    std::vector<std::shared_ptr<noisegen::ThreadPool>> m_workerPools{};  // one single-threaded pool per worker
+    int m_socket{-1};
+
+    std::mutex m_queueMutex{};
+    std::condition_variable m_queueCondition{};
+    std::deque<std::shared_ptr<Job>> m_queue{};
+    bool m_bStop{false};
+    std::thread m_scheduler{};
+
+    struct Connection
+    {
+        int socket{-1};
+        std::thread thread{};
+        std::atomic<bool> bFinished{false};
+    };
+
+    // Only touched by the thread calling run(), finished connections are joined and closed by it
+    std::list<Connection> m_connections{};
+
+    void schedule();
+    void submit(const std::shared_ptr<Job> &job);
+    void render(Job &job, const std::shared_ptr<noisegen::ThreadPool> &pool) const noexcept;
+    template<typename Real>
+    void renderImage(Job &job, const std::shared_ptr<noisegen::ThreadPool> &pool) const;
+
+    void serveConnection(Connection &connection);
+    /**
+     * Parse, render and answer one request line
+     * @return false if the client is gone
+     */
+    bool handleRequest(int socket, const std::string &line);
+    void closeConnections(bool bFinishedOnly);
+};
@@ -0,0 +1,122 @@
+/*
+**   Copyright 2021 Maxime Rayé
+**
+**   Licensed under the Apache License, Version 2.0 (the "License");
+**   you may not use this file except in compliance with the License.
+**   You may obtain a copy of the License at
+**
+**       http://www.apache.org/licenses/LICENSE-2.0
+**
+**   Unless required by applicable law or agreed to in writing, software
+**   distributed under the License is distributed on an "AS IS" BASIS,
+**   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**   See the License for the specific language governing permissions and
+**   limitations under the License.
+*/
+
+/*
+ * C interface of the library, for other languages and runtimes (ctypes, cffi, P/Invoke, JNI, ...).
+ * Only plain C types cross it, and structs are only ever extended at the end, so that it stays ABI-stable.
+ * Functions returning an int return NOISEGEN_OK (0) on success, the message of a failure is
+ * noisegen_last_error() in the calling thread.
+ */
+
+#ifndef NOISEGEN_CAPI_H
+#define NOISEGEN_CAPI_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+    #if defined(NOISEGEN_EXPORTS)
+        #define NOISEGEN_API __declspec(dllexport)
+    #elif defined(NOISEGEN_SHARED)
+        #define NOISEGEN_API __declspec(dllimport)
+    #else
+        #define NOISEGEN_API
+    #endif
+#else
+    #define NOISEGEN_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NOISEGEN_OK 0
+#define NOISEGEN_ERROR_INVALID_ARGUMENT 1
+#define NOISEGEN_ERROR_PRECISION 2 /* the sample type doesn't match noisegen_settings::precision */
+#define NOISEGEN_ERROR_INTERNAL 3
+
+#define NOISEGEN_BASIS_PERLIN 0
+#define NOISEGEN_BASIS_SIMPLEX 1
+
+#define NOISEGEN_PRECISION_DOUBLE 0
+#define NOISEGEN_PRECISION_FLOAT 1
+
+#define NOISEGEN_NORMALIZATION_MINMAX 0
+#define NOISEGEN_NORMALIZATION_FIXED 1
+#define NOISEGEN_NORMALIZATION_ANALYTIC 2
+
+/*
+ * Counterpart of noisegen::Settings, without the output file options.
+ * Always initialize it with noisegen_settings_init(), which also sets struct_size.
+ */
+typedef struct noisegen_settings
+{
+    uint32_t struct_size; /* sizeof(noisegen_settings) the caller was compiled with */
+    uint32_t width;
+    uint32_t height;
+    uint32_t octaves;
+    double persistence;
+    uint32_t threads; /* 0 for one per hardware thread */
+    int32_t basis;
+    int32_t precision;
+    int32_t normalization;
+    double range_min; /* NOISEGEN_NORMALIZATION_FIXED only */
+    double range_max; /* NOISEGEN_NORMALIZATION_FIXED only */
+    int32_t use_seed; /* 0: random permutations */
+    uint64_t seed;
+    const char *pipeline; /* noise graph replacing the octave sum (see noisegen/Pipeline.hpp), NULL for none */
+} noisegen_settings;
+
+typedef struct noisegen_generator noisegen_generator;
+
+NOISEGEN_API void noisegen_settings_init(noisegen_settings *settings);
+
+/*
+ * NULL on failure, e.g. a width or height of 0
+ */
+NOISEGEN_API noisegen_generator *noisegen_create(const noisegen_settings *settings);
+NOISEGEN_API void noisegen_destroy(noisegen_generator *generator);
+
+/*
+ * Seed the permutations were derived from
+ */
+NOISEGEN_API uint64_t noisegen_get_seed(const noisegen_generator *generator);
+
+/*
+ * Render the width x height image straight into out, row y starting at out + y * stride (in samples, 0 for width).
+ * NOISEGEN_ERROR_INVALID_ARGUMENT when stride is neither 0 nor at least width.
+ * f64 / f32: raw samples, the generator precision must match. u8 / u16: normalized samples, any precision.
+ * range_min and range_max may be NULL, they receive the normalization range.
+ */
+NOISEGEN_API int noisegen_generate_f64(const noisegen_generator *generator, double *out, size_t stride,
+                                       double *range_min, double *range_max);
+NOISEGEN_API int noisegen_generate_f32(const noisegen_generator *generator, float *out, size_t stride,
+                                       double *range_min, double *range_max);
+NOISEGEN_API int noisegen_generate_u8(const noisegen_generator *generator, uint8_t *out, size_t stride,
+                                      double *range_min, double *range_max);
+NOISEGEN_API int noisegen_generate_u16(const noisegen_generator *generator, uint16_t *out, size_t stride,
+                                       double *range_min, double *range_max);
+
+/*
+ * Message of the last failure in the calling thread, empty if none. Valid until the next call from that thread.
+ */
+NOISEGEN_API const char *noisegen_last_error(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -18,14 +18,22 @@
 
 #include <cmath>
 #include <array>
-#include <random>
+#include <string>
 #include <cstddef>
 #include <cstdint>
+#include <memory>
+#include <vector>
+#include <functional>
+#include <utility>
 #include <optional>
 #include <algorithm>
+#include <type_traits>
 
 #include "Random.hpp"
+#include "Pipeline.hpp"
+#include "NoiseImage.hpp"
 #include "Settings.hpp"
+#include "ThreadPool.hpp"
 #include "ScopedProfiler.hpp"
 
 /*
@@ -36,28 +44,27 @@
  */
 
 namespace noisegen {
-struct Pixel
+/**
+ * @tparam Real precision of the samples: every computation, cache and image buffer uses it.
+ * float doubles the SIMD width and halves the memory, and is plenty for 8-bit and 16-bit output.
+ */
+template<typename Real>
+class BasicGenerator
 {
-    uint32_t x{};
-    uint32_t y{};
-    double value{};
-
-    explicit Pixel(double aValue) : value{aValue} {}
-    Pixel(uint32_t aX, uint32_t aY) : x{aX}, y{aY} {}
-    Pixel(uint32_t aX, uint32_t aY, double aValue) : x{aX}, y{aY}, value{aValue} {}
-
-    bool operator==(const Pixel &rhs) const noexcept { return value == rhs.value; }
-    bool operator!=(const Pixel &rhs) const noexcept { return !(rhs == *this); }
+    static_assert(std::is_floating_point_v<Real>);
 
-    bool operator<(const Pixel &rhs) const noexcept { return value < rhs.value; }
-    bool operator>(const Pixel &rhs) const noexcept { return rhs < *this; }
-    bool operator<=(const Pixel &rhs) const noexcept { return !(rhs < *this); }
-    bool operator>=(const Pixel &rhs) const noexcept { return !(*this < rhs); }
-};
-class Generator
-{
 public:
+    using ValueType = Real;
+    using Image = BasicNoiseImage<Real>;
+
     static constexpr size_t PermutationArraySize = 256;
+
+    /**
+     * Images are rendered in tiles of TileWidth x TileHeight samples, each tile is a work item for the thread pool.
+     * One row of a tile (and the batch buffers used for it) stays in L1 cache while every octave is added to it.
+     */
+    static constexpr uint32_t TileWidth = 256;
+    static constexpr uint32_t TileHeight = 16;
     using PermutationArray = std::array<uint8_t, PermutationArraySize>;
 
     /**
@@ -77,12 +84,206 @@ public:
       181, 199, 106, 157, 184, 84,  204, 176, 115, 121, 50,  45,  127, 4,   150, 254, 138, 236, 205, 93,  222, 114,
       67,  29,  24,  72,  243, 141, 128, 195, 78,  66,  215, 61,  156, 180};
 
-    explicit Generator(Settings settings,
-                       const std::optional<PermutationArray> &permutationArrayOverride = std::nullopt);
+    /**
+     * @throw Exception if Settings::pipeline doesn't compile
+     */
+    explicit BasicGenerator(Settings settings,
+                            const std::optional<PermutationArray> &permutationArrayOverride = std::nullopt);
 
     void generate();
     void saveToPGM() const;
-    [[nodiscard]] double noise3D(double x, double y, double z) const noexcept;  // TODO: noise2D and noise1D
+
+    /**
+     * generate(), also rendering the partial derivatives of every sample along x and y in the same pass: each octave
+     * adds the analytic derivative of its noise, scaled by its amplitude and frequency. Derivatives are taken with
+     * respect to the coordinates of generate(), where the image spans [0, 1) on both axes.
+     * Planar images of the octave sum only: throws Exception with a Settings::pipeline.
+     */
+    void generateDerivatives();
+    /**
+     * Write the normal map of the surface rendered by generateDerivatives() to Settings::normalMapFile, as a binary
+     * PPM (P6): each normal is packed as (n + 1) / 2 in [0, 255], x to the right and y down the rows.
+     * The normalized height is Settings::normalStrength pixels high.
+     * Throws Exception if generateDerivatives() wasn't called first, without Settings::normalMapFile, or if the file
+     * can't be written.
+     */
+    void saveNormalMap() const;
+
+    /**
+     * generate(), along with the coarser levels of its LOD pyramid: level k is ceil(width / 2^k) x ceil(height / 2^k),
+     * down to 1 x 1, and its sample (x, y) is sample (x * 2^k, y * 2^k) of generate().
+     * Level 0 keeps every octave, coarser levels only the ones below their Nyquist limit (see pyramidOctaves()).
+     * Levels are rendered from the coarsest: the samples of a level on even rows and columns start from the partial
+     * sum of the coarser level, which is the exact sum of its fewer octaves, and only add the missing ones.
+     * Every level is normalized with the same range. Planar images of the octave sum only: throws Exception with a
+     * Settings::pipeline.
+     */
+    void generatePyramid();
+    /**
+     * Write the levels rendered by generatePyramid(). Image formats write one numbered file per level, finest first.
+     * Raw formats write a single file: the 8 bytes "NGPYRAMD", the level count, then width, height and byte offset
+     * of every level (big-endian uint32, uint32, uint32 and uint64), then the samples of every level at its offset.
+     */
+    void savePyramid() const;
+    /**
+     * Refinement stage of generateProgressive()
+     */
+    struct ProgressiveStage
+    {
+        const Image &image;               // level of generatePyramid(), the full image at level 0
+        uint32_t level;                   // the last stage is level 0
+        uint32_t octaves;                 // summed in every sample, pyramidOctaves(level)
+        std::pair<double, double> range;  // normalization range, the same for every stage (see generateProgressive())
+    };
+    using ProgressCallback = std::function<void(const ProgressiveStage &stage)>;
+
+    /**
+     * generate(), refining a preview coarse to fine: the levels of generatePyramid() are rendered from the coarsest
+     * one at least minPreviewSize wide or high, adding resolution and octaves, and passed to callback before the next
+     * one. Each level starts from the partial sums of the previous one (see generatePyramid()), so no octave of a
+     * sample is evaluated twice: the previews only add the samples of the coarse levels, a third of the image's.
+     * Every stage gets the same range, so that a preview doesn't change brightness as it refines: the known
+     * normalization range, or the analytic bound of the octave sum with Normalization::MinMax.
+     * Only two levels are kept in memory. After the last stage, the generator holds the image and range of generate().
+     * Planar images of the octave sum only: throws Exception with a Settings::pipeline.
+     * @param callback called from the calling thread, between two levels
+     * @param minPreviewSize size of the first preview, coarser levels are too small to show anything (the 1x1 level
+     * is a single lattice point, always 0)
+     */
+    void generateProgressive(const ProgressCallback &callback, uint32_t minPreviewSize = 64);
+    /**
+     * Levels of the LOD pyramid of a width x height image, 1 + ceil(log2(max(width, height)))
+     */
+    [[nodiscard]] static uint32_t pyramidLevelCount(uint32_t width, uint32_t height) noexcept;
+    /**
+     * Octaves summed at a pyramid level: all of them at level 0, then those whose frequency stays below half the
+     * sample rate of the level, at least 1
+     */
+    [[nodiscard]] uint32_t pyramidOctaves(uint32_t level) const noexcept;
+
+    /**
+     * Render and write the image band by band, for images that don't fit in Settings::maxMemory.
+     * Without a fixed range, a first pass over every band finds the min/max used for normalization.
+     */
+    void streamToPGM();
+    /**
+     * Render and write the Settings::depth slices of a volume (or frames of an animation), slice k at
+     * z = k * Settings::sliceSpacing, with the 3D noise. Slice k is written by another thread while slice k + 1 is
+     * rendered, so two slices are kept in memory. When they don't fit in Settings::maxMemory, each slice is rendered
+     * and written band by band instead, as in streamToPGM().
+     * Raw formats append every slice to Settings::outputFile, PGM formats write one numbered file per slice.
+     * Without a fixed range, a first pass over every slice finds the min/max used for normalization.
+     */
+    void generateVolume();
+    /**
+     * Render straight into the output file: it is preallocated and memory-mapped, and the rendering workers quantize
+     * each tile row in place. No image is allocated and there is no write phase, the kernel writes the pages back.
+     * Normalization::MinMax renders the image twice to find the range first.
+     * PGMAscii (variable-length rows), PNG (compressed) and platforms without mmap fall back to generate() and
+     * saveToPGM(), or to streamToPGM() when the image doesn't fit in Settings::maxMemory.
+     */
+    void mapToPGM();
+    /**
+     * Render a width x height window of the noise plane into out (reallocated if its size differs), without
+     * normalization: sample (x, y) is at (offsetX + x * scale, offsetY + y * scale), in the units of generate() where
+     * the image spans [0, 1). generate() of a square image is generateRegion(0, 0, 1 / width, width, height).
+     * With a power-of-two scale and integer sample offsets, every window gives the exact same value for a given
+     * sample, so windows can be cut into seamless tiles (see TileCache.hpp).
+     */
+    void generateRegion(double offsetX, double offsetY, double scale, uint32_t width, uint32_t height,
+                        Image &out) const;
+    /**
+     * Render the Settings::width x Settings::height image of generate() straight into caller-owned memory, e.g. a
+     * texture upload buffer or a shared memory segment: no image is kept, nothing is copied.
+     * Row y starts at out + y * stride, stride is in values, 0 for Settings::width. A non-zero stride must be at
+     * least Settings::width (rows would overlap otherwise), and out must hold (height - 1) * stride + width values.
+     * Real: raw samples. uint8_t / uint16_t: normalized like saveToPGM() (native-endian for 16-bit), each tile row is
+     * quantized while still in L1. Normalization::MinMax renders the image twice to find the range first.
+     * @return range used for normalization, the min/max of the samples when it isn't known before rendering
+     */
+    std::pair<double, double> generateInto(Real *out, size_t stride = 0) const;
+    std::pair<double, double> generateInto(uint8_t *out, size_t stride = 0) const;
+    std::pair<double, double> generateInto(uint16_t *out, size_t stride = 0) const;
+    /**
+     * @return whether the whole image fits in Settings::maxMemory, i.e. generate() can be used
+     */
+    [[nodiscard]] bool fitsInMemory() const noexcept;
+    /**
+     * Range used for normalization when it is known before rendering (Normalization::Fixed or Analytic),
+     * std::nullopt when it has to be measured on the rendered samples (Normalization::MinMax)
+     */
+    [[nodiscard]] std::optional<std::pair<double, double>> getNormalizationRange() const noexcept;
+    /**
+     * Theoretical bounds of the samples, whatever Settings::normalization
+     */
+    [[nodiscard]] std::pair<double, double> getAnalyticRange() const noexcept;
+
+    /**
+     * Noise of Settings::basis, in [-1, 1]
+     */
+    [[nodiscard]] Real noise3D(Real x, Real y, Real z) const noexcept;
+    /**
+     * Perlin: same value as noise3D(x, y, 0), only the 4 corners of the z = 0 face are evaluated.
+     * Simplex: 2D simplex noise (3 corners), not a slice of the 3D one.
+     */
+    [[nodiscard]] Real noise2D(Real x, Real y) const noexcept;
+    /**
+     * Same value as noise3D(x, 0, 0), only the 2 ends of the lattice edge are evaluated.
+     */
+    [[nodiscard]] Real noise1D(Real x) const noexcept;
+
+    /**
+     * Evaluate noise3D() for n points at once, using the best SIMD instruction set of the running CPU.
+     * The version matching Real returns the exact same values as noise3D().
+     * @param xs, ys, zs n coordinates each
+     * @param out n results, may alias any of the inputs
+     */
+    void noise3DBatch(const double *xs, const double *ys, const double *zs, double *out, size_t n) const noexcept;
+    void noise3DBatch(const float *xs, const float *ys, const float *zs, float *out, size_t n) const noexcept;
+    /**
+     * noise2D() counterpart of noise3DBatch(), used by generate() for planar images.
+     */
+    void noise2DBatch(const double *xs, const double *ys, double *out, size_t n) const noexcept;
+    void noise2DBatch(const float *xs, const float *ys, float *out, size_t n) const noexcept;
+    /**
+     * noise3DBatch() for n points on the same row of a z slice, evaluated like noise2DRow().
+     * @param xs n coordinates, sorted in increasing order
+     * @param out n results, must not alias xs
+     */
+    void noise3DRow(const double *xs, double y, double z, double *out, size_t n) const noexcept;
+    void noise3DRow(const float *xs, float y, float z, float *out, size_t n) const noexcept;
+    /**
+     * noise2DBatch() for n points on the same row, evaluated lattice cell by lattice cell.
+     * Corner hashes and gradients are only computed once per cell, which is much faster for low frequencies.
+     * @param xs n coordinates, sorted in increasing order
+     * @param out n results, must not alias xs
+     */
+    void noise2DRow(const double *xs, double y, double *out, size_t n) const noexcept;
+    void noise2DRow(const float *xs, float y, float *out, size_t n) const noexcept;
+    /**
+     * noise2D() along with its partial derivatives: {value, d/dx, d/dy}
+     */
+    [[nodiscard]] std::array<Real, 3> noise2DDerivatives(Real x, Real y) const noexcept;
+    /**
+     * noise2DRow() also storing the partial derivatives of every sample along x and y, evaluated analytically.
+     * The values are the same as noise2DRow()'s.
+     * @param out, dxs, dys n results each, must not alias xs
+     */
+    void noise2DDerivativesRow(const double *xs, double y, double *out, double *dxs, double *dys,
+                               size_t n) const noexcept;
+    void noise2DDerivativesRow(const float *xs, float y, float *out, float *dxs, float *dys, size_t n) const noexcept;
+
+    /**
+     * Permutations derived from seed with a Fisher-Yates shuffle driven by SplitMix64.
+     * Pure function of the seed, the same on every platform and standard library (unlike std::shuffle), and
+     * touches no shared state, so generators can be built from any number of threads.
+     */
+    [[nodiscard]] static PermutationArray permutationsFromSeed(uint64_t seed) noexcept;
+
+    /**
+     * Replace the permutations by permutationsFromSeed(seed)
+     */
+    void setSeed(uint64_t seed) noexcept;
 
     template<typename Gen>
     void shufflePermutationArray(Gen &&generator)
@@ -90,45 +291,218 @@ public:
         NOISEGEN_SCOPED_PROFILER("Generator::shufflePermutationArray()");
 
         std::shuffle(m_permutations.begin(), m_permutations.end(), std::forward<Gen>(generator));
+        m_seed.reset();
+        updatePermutationTable();
     }
-    inline void shufflePermutationArray() { shufflePermutationArray(Random::s_generator); }
+    inline void shufflePermutationArray() { setSeed(Random::randomSeed()); }
 
     [[nodiscard]] inline const Settings &getSettings() const noexcept { return m_settings; }
     [[nodiscard]] inline const PermutationArray &getPermutationArray() const noexcept { return m_permutations; }
+    /**
+     * Seed the permutations were derived from, random when Settings::seed isn't set, so that any image can be
+     * regenerated. std::nullopt for Ken Perlin's, overridden or custom shuffled permutations.
+     */
+    [[nodiscard]] inline std::optional<uint64_t> getSeed() const noexcept { return m_seed; }
+    /**
+     * Settings::pipeline compiled, std::nullopt when the samples are the octave sum
+     */
+    [[nodiscard]] inline const std::optional<Pipeline> &getPipeline() const noexcept { return m_pipeline; }
+    [[nodiscard]] inline const Image &getImage() const noexcept { return m_image; }
+    /**
+     * Partial derivatives along x and y rendered by generateDerivatives(), empty otherwise
+     */
+    [[nodiscard]] inline const Image &getDerivativeX() const noexcept { return m_derivativeX; }
+    [[nodiscard]] inline const Image &getDerivativeY() const noexcept { return m_derivativeY; }
+    /**
+     * Levels 1 and up rendered by generatePyramid(), level k at index k - 1 (level 0 is getImage()), empty otherwise
+     */
+    [[nodiscard]] inline const std::vector<Image> &getPyramid() const noexcept { return m_pyramid; }
+    [[nodiscard]] inline ThreadPool &getThreadPool() const noexcept { return *m_threadPool; }
+
+    /**
+     * Use another pool than ThreadPool::shared(Settings::threads), e.g. to share one between unrelated generators
+     */
+    inline void setThreadPool(std::shared_ptr<ThreadPool> threadPool) noexcept { m_threadPool = std::move(threadPool); }
 
 private:
     Settings m_settings;
+    std::shared_ptr<ThreadPool> m_threadPool;
     PermutationArray m_permutations = s_KenPerlinPermutations;
+    std::optional<uint64_t> m_seed{};
+    std::optional<Pipeline> m_pipeline{};
+
+    /**
+     * m_permutations widened to int32 and repeated twice, for the SIMD gathers of noise3DBatch().
+     * Every index computed by Perlin's algorithm fits in it, no modulo needed.
+     */
+    alignas(64) std::array<int32_t, PermutationArraySize * 2> m_permutationTable{};
 
-    std::vector<double> m_frequencyCache{};
-    std::vector<double> m_amplitudeCache{};
+    std::vector<Real> m_frequencyCache{};
+    std::vector<Real> m_amplitudeCache{};
 
-    std::vector<Pixel> m_pixels{};
+    Image m_image{};
+    Image m_derivativeX{};
+    Image m_derivativeY{};
+    std::vector<Image> m_pyramid{};
     double m_minNoiseValue{};
     double m_maxNoiseValue{};
 
     void cacheFrequencyAndAmplitude();
+    void updatePermutationTable() noexcept;
+
+    /**
+     * Noise coordinates of sample (x, y) before the octave frequencies: (originX + x * stepX, originY + y * stepY, z).
+     * Planar images have no z and use the 2D noise.
+     */
+    struct SampleGrid
+    {
+        Real originX{};
+        Real originY{};
+        Real stepX{};
+        Real stepY{};
+        std::optional<Real> z{};
+    };
+
+    /**
+     * Images receiving the derivatives of the samples rendered by renderRows(), row for row
+     */
+    struct DerivativeImages
+    {
+        Image &dx;
+        Image &dy;
+    };
+
+    /**
+     * Grid of the whole Settings::width x Settings::height image, or of one of its volume slices
+     */
+    [[nodiscard]] SampleGrid imageGrid(std::optional<Real> z = std::nullopt) const noexcept;
+
+    /**
+     * Render rows [firstRow, firstRow + rowCount) of grid into the first rows of out, out.width() samples per row
+     * @param bTrackRange compute the min/max of the rendered samples on the fly
+     * @param derivatives render the derivatives along with the samples (planar grids only), none if null
+     * @return min and max of the rendered samples, only meaningful with bTrackRange
+     */
+    std::pair<double, double> renderRows(const SampleGrid &grid, uint32_t firstRow, uint32_t rowCount, Image &out,
+                                         bool bTrackRange, const DerivativeImages *derivatives = nullptr) const;
+    /**
+     * renderRows() into any output, width samples per row, one tile row at a time:
+     * the n values of row (relative to firstRow) starting at column x are accumulated at destination(row, x, scratch)
+     * (scratch holds TileWidth values, for outputs that can't hold samples), then passed to store(row, x, values, n).
+     */
+    template<typename Destination, typename Store>
+    std::pair<double, double> renderRows(const SampleGrid &grid, uint32_t firstRow, uint32_t rowCount, uint32_t width,
+                                         bool bTrackRange, const Destination &destination, const Store &store,
+                                         const DerivativeImages *derivatives = nullptr) const;
+    /**
+     * generateInto() for quantized outputs: quantize(values, n, range, row, x) stores the n values of row starting at
+     * column x, normalized with range
+     */
+    template<typename Quantize>
+    std::pair<double, double> generateQuantized(const Quantize &quantize) const;
+
+    /**
+     * Octave counts up to MaxUnrolledOctaves are rendered by a fully unrolled renderTileRowUnrolled(),
+     * with the frequencies folded to constants. Larger counts use the loop of renderTileRow().
+     */
+    static constexpr uint32_t MaxUnrolledOctaves = 12;
 
     /**
-     * Get a permutation value from the array.
-     * Allows index overflow for simpler operations with the array.
-     * @param index for the array, allows overflow
-     * @return m_permutations array value, modulo PermutationArraySize
+     * Sum every octave of one row of a tile into values
+     * @param xs x coordinates of the first octave, the ones of octave k are k * stride further
+     * @param y row coordinate before scaling by the octave frequency
+     * @param samples scratch buffer of n samples
      */
-    [[nodiscard]] inline auto getPermutation(size_t index) const
+    using RenderTileRowFunction = void (BasicGenerator::*)(const Real *xs, size_t stride, Real y, Real *samples,
+                                                           Real *values, uint32_t n) const noexcept;
+
+    [[nodiscard]] RenderTileRowFunction selectRenderTileRow() const noexcept;
+    void renderTileRow(const Real *xs, size_t stride, Real y, Real *samples, Real *values, uint32_t n) const noexcept;
+    template<uint32_t Octaves>
+    void renderTileRowUnrolled(const Real *xs, size_t stride, Real y, Real *samples, Real *values,
+                               uint32_t n) const noexcept;
+    /**
+     * renderTileRow() for a volume slice at z, with the 3D noise
+     */
+    void renderTileRow3D(const Real *xs, size_t stride, Real y, Real z, Real *samples, Real *values,
+                         uint32_t n) const noexcept;
+    /**
+     * renderTileRow() also summing the derivatives of every octave into dxs and dys
+     * @param samples scratch buffer of 3 * TileWidth samples
+     */
+    void renderTileRowDerivatives(const Real *xs, size_t stride, Real y, Real *samples, Real *values, Real *dxs,
+                                  Real *dys, uint32_t n) const noexcept;
+    /**
+     * Evaluate m_pipeline on one row of a tile instead of the octave sum, every instruction on the whole row
+     * @param xs x coordinates of the row, before any frequency
+     * @param z slice of a volume, std::nullopt for the 2D noise
+     * @param scratch pipelineScratchSize() values: the registers, then the coordinates of every warp context,
+     * then the buffers of renderFractal()
+     */
+    void renderTileRowPipeline(const Real *xs, Real y, std::optional<Real> z, Real *scratch, Real *values,
+                               uint32_t n) const noexcept;
+    /**
+     * Sum the octaves of a Pipeline::Op::Fractal instruction into out
+     * @param xs, ys coordinates of the context, ys is null for context 0 (the row at y, xs sorted)
+     * @param buffers 5 * TileWidth scratch values
+     */
+    void renderFractal(const Pipeline::Instruction &instruction, const Real *xs, const Real *ys, Real y,
+                       std::optional<Real> z, Real *buffers, Real *out, uint32_t n) const noexcept;
+    [[nodiscard]] size_t pipelineScratchSize() const noexcept;
+    /**
+     * Size of a level of generatePyramid(): ceil(width / 2^level) x ceil(height / 2^level)
+     */
+    [[nodiscard]] std::pair<uint32_t, uint32_t> pyramidLevelSize(uint32_t level) const noexcept;
+    /**
+     * Render a level of generatePyramid() into out, already sized
+     * @param coarser the next level, already rendered, its samples are reused for the even rows and columns;
+     * null for the coarsest level
+     * @param bTrackRange compute the min/max of the rendered samples on the fly
+     * @return min and max of the rendered samples, only meaningful with bTrackRange
+     */
+    std::pair<double, double> renderPyramidLevel(uint32_t level, const Image *coarser, Image &out,
+                                                 bool bTrackRange) const;
+    /**
+     * Largest |noise| of Settings::basis, in 2D or in 3D for volumes
+     */
+    [[nodiscard]] double noiseBound() const noexcept;
+    /**
+     * Pool of the PGMWriter of saved images: PNG slices and images are deflated while the next one renders on
+     * m_threadPool, so they get ThreadPool::sharedForOutput(). Other formats don't use it.
+     */
+    [[nodiscard]] std::shared_ptr<ThreadPool> outputPool() const;
+    [[nodiscard]] uint32_t streamingBandHeight() const noexcept;
+    [[nodiscard]] Real sliceZ(uint32_t slice) const noexcept;
+
+    /**
+     * Get a permutation value from the doubled table, no modulo needed.
+     * @param index for the array, up to 2 * PermutationArraySize - 1
+     * @return m_permutations[index % PermutationArraySize]
+     */
+    [[nodiscard]] inline uint8_t getPermutation(size_t index) const noexcept
     {
-        return m_permutations[index % PermutationArraySize];
+        return static_cast<uint8_t>(m_permutationTable[index]);
     }
 
-    static inline constexpr double fade(double t) noexcept { return t * t * t * (t * (t * 6.0 - 15.0) + 10.0); }
+    static inline constexpr Real fade(Real t) noexcept
+    {
+        return t * t * t * (t * (t * Real{6} - Real{15}) + Real{10});
+    }
 
-    static inline constexpr double lerp(double t, double a, double b) noexcept { return a + t * (b - a); }
+    static inline constexpr Real lerp(Real t, Real a, Real b) noexcept { return a + t * (b - a); }
 
-    static inline constexpr double grad(int hash, double x, double y, double z) noexcept
+    static inline constexpr Real grad(int hash, Real x, Real y, Real z) noexcept
     {
         const int h = hash & 15;
-        const double u = h < 8 ? x : y, v = h < 4 ? y : h == 12 || h == 14 ? x : z;
+        const Real u = h < 8 ? x : y, v = h < 4 ? y : h == 12 || h == 14 ? x : z;
         return ((h & 1) == 0 ? u : -u) + ((h & 2) == 0 ? v : -v);
     }
 };
+
+// Both are compiled once, in Generator.cpp
+extern template class BasicGenerator<float>;
+extern template class BasicGenerator<double>;
+
+using Generator = BasicGenerator<double>;
+using GeneratorF = BasicGenerator<float>;
 }  // namespace noisegen
@@ -0,0 +1,66 @@
+/*
+**   Copyright 2021 Maxime Rayé
+**
+**   Licensed under the Apache License, Version 2.0 (the "License");
+**   you may not use this file except in compliance with the License.
+**   You may obtain a copy of the License at
+**
+**       http://www.apache.org/licenses/LICENSE-2.0
+**
+**   Unless required by applicable law or agreed to in writing, software
+**   distributed under the License is distributed on an "AS IS" BASIS,
+**   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**   See the License for the specific language governing permissions and
+**   limitations under the License.
+*/
+
+#pragma once
+
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+namespace noisegen {
+/**
+ * Planar, row-major image of noise samples.
+ * Rows are `stride` values apart, values past `width` in a row are padding.
+ * Values are left uninitialized on construction, so that pages are first touched by whoever fills them.
+ */
+template<typename T>
+class BasicNoiseImage
+{
+public:
+    using ValueType = T;
+
+    BasicNoiseImage() = default;
+    BasicNoiseImage(uint32_t width, uint32_t height, size_t stride = 0)
+        : m_width{width}, m_height{height}, m_stride{stride == 0 ? width : stride},
+          m_values{new T[m_stride * height]}
+    {
+    }
+
+    [[nodiscard]] inline uint32_t width() const noexcept { return m_width; }
+    [[nodiscard]] inline uint32_t height() const noexcept { return m_height; }
+    [[nodiscard]] inline size_t stride() const noexcept { return m_stride; }
+    [[nodiscard]] inline size_t size() const noexcept { return m_stride * m_height; }
+    [[nodiscard]] inline bool empty() const noexcept { return size() == 0; }
+
+    [[nodiscard]] inline T *data() noexcept { return m_values.get(); }
+    [[nodiscard]] inline const T *data() const noexcept { return m_values.get(); }
+
+    [[nodiscard]] inline T *row(uint32_t y) noexcept { return data() + m_stride * y; }
+    [[nodiscard]] inline const T *row(uint32_t y) const noexcept { return data() + m_stride * y; }
+
+    [[nodiscard]] inline T &at(uint32_t x, uint32_t y) noexcept { return row(y)[x]; }
+    [[nodiscard]] inline const T &at(uint32_t x, uint32_t y) const noexcept { return row(y)[x]; }
+
+private:
+    uint32_t m_width{};
+    uint32_t m_height{};
+    size_t m_stride{};
+    std::unique_ptr<T[]> m_values{};
+};
+
+using NoiseImage = BasicNoiseImage<double>;
+using NoiseImageF = BasicNoiseImage<float>;
+}  // namespace noisegen
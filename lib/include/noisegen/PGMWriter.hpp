@@ -0,0 +1,113 @@
+/*
+**   Copyright 2021 Maxime Rayé
+**
+**   Licensed under the Apache License, Version 2.0 (the "License");
+**   you may not use this file except in compliance with the License.
+**   You may obtain a copy of the License at
+**
+**       http://www.apache.org/licenses/LICENSE-2.0
+**
+**   Unless required by applicable law or agreed to in writing, software
+**   distributed under the License is distributed on an "AS IS" BASIS,
+**   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**   See the License for the specific language governing permissions and
+**   limitations under the License.
+*/
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+#include "Settings.hpp"
+#include "NoiseImage.hpp"
+#include "ThreadPool.hpp"
+
+namespace noisegen {
+class PNGEncoder;
+
+/**
+ * Quantizes rows of samples into a contiguous byte buffer, written to the stream in large chunks.
+ * The header is written on construction, raw formats have none.
+ * PNG rows are deflated in batches over the thread pool.
+ * The image is complete once finish() returns: a writer destroyed before that abandons it, without writing the rest
+ * of the buffered rows nor the PNG trailer.
+ */
+class PGMWriter final
+{
+public:
+    static constexpr size_t ChunkSize = size_t{4} << 20U;
+
+    /**
+     * @param pool threads deflating PNG rows, the shared pool if null
+     */
+    PGMWriter(std::ostream &os, ImageFormat format, uint32_t width, uint32_t height, double minValue,
+              double maxValue, std::shared_ptr<ThreadPool> pool = nullptr);
+    ~PGMWriter();
+
+    PGMWriter(PGMWriter &&) = delete;
+    PGMWriter(const PGMWriter &) = delete;
+    PGMWriter &operator=(PGMWriter &&) = delete;
+    PGMWriter &operator=(const PGMWriter &) = delete;
+
+    /**
+     * Write the first rowCount rows of image, rows must be written in order
+     */
+    void writeRows(const NoiseImage &image, uint32_t rowCount);
+    void writeRows(const NoiseImageF &image, uint32_t rowCount);
+    void flush();
+    /**
+     * Write the buffered rows and end the image, once every row has been written.
+     * Throws on PNG encoding failures, write failures are left in the state of the stream.
+     */
+    void finish();
+
+    /**
+     * Header written before the samples, empty for raw formats and PNG (written by its encoder)
+     */
+    [[nodiscard]] static std::string header(ImageFormat format, uint32_t width, uint32_t height);
+
+    /**
+     * Map n values from [minValue, maxValue] to [0, 255], values outside are clamped.
+     */
+    static void quantize8(const double *values, size_t n, double minValue, double maxValue, uint8_t *out) noexcept;
+    static void quantize8(const float *values, size_t n, double minValue, double maxValue, uint8_t *out) noexcept;
+    /**
+     * Map n values from [minValue, maxValue] to [0, 65535], stored big-endian (2 bytes per value) as PGM expects.
+     */
+    static void quantize16(const double *values, size_t n, double minValue, double maxValue, uint8_t *out) noexcept;
+    static void quantize16(const float *values, size_t n, double minValue, double maxValue, uint8_t *out) noexcept;
+    /**
+     * Map n values from [minValue, maxValue] to [0, 65535], in native byte order.
+     */
+    static void quantize16(const double *values, size_t n, double minValue, double maxValue, uint16_t *out) noexcept;
+    static void quantize16(const float *values, size_t n, double minValue, double maxValue, uint16_t *out) noexcept;
+
+private:
+    std::ostream &m_os;
+    const ImageFormat m_format;
+    const uint32_t m_width;
+    const double m_minValue;
+    const double m_maxValue;
+
+    std::vector<uint8_t> m_buffer{};
+    std::vector<uint8_t> m_quantized{};
+    std::unique_ptr<PNGEncoder> m_png{};
+    size_t m_flushSize{ChunkSize};
+    bool m_bFinished{false};
+
+    template<typename T>
+    void writeRows(const BasicNoiseImage<T> &image, uint32_t rowCount);
+    template<typename T>
+    void writeRow(const T *values);
+};
+
+/**
+ * "output.pgm" -> "output_0042.pgm" when writing several files, unchanged otherwise
+ */
+[[nodiscard]] std::string numberedFileName(const std::string &fileName, uint32_t index, uint32_t count);
+}  // namespace noisegen
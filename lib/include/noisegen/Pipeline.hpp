@@ -0,0 +1,130 @@
+/*
+**   Copyright 2021 Maxime Rayé
+**
+**   Licensed under the Apache License, Version 2.0 (the "License");
+**   you may not use this file except in compliance with the License.
+**   You may obtain a copy of the License at
+**
+**       http://www.apache.org/licenses/LICENSE-2.0
+**
+**   Unless required by applicable law or agreed to in writing, software
+**   distributed under the License is distributed on an "AS IS" BASIS,
+**   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**   See the License for the specific language governing permissions and
+**   limitations under the License.
+*/
+
+#pragma once
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <string_view>
+
+namespace noisegen {
+/**
+ * Noise graph replacing the fixed octave sum of generate(), compiled from an expression such as
+ *
+ *     ridged(octaves=6, frequency=2) * 0.7 + warp(fbm(octaves=8), amount=0.2)
+ *
+ * into a register program that BasicGenerator runs on every tile row while it is in L1: the whole graph is evaluated
+ * in the single traversal of renderRows(), intermediate fields never leave the per-worker scratch buffers.
+ *
+ * Fractal nodes sum octave k of the Settings::basis noise at frequency * lacunarity^k with amplitude persistence^k:
+ * - noise(frequency, shiftX, shiftY): a single octave
+ * - fbm(octaves, persistence, lacunarity, frequency, shiftX, shiftY): the sum of generate()
+ * - turbulence(...): the sum of |noise|, same parameters as fbm
+ * - ridged(..., offset, gain): Musgrave's ridged multifractal, each octave (offset - |noise|)^2 weighted by the
+ *   previous one times gain, clamped to [0, 1]
+ * Defaults are octaves=8, persistence=0.5, lacunarity=2, frequency=1, shiftX=shiftY=0, offset=1, gain=2, so fbm() is
+ * generate() with the default settings. Coordinates are the ones of generate(), shifted by (shiftX, shiftY).
+ *
+ * warp(source, x=..., y=..., amount=0.1) evaluates source at p + amount * (x(p), y(p)), x and y are any
+ * expression, fbm(octaves=4, shiftX=5.2, shiftY=1.3) and fbm(octaves=4, shiftX=1.7, shiftY=9.2) by default.
+ * Expressions combine nodes and numbers with + - * and parentheses, abs(a), min(a, b) and max(a, b).
+ * Parameters are number literals. Comments run from # to the end of the line.
+ * Expressions nest at most MaxDepth levels deep (parentheses, calls and chains of operators alike) and have at most
+ * MaxNodes nodes, so that untrusted sources can't exhaust the stack or the scratch memory.
+ */
+class Pipeline
+{
+public:
+    static constexpr uint32_t MaxDepth = 256;
+    static constexpr size_t MaxNodes = 4096;
+
+    enum class Op
+    {
+        Constant,  // output = value
+        Fractal,   // output = fractal sum at the coordinates of context
+        Warp,      // coordinates of context = the ones of parent + amount * (a, b)
+        Add,       // output = a + b
+        Subtract,  // output = a - b
+        Multiply,  // output = a * b
+        Min,       // output = min(a, b)
+        Max,       // output = max(a, b)
+        Abs,       // output = |a|
+    };
+
+    enum class Fractal
+    {
+        Fbm,
+        Turbulence,
+        Ridged,
+    };
+
+    /**
+     * Registers are fields of one tile row. Context 0 holds the coordinates of the row itself, warps add contexts.
+     */
+    struct Instruction
+    {
+        Op op{};
+        uint32_t output{};   // register, or the context created by Op::Warp
+        uint32_t a{};        // operand registers
+        uint32_t b{};
+        uint32_t context{};  // context of Op::Fractal, parent context of Op::Warp
+        Fractal fractal{};
+        uint32_t octaves{};
+        double frequency{};
+        double lacunarity{};
+        double persistence{};
+        double offset{};
+        double gain{};
+        double shiftX{};
+        double shiftY{};
+        double value{};  // Op::Constant value, Op::Warp amount
+    };
+
+    /**
+     * @param noiseBound largest |noise| of the basis the pipeline is evaluated with, for getBounds()
+     * @throw Exception on syntax errors and invalid parameters, with the column of the error
+     */
+    [[nodiscard]] static Pipeline compile(std::string_view source, double noiseBound = 1.0);
+
+    [[nodiscard]] inline const std::string &getSource() const noexcept { return m_source; }
+    /**
+     * Instructions in evaluation order, every operand is written before it is read
+     */
+    [[nodiscard]] inline const std::vector<Instruction> &getInstructions() const noexcept { return m_instructions; }
+    [[nodiscard]] inline uint32_t getRegisterCount() const noexcept { return m_registerCount; }
+    [[nodiscard]] inline uint32_t getContextCount() const noexcept { return m_contextCount; }
+    /**
+     * Register holding the value of the whole expression
+     */
+    [[nodiscard]] inline uint32_t getResult() const noexcept { return m_result; }
+    /**
+     * Bounds of the value from the ones of the nodes (the noise is within [-noiseBound, noiseBound] of compile()), for
+     * Normalization::Analytic
+     */
+    [[nodiscard]] inline std::pair<double, double> getBounds() const noexcept { return m_bounds; }
+
+private:
+    std::string m_source{};
+    std::vector<Instruction> m_instructions{};
+    uint32_t m_registerCount{};
+    uint32_t m_contextCount{1};
+    uint32_t m_result{};
+    std::pair<double, double> m_bounds{};
+};
+}  // namespace noisegen
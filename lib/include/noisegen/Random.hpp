@@ -19,14 +19,44 @@
 
 #pragma once
 
-#include <random>
+#include <limits>
+#include <cstdint>
 
 namespace noisegen {
+/**
+ * SplitMix64 (Steele, Lea and Flood), a tiny UniformRandomBitGenerator: one add and three xor-shift-multiplies per
+ * number, 8 bytes of state. Plenty for shuffling permutations, and the same sequence on every platform.
+ */
+class SplitMix64 final
+{
+public:
+    using result_type = uint64_t;
+
+    explicit constexpr SplitMix64(uint64_t seed) noexcept : m_state{seed} {}
+
+    constexpr result_type operator()() noexcept
+    {
+        uint64_t z = (m_state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30U)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27U)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31U);
+    }
+
+    static constexpr result_type min() noexcept { return std::numeric_limits<result_type>::min(); }
+    static constexpr result_type max() noexcept { return std::numeric_limits<result_type>::max(); }
+
+private:
+    uint64_t m_state;
+};
+
 struct Random final
 {
     Random() = delete;
 
-    static std::random_device s_randomDevice;
-    static std::mt19937 s_generator;
+    /**
+     * Seed for a generator without Settings::seed: a different one on every call, thread-safe and lock-free.
+     * std::random_device is only read once per process.
+     */
+    [[nodiscard]] static uint64_t randomSeed();
 };
 }  // namespace noisegen
@@ -17,28 +17,156 @@
  * 3. This notice may not be removed or altered from any source distribution.
  */
 
+
 #pragma once
 
-#include <deque>
+#include <mutex>
 #include <chrono>
+#include <limits>
+#include <memory>
+#include <random>
 #include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
 #include <utility>
+#include <unordered_map>
 
 namespace noisegen::utils {
+/**
+ * Collects the scopes measured by ScopedProfiler.
+ *
+ * Every thread updates its own statistics and event buffer without any locking (the registry mutex is only taken
+ * once per thread, and by the readers). Reading (summary, trace, clear) must happen while no profiled scope is running.
+ * Memory is bounded however long the run: statistics are aggregated as scopes close (count, total, min, max, and a
+ * reservoir of ReservoirSize durations for the p99), and the trace keeps the last MaxTraceEvents events per thread.
+ *
+ * On exit, a per-name summary is printed to stderr, and a Chrome trace (chrome://tracing, ui.perfetto.dev) is written
+ * to the file named by the NOISEGEN_TRACE_FILE environment variable, if set.
+ */
+class Profiler final
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    using TimePoint = Clock::time_point;
+
+    static constexpr int64_t NoArgument = -1;
+    static constexpr size_t ReservoirSize = 1024;
+    static constexpr size_t MaxTraceEvents = size_t{1} << 18U;
+
+    struct Event
+    {
+        const char *name{};
+        int64_t argument{NoArgument};  // e.g. octave index, shown as "name[argument]"
+        uint64_t startNs{};            // since the profiler creation
+        uint64_t durationNs{};
+        uint32_t depth{};  // nesting level on its thread, 0 for top-level scopes
+    };
+
+    struct Aggregate
+    {
+        std::string name{};
+        uint64_t count{};
+        double totalMs{};
+        double minMs{};
+        double maxMs{};
+        double p99Ms{};
+    };
+
+    [[nodiscard]] static Profiler &instance();
+
+    Profiler(Profiler &&) = delete;
+    Profiler(const Profiler &) = delete;
+    Profiler &operator=(Profiler &&) = delete;
+    Profiler &operator=(const Profiler &) = delete;
+
+    /**
+     * @return nesting depth of the scope being entered
+     */
+    uint32_t enter();
+    void leave(const char *name, int64_t argument, TimePoint start, TimePoint end, uint32_t depth);
+    /**
+     * Add to the total of a scope recorded as a single event when the enclosing scope leaves, see
+     * AccumulatedScopedProfiler
+     */
+    void accumulate(const char *name, int64_t argument, TimePoint start, TimePoint end);
+
+    /**
+     * Per-name statistics, sorted by decreasing total time
+     */
+    [[nodiscard]] std::vector<Aggregate> aggregate() const;
+
+    void writeSummary(std::ostream &os) const;
+    void writeChromeTrace(std::ostream &os) const;
+    void clear();
+
+private:
+    using Key = std::pair<const char *, int64_t>;
+
+    struct KeyHash
+    {
+        size_t operator()(const Key &key) const noexcept
+        {
+            return std::hash<const char *>{}(key.first) ^ (std::hash<int64_t>{}(key.second) << 1U);
+        }
+    };
+
+    struct Statistics
+    {
+        uint64_t count{};
+        uint64_t totalNs{};
+        uint64_t minNs{std::numeric_limits<uint64_t>::max()};
+        uint64_t maxNs{};
+        std::vector<uint64_t> reservoir{};  // uniform sample of the durations, at most ReservoirSize
+    };
+
+    struct Accumulated
+    {
+        const char *name{};
+        int64_t argument{};
+        uint32_t depth{};  // recorded when the scope at depth - 1 leaves
+        uint64_t durationNs{};
+    };
+
+    struct ThreadBuffer
+    {
+        uint32_t threadIndex{};
+        uint32_t depth{};
+        std::unordered_map<Key, Statistics, KeyHash> statistics{};
+        std::vector<Event> events{};             // ring buffer once it holds MaxTraceEvents
+        uint64_t eventCount{};                   // ever recorded, events[eventCount % MaxTraceEvents] is the next one
+        std::vector<Accumulated> accumulated{};  // not recorded yet
+        std::minstd_rand random{};
+    };
+
+    const TimePoint m_epoch{Clock::now()};
+
+    mutable std::mutex m_mutex{};
+    std::vector<std::unique_ptr<ThreadBuffer>> m_buffers{};
+
+    Profiler() = default;
+    ~Profiler();
+
+    ThreadBuffer &threadBuffer();
+    void record(ThreadBuffer &buffer, const char *name, int64_t argument, uint64_t startNs, uint64_t durationNs,
+                uint32_t depth);
+};
+
 class ScopedProfiler final
 {
 public:
-    using Clock = std::chrono::high_resolution_clock;
-    using TimePoint = decltype(Clock::now());
-    using DurationSeconds = std::chrono::duration<double>;
-    using DurationMillis = std::chrono::duration<double, std::milli>;
+    using Clock = Profiler::Clock;
+    using TimePoint = Profiler::TimePoint;
 
 private:
-    const TimePoint m_start;
     const char *const m_name;
+    const int64_t m_argument;
+    const uint32_t m_depth;
+    const TimePoint m_start;
 
 public:
-    explicit ScopedProfiler(const char *name) noexcept;
+    explicit ScopedProfiler(const char *name, int64_t argument = Profiler::NoArgument);
     ~ScopedProfiler();
 
     ScopedProfiler(ScopedProfiler &&) = delete;
@@ -46,6 +174,32 @@ public:
     ScopedProfiler &operator=(ScopedProfiler &&) = delete;
     ScopedProfiler &operator=(const ScopedProfiler &) = delete;
 };
+
+/**
+ * Scope too short and too frequent to be an event of its own, e.g. an octave of a tile row: its durations are summed
+ * per name and argument until the enclosing ScopedProfiler leaves, then recorded as one event each (laid out one
+ * after the other from the start of the enclosing scope in the trace).
+ */
+class AccumulatedScopedProfiler final
+{
+public:
+    using Clock = Profiler::Clock;
+    using TimePoint = Profiler::TimePoint;
+
+private:
+    const char *const m_name;
+    const int64_t m_argument;
+    const TimePoint m_start;
+
+public:
+    explicit AccumulatedScopedProfiler(const char *name, int64_t argument = Profiler::NoArgument) noexcept;
+    ~AccumulatedScopedProfiler();
+
+    AccumulatedScopedProfiler(AccumulatedScopedProfiler &&) = delete;
+    AccumulatedScopedProfiler(const AccumulatedScopedProfiler &) = delete;
+    AccumulatedScopedProfiler &operator=(AccumulatedScopedProfiler &&) = delete;
+    AccumulatedScopedProfiler &operator=(const AccumulatedScopedProfiler &) = delete;
+};
 }  // namespace noisegen::utils
 
 #if NOISEGEN_WITH_PROFILER
@@ -54,6 +208,14 @@ public:
 
     #define NOISEGEN_SCOPED_PROFILER(x) \
         const noisegen::utils::ScopedProfiler NOISEGEN_SCOPED_PROFILER_COMB(NOISEGEN_SCOPED_PROFILER_, __LINE__)(x)
+    #define NOISEGEN_SCOPED_PROFILER_ARG(x, argument)                                                  \
+        const noisegen::utils::ScopedProfiler NOISEGEN_SCOPED_PROFILER_COMB(NOISEGEN_SCOPED_PROFILER_, \
+                                                                            __LINE__)(x, argument)
+    #define NOISEGEN_ACCUMULATED_PROFILER_ARG(x, argument)                                                        \
+        const noisegen::utils::AccumulatedScopedProfiler NOISEGEN_SCOPED_PROFILER_COMB(NOISEGEN_SCOPED_PROFILER_, \
+                                                                                       __LINE__)(x, argument)
 #else
-    #define NOISEGEN_SCOPED_PROFILER(x) (void) 0
+    #define NOISEGEN_SCOPED_PROFILER(x)                    (void) 0
+    #define NOISEGEN_SCOPED_PROFILER_ARG(x, argument)      (void) 0
+    #define NOISEGEN_ACCUMULATED_PROFILER_ARG(x, argument) (void) 0
 #endif
@@ -19,10 +19,42 @@
 
 #pragma once
 
+#include <string>
 #include <cstdint>
 #include <ostream>
+#include <optional>
 
 namespace noisegen {
+enum class ImageFormat
+{
+    PGMAscii,     // P2, 8-bit
+    PGMBinary8,   // P5, maxval 255
+    PGMBinary16,  // P5, maxval 65535, big-endian samples
+    Raw8,         // headerless 8-bit samples, volume slices are appended to a single file
+    Raw16,        // headerless 16-bit big-endian samples, volume slices are appended to a single file
+    PNG8,         // 8-bit grayscale PNG, deflated in parallel
+    PNG16,        // 16-bit grayscale PNG, deflated in parallel
+};
+
+enum class Normalization
+{
+    MinMax,    // actual min/max of the image, needs every sample (a first pass when streaming)
+    Fixed,     // [Settings::rangeMin, Settings::rangeMax], values outside are clamped
+    Analytic,  // theoretical bounds of the octave sum, known before rendering
+};
+
+enum class Basis
+{
+    Perlin,   // Ken Perlin's improved noise, 2^n corners per sample
+    Simplex,  // simplex noise, n + 1 corners per sample and no interpolation
+};
+
+enum class Precision
+{
+    Float,   // BasicGenerator<float>: twice the SIMD width and half the memory, plenty for 8/16-bit output
+    Double,  // BasicGenerator<double>
+};
+
 struct Settings
 {
     uint32_t width{};
@@ -30,17 +62,44 @@ struct Settings
 
     uint32_t octaves{8};
     double persistence{0.5};
+    std::string pipeline{};  // noise graph replacing the octave sum (see Pipeline.hpp), none when empty
 
     uint32_t count{1};
+    uint32_t threads{0};  // 0 for one per hardware thread
+
+    uint32_t depth{1};         // z slices of a volume or frames of an animation, 1 for planar images
+    double sliceSpacing{0.0};  // z distance between slices, 0 for the distance between rows (cubic voxels)
+
+    uint64_t maxMemory{0};  // bytes of samples kept in memory at once, 0 for no limit (see Generator::streamToPGM())
+
+    Normalization normalization{Normalization::MinMax};
+    double rangeMin{-1.0};  // Normalization::Fixed only
+    double rangeMax{1.0};   // Normalization::Fixed only
 
     bool bDryRun{false};
+    bool bPyramid{false};    // also render and write the LOD levels (see Generator::generatePyramid())
+    bool bMemoryMap{false};  // render binary formats straight into the mapped output file (see Generator::mapToPGM())
     bool bUseKenPerlinPermutations{false};
+    std::optional<uint64_t> seed{};  // permutations derived from it when set, takes precedence over Ken Perlin's
     std::string outputFile{"output.pgm"};
+    std::string normalMapFile{};  // binary PPM written by Generator::saveNormalMap(), none when empty
+    double normalStrength{64.0};  // height of the normalized range in pixels, for the normal map
+    ImageFormat format{ImageFormat::PGMBinary8};
+    Basis basis{Basis::Perlin};
+    Precision precision{Precision::Double};
 
     // Utility functions
 
     [[nodiscard]] std::string toString() const;
 };
 
+[[nodiscard]] const char *toString(ImageFormat format) noexcept;
+[[nodiscard]] bool isRawFormat(ImageFormat format) noexcept;
+[[nodiscard]] bool isPNGFormat(ImageFormat format) noexcept;
+[[nodiscard]] bool is16BitFormat(ImageFormat format) noexcept;
+[[nodiscard]] const char *toString(Normalization normalization) noexcept;
+[[nodiscard]] const char *toString(Basis basis) noexcept;
+[[nodiscard]] const char *toString(Precision precision) noexcept;
+
 std::ostream &operator<<(std::ostream &os, const noisegen::Settings &settings);
 }  // namespace noisegen
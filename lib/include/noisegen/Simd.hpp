@@ -0,0 +1,36 @@
+/*
+**   Copyright 2021 Maxime Rayé
+**
+**   Licensed under the Apache License, Version 2.0 (the "License");
+**   you may not use this file except in compliance with the License.
+**   You may obtain a copy of the License at
+**
+**       http://www.apache.org/licenses/LICENSE-2.0
+**
+**   Unless required by applicable law or agreed to in writing, software
+**   distributed under the License is distributed on an "AS IS" BASIS,
+**   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**   See the License for the specific language governing permissions and
+**   limitations under the License.
+*/
+
+#pragma once
+
+namespace noisegen::simd {
+enum class InstructionSet
+{
+    Scalar,
+    Neon,
+    Avx2,
+    Avx512,
+};
+
+/**
+ * Instruction set used by the batch noise kernels.
+ * Detected once on first use, can be lowered with the NOISEGEN_SIMD environment variable
+ * ("scalar", or "avx2" on AVX-512 CPUs), mostly for benchmarking and debugging purposes.
+ */
+[[nodiscard]] InstructionSet activeInstructionSet() noexcept;
+
+[[nodiscard]] const char *toString(InstructionSet instructionSet) noexcept;
+}  // namespace noisegen::simd
@@ -0,0 +1,116 @@
+/*
+**   Copyright 2021 Maxime Rayé
+**
+**   Licensed under the Apache License, Version 2.0 (the "License");
+**   you may not use this file except in compliance with the License.
+**   You may obtain a copy of the License at
+**
+**       http://www.apache.org/licenses/LICENSE-2.0
+**
+**   Unless required by applicable law or agreed to in writing, software
+**   distributed under the License is distributed on an "AS IS" BASIS,
+**   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**   See the License for the specific language governing permissions and
+**   limitations under the License.
+*/
+
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <condition_variable>
+
+namespace noisegen {
+/**
+ * Fixed-size pool of worker threads running work-stealing parallel loops.
+ *
+ * Each participant (the calling thread is one of them) starts with an even share of the indices, takes them one by
+ * one from the front, and once empty steals the back half of another participant's remaining share.
+ * Only one parallelFor() runs at a time, concurrent callers wait for their turn. A parallelFor() nested in a task of
+ * the same pool runs all its indices inline on the calling worker, with its workerIndex.
+ */
+class ThreadPool final
+{
+public:
+    /**
+     * @param threadCount number of threads running a parallelFor(), including the calling thread.
+     *                    0 for one per hardware thread
+     */
+    explicit ThreadPool(uint32_t threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(ThreadPool &&) = delete;
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(ThreadPool &&) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    /**
+     * Pool shared by everything asking for the same thread count, created on first use and kept until exit.
+     */
+    [[nodiscard]] static std::shared_ptr<ThreadPool> shared(uint32_t threadCount = 0);
+    /**
+     * Second pool shared like shared(), for encoders running while the next image renders on the first one: a
+     * parallelFor() on the same pool would wait for the render to finish.
+     */
+    [[nodiscard]] static std::shared_ptr<ThreadPool> sharedForOutput(uint32_t threadCount = 0);
+
+    [[nodiscard]] inline uint32_t size() const noexcept { return m_size; }
+
+    /**
+     * Call func(index, workerIndex) for every index in [0, count), and return once all of them are done.
+     * workerIndex is in [0, size()) and unique among concurrently running calls, handy for per-worker scratch memory.
+     * func must not throw.
+     */
+    template<typename F>
+    void parallelFor(uint32_t count, const F &func)
+    {
+        run(
+          count,
+          [](const void *context, uint32_t index, uint32_t workerIndex) {
+              (*static_cast<const F *>(context))(index, workerIndex);
+          },
+          &func);
+    }
+
+private:
+    using Task = void (*)(const void *context, uint32_t index, uint32_t workerIndex);
+
+    /**
+     * [begin, end) range of indices left to a participant, packed as (end << 32 | begin) so it's updated atomically
+     */
+    struct alignas(64) WorkerRange
+    {
+        std::atomic<uint64_t> range{0};
+    };
+
+    const uint32_t m_size;
+    std::vector<std::thread> m_threads{};
+    std::unique_ptr<WorkerRange[]> m_ranges;
+
+    std::mutex m_runMutex{};
+    std::mutex m_mutex{};
+    std::condition_variable m_wakeCondition{};
+    std::condition_variable m_doneCondition{};
+    uint64_t m_generation{0};
+    uint32_t m_pendingWorkers{0};
+    bool m_bStop{false};
+
+    Task m_task{};
+    const void *m_context{};
+
+    [[nodiscard]] static std::shared_ptr<ThreadPool> shared(uint32_t threadCount, bool bOutput);
+
+    void run(uint32_t count, Task task, const void *context);
+    void workerLoop(uint32_t workerIndex);
+    void work(uint32_t workerIndex) noexcept;
+
+    [[nodiscard]] bool popIndex(uint32_t workerIndex, uint32_t &index) noexcept;
+    [[nodiscard]] bool stealIndex(uint32_t workerIndex, uint32_t &index) noexcept;
+};
+}  // namespace noisegen
@@ -0,0 +1,124 @@
+/*
+**   Copyright 2021 Maxime Rayé
+**
+**   Licensed under the Apache License, Version 2.0 (the "License");
+**   you may not use this file except in compliance with the License.
+**   You may obtain a copy of the License at
+**
+**       http://www.apache.org/licenses/LICENSE-2.0
+**
+**   Unless required by applicable law or agreed to in writing, software
+**   distributed under the License is distributed on an "AS IS" BASIS,
+**   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**   See the License for the specific language governing permissions and
+**   limitations under the License.
+*/
+
+#pragma once
+
+#include <list>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+
+#include "Generator.hpp"
+#include "NoiseImage.hpp"
+#include "Settings.hpp"
+
+namespace noisegen {
+/**
+ * Thread-safe, memory-bounded LRU cache of rendered map tiles, for pan/zoom viewers.
+ *
+ * Zoom level 0 has one tile per unit of the noise plane (the span of a generate() image), each level doubles it.
+ * Tiles are rendered with BasicGenerator::generateRegion() and keyed by everything their samples depend on:
+ * the generator's permutations (what a seed determines), octaves, persistence, pipeline and basis, plus the tile
+ * coordinates.
+ * Samples are not normalized, use BasicGenerator::getNormalizationRange() with a fixed or analytic range so that
+ * neighbouring tiles match.
+ */
+template<typename Real>
+class BasicTileCache
+{
+public:
+    using Image = BasicNoiseImage<Real>;
+    using Tile = std::shared_ptr<const Image>;
+
+    struct Statistics
+    {
+        uint64_t hits{};
+        uint64_t misses{};
+        uint64_t evictions{};
+        uint64_t bytes{};
+        size_t tileCount{};
+    };
+
+    /**
+     * @param maxBytes memory of the cached samples, least recently used tiles are evicted past it
+     * @param tileSize width and height of a tile in samples, a power of two keeps tiles seamless at every zoom level
+     */
+    explicit BasicTileCache(uint64_t maxBytes, uint32_t tileSize = 256);
+
+    /**
+     * Tile (tileX, tileY) of a zoom level, rendered with generator on a miss.
+     * Two threads missing the same tile may both render it, the first one inserted is kept.
+     * A tile stays valid after its eviction, for as long as it is referenced.
+     */
+    [[nodiscard]] Tile getTile(const BasicGenerator<Real> &generator, int32_t zoom, int64_t tileX, int64_t tileY);
+
+    /**
+     * Copy a width x height window of a zoom level into out (reallocated if its size differs), starting at sample
+     * (x, y) of that level. Overlapping or repeated windows reuse the cached tiles.
+     */
+    void renderViewport(const BasicGenerator<Real> &generator, int32_t zoom, int64_t x, int64_t y, uint32_t width,
+                        uint32_t height, Image &out);
+
+    [[nodiscard]] inline uint32_t getTileSize() const noexcept { return m_tileSize; }
+    [[nodiscard]] Statistics getStatistics() const;
+    void clear();
+
+private:
+    struct Key
+    {
+        typename BasicGenerator<Real>::PermutationArray permutations{};
+        uint32_t octaves{};
+        double persistence{};
+        std::string pipeline{};
+        Basis basis{};
+        int32_t zoom{};
+        int64_t tileX{};
+        int64_t tileY{};
+
+        [[nodiscard]] bool operator==(const Key &other) const noexcept;
+    };
+
+    struct KeyHash
+    {
+        [[nodiscard]] size_t operator()(const Key &key) const noexcept;
+    };
+
+    // Most recently used first
+    using LruList = std::list<std::pair<Key, Tile>>;
+
+    const uint64_t m_maxBytes;
+    const uint32_t m_tileSize;
+
+    mutable std::mutex m_mutex{};
+    LruList m_lru{};
+    std::unordered_map<Key, typename LruList::iterator, KeyHash> m_index{};
+    Statistics m_statistics{};
+
+    [[nodiscard]] Key makeKey(const BasicGenerator<Real> &generator, int32_t zoom, int64_t tileX,
+                              int64_t tileY) const;
+    void evict();
+};
+
+// Both are compiled once, in TileCache.cpp
+extern template class BasicTileCache<float>;
+extern template class BasicTileCache<double>;
+
+using TileCache = BasicTileCache<double>;
+using TileCacheF = BasicTileCache<float>;
+}  // namespace noisegen
@@ -0,0 +1,237 @@
+/*
+**   Copyright 2021 Maxime Rayé
+**
+**   Licensed under the Apache License, Version 2.0 (the "License");
+**   you may not use this file except in compliance with the License.
+**   You may obtain a copy of the License at
+**
+**       http://www.apache.org/licenses/LICENSE-2.0
+**
+**   Unless required by applicable law or agreed to in writing, software
+**   distributed under the License is distributed on an "AS IS" BASIS,
+**   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**   See the License for the specific language governing permissions and
+**   limitations under the License.
+*/
+
+#include <string>
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <exception>
+#include <type_traits>
+
+#include "CApi.h"
+#include "Generator.hpp"
+#include "Exception.hpp"
+
+/*
+ * Every entry point catches exceptions, they must not cross the C boundary.
+ */
+
+struct noisegen_generator
+{
+    // Exactly one is set, depending on noisegen_settings::precision
+    std::unique_ptr<noisegen::Generator> generator{};
+    std::unique_ptr<noisegen::GeneratorF> generatorF{};
+};
+
+namespace {
+thread_local std::string t_lastError{};
+
+int fail(int error, std::string message)
+{
+    t_lastError = std::move(message);
+    return error;
+}
+
+noisegen::Settings toSettings(const noisegen_settings &settings)
+{
+    // Callers compiled before pipeline was added pass the smaller struct
+    if (settings.struct_size < offsetof(noisegen_settings, pipeline))
+        throw noisegen::Exception{"noisegen_settings not initialized with noisegen_settings_init()"};
+    if (settings.width == 0 || settings.height == 0)
+        throw noisegen::Exception{"width and height must be positive"};
+
+    noisegen::Settings out{};
+
+    out.width = settings.width;
+    out.height = settings.height;
+    out.octaves = settings.octaves;
+    out.persistence = settings.persistence;
+    out.threads = settings.threads;
+    out.rangeMin = settings.range_min;
+    out.rangeMax = settings.range_max;
+    out.bDryRun = true;
+    if (settings.use_seed != 0)
+        out.seed = settings.seed;
+    if (settings.struct_size >= sizeof(noisegen_settings) && settings.pipeline != nullptr)
+        out.pipeline = settings.pipeline;
+
+    switch (settings.basis)
+    {
+    case NOISEGEN_BASIS_PERLIN: out.basis = noisegen::Basis::Perlin; break;
+    case NOISEGEN_BASIS_SIMPLEX: out.basis = noisegen::Basis::Simplex; break;
+    default: throw noisegen::Exception{"unknown basis: " + std::to_string(settings.basis)};
+    }
+    switch (settings.precision)
+    {
+    case NOISEGEN_PRECISION_DOUBLE: out.precision = noisegen::Precision::Double; break;
+    case NOISEGEN_PRECISION_FLOAT: out.precision = noisegen::Precision::Float; break;
+    default: throw noisegen::Exception{"unknown precision: " + std::to_string(settings.precision)};
+    }
+    switch (settings.normalization)
+    {
+    case NOISEGEN_NORMALIZATION_MINMAX: out.normalization = noisegen::Normalization::MinMax; break;
+    case NOISEGEN_NORMALIZATION_FIXED: out.normalization = noisegen::Normalization::Fixed; break;
+    case NOISEGEN_NORMALIZATION_ANALYTIC: out.normalization = noisegen::Normalization::Analytic; break;
+    default: throw noisegen::Exception{"unknown normalization: " + std::to_string(settings.normalization)};
+    }
+    return out;
+}
+
+/**
+ * generateInto() of whichever generator is set, T decides which precisions are accepted
+ */
+template<typename T>
+int generateInto(const noisegen_generator *generator, T *out, size_t stride, double *rangeMin,
+                 double *rangeMax) noexcept
+{
+    if (generator == nullptr || out == nullptr)
+        return fail(NOISEGEN_ERROR_INVALID_ARGUMENT, "null generator or output");
+
+    const uint32_t width = generator->generator ? generator->generator->getSettings().width
+                                                : generator->generatorF->getSettings().width;
+    if (stride != 0 && stride < width)
+        return fail(NOISEGEN_ERROR_INVALID_ARGUMENT,
+                    "stride " + std::to_string(stride) + " below width " + std::to_string(width));
+
+    try
+    {
+        std::pair<double, double> range{};
+
+        if constexpr (std::is_same_v<T, double>)
+        {
+            if (!generator->generator)
+                return fail(NOISEGEN_ERROR_PRECISION, "double samples need NOISEGEN_PRECISION_DOUBLE");
+            range = generator->generator->generateInto(out, stride);
+        } else if constexpr (std::is_same_v<T, float>)
+        {
+            if (!generator->generatorF)
+                return fail(NOISEGEN_ERROR_PRECISION, "float samples need NOISEGEN_PRECISION_FLOAT");
+            range = generator->generatorF->generateInto(out, stride);
+        } else
+        {
+            range = generator->generator ? generator->generator->generateInto(out, stride)
+                                         : generator->generatorF->generateInto(out, stride);
+        }
+
+        if (rangeMin != nullptr)
+            *rangeMin = range.first;
+        if (rangeMax != nullptr)
+            *rangeMax = range.second;
+    } catch (const std::exception &e)
+    {
+        return fail(NOISEGEN_ERROR_INTERNAL, e.what());
+    } catch (...)
+    {
+        return fail(NOISEGEN_ERROR_INTERNAL, "unknown exception");
+    }
+
+    t_lastError.clear();
+    return NOISEGEN_OK;
+}
+}  // namespace
+
+void noisegen_settings_init(noisegen_settings *settings)
+{
+    if (settings == nullptr)
+        return;
+
+    const noisegen::Settings defaults{};
+
+    *settings = noisegen_settings{};
+    settings->struct_size = sizeof(noisegen_settings);
+    settings->octaves = defaults.octaves;
+    settings->persistence = defaults.persistence;
+    settings->threads = defaults.threads;
+    settings->basis = NOISEGEN_BASIS_PERLIN;
+    settings->precision = NOISEGEN_PRECISION_DOUBLE;
+    settings->normalization = NOISEGEN_NORMALIZATION_MINMAX;
+    settings->range_min = defaults.rangeMin;
+    settings->range_max = defaults.rangeMax;
+}
+
+noisegen_generator *noisegen_create(const noisegen_settings *settings)
+{
+    if (settings == nullptr)
+    {
+        fail(NOISEGEN_ERROR_INVALID_ARGUMENT, "null settings");
+        return nullptr;
+    }
+
+    try
+    {
+        auto generatorSettings = toSettings(*settings);
+        auto handle = std::make_unique<noisegen_generator>();
+
+        if (generatorSettings.precision == noisegen::Precision::Float)
+            handle->generatorF = std::make_unique<noisegen::GeneratorF>(std::move(generatorSettings));
+        else
+            handle->generator = std::make_unique<noisegen::Generator>(std::move(generatorSettings));
+
+        t_lastError.clear();
+        return handle.release();
+    } catch (const std::exception &e)
+    {
+        fail(NOISEGEN_ERROR_INVALID_ARGUMENT, e.what());
+        return nullptr;
+    } catch (...)
+    {
+        fail(NOISEGEN_ERROR_INTERNAL, "unknown exception");
+        return nullptr;
+    }
+}
+
+void noisegen_destroy(noisegen_generator *generator)
+{
+    delete generator;
+}
+
+uint64_t noisegen_get_seed(const noisegen_generator *generator)
+{
+    if (generator == nullptr)
+        return 0;
+
+    const auto seed = generator->generator ? generator->generator->getSeed() : generator->generatorF->getSeed();
+    return seed.value_or(0);
+}
+
+int noisegen_generate_f64(const noisegen_generator *generator, double *out, size_t stride, double *range_min,
+                          double *range_max)
+{
+    return generateInto(generator, out, stride, range_min, range_max);
+}
+
+int noisegen_generate_f32(const noisegen_generator *generator, float *out, size_t stride, double *range_min,
+                          double *range_max)
+{
+    return generateInto(generator, out, stride, range_min, range_max);
+}
+
+int noisegen_generate_u8(const noisegen_generator *generator, uint8_t *out, size_t stride, double *range_min,
+                         double *range_max)
+{
+    return generateInto(generator, out, stride, range_min, range_max);
+}
+
+int noisegen_generate_u16(const noisegen_generator *generator, uint16_t *out, size_t stride, double *range_min,
+                          double *range_max)
+{
+    return generateInto(generator, out, stride, range_min, range_max);
+}
+
+const char *noisegen_last_error()
+{
+    return t_lastError.c_str();
+}
@@ -14,20 +14,45 @@
 **   limitations under the License.
 */
 
-#if NOISEGEN_HAS_EXEC_POLICIES
-    #include <execution>
-    #define NOISEGEN_EXEC_PAR_UNSEC std::execution::par_unseq,
-#else
-    #define NOISEGEN_EXEC_PAR_UNSEC
-#endif
-
+#include <tuple>
+#include <array>
+#include <future>
 #include <limits>
 #include <utility>
 #include <fstream>
 #include <iostream>
 
 #include "Generator.hpp"
+#include "Exception.hpp"
+#include "PGMWriter.hpp"
+#include "MappedFile.hpp"
 #include "ScopedProfiler.hpp"
+#include "simd/Kernels.hpp"
+
+namespace {
+/**
+ * Largest |noise3D()| of the Perlin basis: the 3D peaks exceed 1 (1.0112 found by local search), unlike noise2D()
+ */
+constexpr double Perlin3DBound = 1.04;
+
+/**
+ * f(std::integral_constant<uint32_t, I>{}) for every I of the sequence, in order
+ */
+template<uint32_t... Indices, typename F>
+inline void forEachIndex(std::integer_sequence<uint32_t, Indices...>, const F &f)
+{
+    (f(std::integral_constant<uint32_t, Indices>{}), ...);
+}
+
+/**
+ * Write the low bytes of value, most significant first
+ */
+void writeBigEndian(std::ostream &os, uint64_t value, uint32_t bytes)
+{
+    for (uint32_t byte = bytes; byte-- > 0;)
+        os.put(static_cast<char>((value >> (8 * byte)) & 0xFFU));
+}
+}  // namespace
 
 /*
  * This implementation is based on Ken Perlin's original implementation.
@@ -36,21 +61,40 @@
  * Original implementation: https://mrl.cs.nyu.edu/~perlin/noise/
  */
 
-noisegen::Generator::Generator(Settings settings, const std::optional<PermutationArray> &permutationArrayOverride)
-    : m_settings{std::move(settings)}
+template<typename Real>
+noisegen::BasicGenerator<Real>::BasicGenerator(Settings settings,
+                                               const std::optional<PermutationArray> &permutationArrayOverride)
+    : m_settings{std::move(settings)}, m_threadPool{ThreadPool::shared(m_settings.threads)}
 {
     NOISEGEN_SCOPED_PROFILER("Generator()");
 
     if (permutationArrayOverride.has_value())
         m_permutations = permutationArrayOverride.value();
-    else if (!settings.bUseKenPerlinPermutations)
-        shufflePermutationArray();
+    else if (m_settings.seed.has_value())
+        m_seed = m_settings.seed;
+    else if (!m_settings.bUseKenPerlinPermutations)
+        m_seed = Random::randomSeed();
 
+    if (m_seed.has_value())
+        m_permutations = permutationsFromSeed(m_seed.value());
+
+    if (!m_settings.pipeline.empty())
+        m_pipeline = Pipeline::compile(m_settings.pipeline, noiseBound());
+
+    updatePermutationTable();
     cacheFrequencyAndAmplitude();
 }
 
-double noisegen::Generator::noise3D(double x, double y, double z) const noexcept
+template<typename Real>
+Real noisegen::BasicGenerator<Real>::noise3D(Real x, Real y, Real z) const noexcept
 {
+    if (m_settings.basis == Basis::Simplex)
+    {
+        Real out{};
+        simd::simplex3DBatchScalar(m_permutationTable.data(), &x, &y, &z, &out, 1);
+        return out;
+    }
+
     auto X = static_cast<uint8_t>(static_cast<int>(std::floor(x)) & 255);
     auto Y = static_cast<uint8_t>(static_cast<int>(std::floor(y)) & 255);
     auto Z = static_cast<uint8_t>(static_cast<int>(std::floor(z)) & 255);
@@ -59,9 +103,9 @@ double noisegen::Generator::noise3D(double x, double y, double z) const noexcept
     y -= std::floor(y);
     z -= std::floor(z);
 
-    const double u = fade(x);
-    const double v = fade(y);
-    const double w = fade(z);
+    const Real u = fade(x);
+    const Real v = fade(y);
+    const Real w = fade(z);
 
     const uint32_t A = getPermutation(X) + Y;
     const uint32_t AA = getPermutation(A) + Z;
@@ -78,66 +122,1330 @@ double noisegen::Generator::noise3D(double x, double y, double z) const noexcept
            lerp(u, grad(getPermutation(AB + 1), x, y - 1, z - 1), grad(getPermutation(BB + 1), x - 1, y - 1, z - 1))));
 }
 
-void noisegen::Generator::generate()
+template<typename Real>
+Real noisegen::BasicGenerator<Real>::noise2D(Real x, Real y) const noexcept
+{
+    if (m_settings.basis == Basis::Simplex)
+    {
+        Real out{};
+        simd::simplex2DBatchScalar(m_permutationTable.data(), &x, &y, &out, 1);
+        return out;
+    }
+
+    auto X = static_cast<uint8_t>(static_cast<int>(std::floor(x)) & 255);
+    auto Y = static_cast<uint8_t>(static_cast<int>(std::floor(y)) & 255);
+
+    x -= std::floor(x);
+    y -= std::floor(y);
+
+    const Real u = fade(x);
+    const Real v = fade(y);
+
+    const uint32_t A = getPermutation(X) + Y;
+    const uint32_t AA = getPermutation(A);
+    const uint32_t AB = getPermutation(A + 1);
+    const uint32_t B = getPermutation(X + 1) + Y;
+    const uint32_t BA = getPermutation(B);
+    const uint32_t BB = getPermutation(B + 1);
+
+    return lerp(v, lerp(u, grad(getPermutation(AA), x, y, 0), grad(getPermutation(BA), x - 1, y, 0)),
+                lerp(u, grad(getPermutation(AB), x, y - 1, 0), grad(getPermutation(BB), x - 1, y - 1, 0)));
+}
+
+template<typename Real>
+Real noisegen::BasicGenerator<Real>::noise1D(Real x) const noexcept
+{
+    if (m_settings.basis == Basis::Simplex)
+        return noise3D(x, 0, 0);
+
+    auto X = static_cast<uint8_t>(static_cast<int>(std::floor(x)) & 255);
+
+    x -= std::floor(x);
+
+    const Real u = fade(x);
+
+    const uint32_t AA = getPermutation(getPermutation(X));
+    const uint32_t BA = getPermutation(getPermutation(X + 1));
+
+    return lerp(u, grad(getPermutation(AA), x, 0, 0), grad(getPermutation(BA), x - 1, 0, 0));
+}
+
+template<typename Real>
+void noisegen::BasicGenerator<Real>::noise3DBatch(const double *xs, const double *ys, const double *zs,
+                                                  double *out, size_t n) const noexcept
+{
+    simd::basisKernels<double>(m_settings.basis).noise3D(m_permutationTable.data(), xs, ys, zs, out, n);
+}
+
+template<typename Real>
+void noisegen::BasicGenerator<Real>::noise3DBatch(const float *xs, const float *ys, const float *zs, float *out,
+                                                  size_t n) const noexcept
+{
+    simd::basisKernels<float>(m_settings.basis).noise3D(m_permutationTable.data(), xs, ys, zs, out, n);
+}
+
+template<typename Real>
+void noisegen::BasicGenerator<Real>::noise2DBatch(const double *xs, const double *ys, double *out,
+                                                  size_t n) const noexcept
+{
+    simd::basisKernels<double>(m_settings.basis).noise2D(m_permutationTable.data(), xs, ys, out, n);
+}
+
+template<typename Real>
+void noisegen::BasicGenerator<Real>::noise2DBatch(const float *xs, const float *ys, float *out,
+                                                  size_t n) const noexcept
+{
+    simd::basisKernels<float>(m_settings.basis).noise2D(m_permutationTable.data(), xs, ys, out, n);
+}
+
+template<typename Real>
+void noisegen::BasicGenerator<Real>::noise3DRow(const double *xs, double y, double z, double *out,
+                                                size_t n) const noexcept
+{
+    simd::basisKernels<double>(m_settings.basis).noise3DRow(m_permutationTable.data(), xs, y, z, out, n);
+}
+
+template<typename Real>
+void noisegen::BasicGenerator<Real>::noise3DRow(const float *xs, float y, float z, float *out,
+                                                size_t n) const noexcept
+{
+    simd::basisKernels<float>(m_settings.basis).noise3DRow(m_permutationTable.data(), xs, y, z, out, n);
+}
+
+template<typename Real>
+void noisegen::BasicGenerator<Real>::noise2DRow(const double *xs, double y, double *out,
+                                                size_t n) const noexcept
+{
+    simd::basisKernels<double>(m_settings.basis).noise2DRow(m_permutationTable.data(), xs, y, out, n);
+}
+
+template<typename Real>
+void noisegen::BasicGenerator<Real>::noise2DRow(const float *xs, float y, float *out, size_t n) const noexcept
+{
+    simd::basisKernels<float>(m_settings.basis).noise2DRow(m_permutationTable.data(), xs, y, out, n);
+}
+
+template<typename Real>
+std::array<Real, 3> noisegen::BasicGenerator<Real>::noise2DDerivatives(Real x, Real y) const noexcept
+{
+    std::array<Real, 3> out{};
+
+    if (m_settings.basis == Basis::Simplex)
+        simd::simplex2DDerivativesRowScalar(m_permutationTable.data(), &x, y, &out[0], &out[1], &out[2], 1);
+    else
+        simd::noise2DDerivativesRowScalar(m_permutationTable.data(), &x, y, &out[0], &out[1], &out[2], 1);
+    return out;
+}
+
+template<typename Real>
+void noisegen::BasicGenerator<Real>::noise2DDerivativesRow(const double *xs, double y, double *out, double *dxs,
+                                                           double *dys, size_t n) const noexcept
+{
+    simd::basisKernels<double>(m_settings.basis)
+      .noise2DDerivativesRow(m_permutationTable.data(), xs, y, out, dxs, dys, n);
+}
+
+template<typename Real>
+void noisegen::BasicGenerator<Real>::noise2DDerivativesRow(const float *xs, float y, float *out, float *dxs,
+                                                           float *dys, size_t n) const noexcept
+{
+    simd::basisKernels<float>(m_settings.basis)
+      .noise2DDerivativesRow(m_permutationTable.data(), xs, y, out, dxs, dys, n);
+}
+
+template<typename Real>
+void noisegen::BasicGenerator<Real>::generate()
 {
     NOISEGEN_SCOPED_PROFILER("Generator::generate()");
 
+    m_image = Image{m_settings.width, m_settings.height};
+
     // keep track of min and max value for scaling later
-    m_minNoiseValue = std::numeric_limits<double>::max();
-    m_maxNoiseValue = std::numeric_limits<double>::min();
+    const auto knownRange = getNormalizationRange();
+    const auto renderedRange = renderRows(imageGrid(), 0, m_settings.height, m_image, !knownRange.has_value());
+
+    std::tie(m_minNoiseValue, m_maxNoiseValue) = knownRange.value_or(renderedRange);
+}
 
-    const auto invWidth = 1.0 / m_settings.width;
-    const auto invHeight = 1.0 / m_settings.height;
+template<typename Real>
+void noisegen::BasicGenerator<Real>::generateDerivatives()
+{
+    NOISEGEN_SCOPED_PROFILER("Generator::generateDerivatives()");
 
-    m_pixels.reserve(m_settings.width * m_settings.height);
-    for (uint32_t y = 0; y < m_settings.height; y++)
-        for (uint32_t x = 0; x < m_settings.width; x++)
-            m_pixels.emplace_back(x, y);
+    if (m_pipeline.has_value())
+        throw Exception{"derivatives are only rendered for the octave sum, not for a pipeline"};
 
-    std::transform(NOISEGEN_EXEC_PAR_UNSEC m_pixels.cbegin(), m_pixels.cend(), m_pixels.begin(), [&](auto &&pixel) {
-        const auto x = pixel.x;
-        const auto y = pixel.y;
-        double noiseValue = 0.0;
+    m_image = Image{m_settings.width, m_settings.height};
+    m_derivativeX = Image{m_settings.width, m_settings.height};
+    m_derivativeY = Image{m_settings.width, m_settings.height};
+
+    const DerivativeImages derivatives{m_derivativeX, m_derivativeY};
+    const auto knownRange = getNormalizationRange();
+    const auto renderedRange =
+      renderRows(imageGrid(), 0, m_settings.height, m_image, !knownRange.has_value(), &derivatives);
+
+    std::tie(m_minNoiseValue, m_maxNoiseValue) = knownRange.value_or(renderedRange);
+}
 
-        for (uint32_t octave = 0; octave < m_settings.octaves; ++octave)
+template<typename Real>
+void noisegen::BasicGenerator<Real>::saveNormalMap() const
+{
+    NOISEGEN_SCOPED_PROFILER("Generator::saveNormalMap()");
+
+    if (m_derivativeX.width() != m_settings.width || m_derivativeX.height() != m_settings.height)
+        throw Exception{"saveNormalMap() needs generateDerivatives() first"};
+    if (m_settings.normalMapFile.empty())
+        throw Exception{"saveNormalMap() needs Settings::normalMapFile"};
+    if (m_settings.bDryRun)
+        return;
+
+    // Height slopes in pixels per pixel, the normalization range being Settings::normalStrength pixels high
+    const double range = m_maxNoiseValue - m_minNoiseValue;
+    const double heightScale = range > 0.0 ? m_settings.normalStrength / range : 0.0;
+    const auto grid = imageGrid();
+    const auto slopeX = static_cast<Real>(heightScale * static_cast<double>(grid.stepX));
+    const auto slopeY = static_cast<Real>(heightScale * static_cast<double>(grid.stepY));
+
+    const size_t rowBytes = size_t{m_settings.width} * 3;
+    std::vector<uint8_t> pixels(rowBytes * m_settings.height);
+
+    m_threadPool->parallelFor(m_settings.height, [&](uint32_t y, uint32_t) {
+        const Real *dxs = m_derivativeX.row(y);
+        const Real *dys = m_derivativeY.row(y);
+        uint8_t *out = pixels.data() + y * rowBytes;
+
+        for (uint32_t x = 0; x < m_settings.width; ++x)
         {
-            noiseValue +=
-              noise3D(x * invWidth * m_frequencyCache[octave], y * invHeight * m_frequencyCache[octave], 0) *
-              m_amplitudeCache[octave];
-        }
+            // Normal of the surface z = height(x, y): (-dz/dx, -dz/dy, 1), normalized
+            const Real nx = -dxs[x] * slopeX;
+            const Real ny = -dys[x] * slopeY;
+            const Real scale = Real{127.5} / std::sqrt(nx * nx + ny * ny + Real{1});
 
-        return Pixel(x, y, noiseValue);
+            out[3 * x] = static_cast<uint8_t>(static_cast<int32_t>(nx * scale + Real{128}));
+            out[3 * x + 1] = static_cast<uint8_t>(static_cast<int32_t>(ny * scale + Real{128}));
+            out[3 * x + 2] = static_cast<uint8_t>(static_cast<int32_t>(scale + Real{128}));
+        }
     });
 
-    const auto [min, max] = std::minmax_element(m_pixels.cbegin(), m_pixels.cend());
-
-    m_minNoiseValue = min->value;
-    m_maxNoiseValue = max->value;
+    std::ofstream file{m_settings.normalMapFile, std::ios::binary};
+    if (!file)
+        throw Exception{"can't open " + m_settings.normalMapFile};
+    file << "P6\n" << m_settings.width << ' ' << m_settings.height << "\n255\n";
+    if (!file.write(reinterpret_cast<const char *>(pixels.data()), static_cast<std::streamsize>(pixels.size())))
+        throw Exception{"can't write " + m_settings.normalMapFile};
 }
 
-void noisegen::Generator::saveToPGM() const
+template<typename Real>
+void noisegen::BasicGenerator<Real>::saveToPGM() const
 {
     NOISEGEN_SCOPED_PROFILER("Generator::saveToPGM()");
 
     if (m_settings.bDryRun)
         return;
 
-    std::ofstream file{m_settings.outputFile};
+    std::ofstream file{m_settings.outputFile, std::ios::binary};
+    if (!file)
+        throw Exception{"can't open " + m_settings.outputFile};
+
+    PGMWriter writer{file, m_settings.format, m_settings.width, m_settings.height,
+                     m_minNoiseValue, m_maxNoiseValue, outputPool()};
+
+    writer.writeRows(m_image, m_image.height());
+    writer.finish();
+    if (!file)
+        throw Exception{"can't write " + m_settings.outputFile};
+}
+
+template<typename Real>
+void noisegen::BasicGenerator<Real>::generatePyramid()
+{
+    NOISEGEN_SCOPED_PROFILER("Generator::generatePyramid()");
+
+    if (m_pipeline.has_value())
+        throw Exception{"pyramid levels drop octaves of the octave sum, not of a pipeline"};
+
+    const uint32_t levelCount = pyramidLevelCount(m_settings.width, m_settings.height);
+    std::vector<Image> levels(levelCount);
+
+    const auto knownRange = getNormalizationRange();
+    std::pair range{std::numeric_limits<double>::max(), std::numeric_limits<double>::lowest()};
+
+    // Coarsest first, each level reuses the next one
+    for (uint32_t level = levelCount; level-- > 0;)
+    {
+        const auto [width, height] = pyramidLevelSize(level);
+        levels[level] = Image{width, height};
+
+        const Image *coarser = level + 1 < levelCount ? &levels[level + 1] : nullptr;
+        const auto [min, max] = renderPyramidLevel(level, coarser, levels[level], !knownRange.has_value());
+
+        range.first = std::min(range.first, min);
+        range.second = std::max(range.second, max);
+    }
+
+    std::tie(m_minNoiseValue, m_maxNoiseValue) = knownRange.value_or(range);
+
+    m_image = std::move(levels[0]);
+    m_pyramid.assign(std::make_move_iterator(levels.begin() + 1), std::make_move_iterator(levels.end()));
+}
+
+template<typename Real>
+void noisegen::BasicGenerator<Real>::generateProgressive(const ProgressCallback &callback, uint32_t minPreviewSize)
+{
+    NOISEGEN_SCOPED_PROFILER("Generator::generateProgressive()");
+
+    if (m_pipeline.has_value())
+        throw Exception{"progressive levels drop octaves of the octave sum, not of a pipeline"};
+
+    // The coarsest level shown, rendered from scratch: the ones below it would only be reused by it
+    const uint32_t levelCount = pyramidLevelCount(m_settings.width, m_settings.height);
+    uint32_t firstLevel = 0;
+    while (firstLevel + 1 < levelCount)
+    {
+        const auto [width, height] = pyramidLevelSize(firstLevel + 1);
+        if (std::max(width, height) < minPreviewSize)
+            break;
+        ++firstLevel;
+    }
+
+    const auto knownRange = getNormalizationRange();
+    auto previewRange = knownRange.value_or(getAnalyticRange());
+    if (!(previewRange.first < previewRange.second))
+        previewRange = {previewRange.first - 1.0, previewRange.second + 1.0};
+
+    // The level being rendered and the coarser one it starts from
+    Image coarser{};
+    Image current{};
+    std::pair<double, double> range{};
+
+    for (uint32_t level = firstLevel + 1; level-- > 0;)
+    {
+        const auto [width, height] = pyramidLevelSize(level);
+        current = Image{width, height};
+
+        // Only the min/max of the image itself is needed, the previews are shown with previewRange
+        range = renderPyramidLevel(level, level < firstLevel ? &coarser : nullptr, current,
+                                   level == 0 && !knownRange.has_value());
+
+        {
+            NOISEGEN_SCOPED_PROFILER_ARG("Generator::generateProgressive() - callback", level);
+            callback(ProgressiveStage{current, level, pyramidOctaves(level), previewRange});
+        }
+        std::swap(coarser, current);
+    }
+
+    m_image = std::move(coarser);
+    std::tie(m_minNoiseValue, m_maxNoiseValue) = knownRange.value_or(range);
+}
+
+template<typename Real>
+void noisegen::BasicGenerator<Real>::savePyramid() const
+{
+    NOISEGEN_SCOPED_PROFILER("Generator::savePyramid()");
+
+    if (m_settings.bDryRun)
+        return;
+
+    const auto levelCount = static_cast<uint32_t>(m_pyramid.size() + 1);
+    const auto level = [this](uint32_t index) -> const Image & {
+        return index == 0 ? m_image : m_pyramid[index - 1];
+    };
+
+    if (!isRawFormat(m_settings.format))
+    {
+        for (uint32_t index = 0; index < levelCount; ++index)
+        {
+            const Image &image = level(index);
+            const std::string fileName = numberedFileName(m_settings.outputFile, index, levelCount);
+
+            std::ofstream file{fileName, std::ios::binary};
+            if (!file)
+                throw Exception{"can't open " + fileName};
+
+            PGMWriter writer{file, m_settings.format, image.width(), image.height(),
+                             m_minNoiseValue, m_maxNoiseValue, outputPool()};
+            writer.writeRows(image, image.height());
+            writer.finish();
+            if (!file)
+                throw Exception{"can't write " + fileName};
+        }
+        return;
+    }
+
+    std::ofstream file{m_settings.outputFile, std::ios::binary};
+    if (!file)
+        throw Exception{"can't open " + m_settings.outputFile};
+
+    // Magic, level count, then 16 bytes per level
+    file.write("NGPYRAMD", 8);
+    writeBigEndian(file, levelCount, 4);
+
+    const uint64_t sampleSize = is16BitFormat(m_settings.format) ? 2 : 1;
+    uint64_t offset = 12 + 16 * uint64_t{levelCount};
+    for (uint32_t index = 0; index < levelCount; ++index)
+    {
+        const Image &image = level(index);
+
+        writeBigEndian(file, image.width(), 4);
+        writeBigEndian(file, image.height(), 4);
+        writeBigEndian(file, offset, 8);
+        offset += uint64_t{image.width()} * image.height() * sampleSize;
+    }
+
+    for (uint32_t index = 0; index < levelCount; ++index)
+    {
+        const Image &image = level(index);
+
+        PGMWriter writer{file, m_settings.format, image.width(), image.height(),
+                         m_minNoiseValue, m_maxNoiseValue, outputPool()};
+        writer.writeRows(image, image.height());
+        writer.finish();
+    }
+
+    if (!file)
+        throw Exception{"can't write " + m_settings.outputFile};
+}
+
+template<typename Real>
+void noisegen::BasicGenerator<Real>::streamToPGM()
+{
+    NOISEGEN_SCOPED_PROFILER("Generator::streamToPGM()");
+
+    const uint32_t bandHeight = streamingBandHeight();
+    Image band{m_settings.width, bandHeight};
+
+    // Opened first, not to find out after the min/max pass
+    std::ofstream file{};
+    if (!m_settings.bDryRun)
+    {
+        file.open(m_settings.outputFile, std::ios::binary);
+        if (!file)
+            throw Exception{"can't open " + m_settings.outputFile};
+    }
+
+    if (const auto knownRange = getNormalizationRange(); knownRange.has_value())
+        std::tie(m_minNoiseValue, m_maxNoiseValue) = *knownRange;
+    else
+    {
+        NOISEGEN_SCOPED_PROFILER("Generator::streamToPGM() - min/max pass");
+
+        m_minNoiseValue = std::numeric_limits<double>::max();
+        m_maxNoiseValue = std::numeric_limits<double>::lowest();
+
+        for (uint32_t firstRow = 0; firstRow < m_settings.height; firstRow += bandHeight)
+        {
+            const uint32_t rowCount = std::min(bandHeight, m_settings.height - firstRow);
+
+            const auto [min, max] = renderRows(imageGrid(), firstRow, rowCount, band, true);
+            m_minNoiseValue = std::min(m_minNoiseValue, min);
+            m_maxNoiseValue = std::max(m_maxNoiseValue, max);
+        }
+    }
+
+    std::optional<PGMWriter> writer{};
+    if (!m_settings.bDryRun)
+        writer.emplace(file, m_settings.format, m_settings.width, m_settings.height, m_minNoiseValue,
+                       m_maxNoiseValue, outputPool());
+
+    for (uint32_t firstRow = 0; firstRow < m_settings.height; firstRow += bandHeight)
+    {
+        const uint32_t rowCount = std::min(bandHeight, m_settings.height - firstRow);
+
+        renderRows(imageGrid(), firstRow, rowCount, band, false);
+        if (writer.has_value())
+            writer->writeRows(band, rowCount);
+    }
+
+    if (writer.has_value())
+    {
+        writer->finish();
+        if (!file)
+            throw Exception{"can't write " + m_settings.outputFile};
+    }
+}
+
+template<typename Real>
+void noisegen::BasicGenerator<Real>::generateVolume()
+{
+    NOISEGEN_SCOPED_PROFILER("Generator::generateVolume()");
+
+    // The slice being rendered and the previous one, being written. When two slices don't fit in
+    // Settings::maxMemory, a single band is kept instead and slices are rendered and written band by band.
+    const uint64_t sliceBytes = uint64_t{m_settings.width} * m_settings.height * sizeof(Real);
+    const bool bBanded = m_settings.maxMemory != 0 && 2 * sliceBytes > m_settings.maxMemory;
+    const uint32_t bandHeight = bBanded ? streamingBandHeight() : m_settings.height;
+
+    std::array<Image, 2> slices{Image{m_settings.width, bandHeight},
+                                bBanded ? Image{} : Image{m_settings.width, m_settings.height}};
+
+    if (const auto knownRange = getNormalizationRange(); knownRange.has_value())
+        std::tie(m_minNoiseValue, m_maxNoiseValue) = *knownRange;
+    else
+    {
+        NOISEGEN_SCOPED_PROFILER("Generator::generateVolume() - min/max pass");
+
+        m_minNoiseValue = std::numeric_limits<double>::max();
+        m_maxNoiseValue = std::numeric_limits<double>::lowest();
+
+        for (uint32_t slice = 0; slice < m_settings.depth; ++slice)
+        {
+            for (uint32_t firstRow = 0; firstRow < m_settings.height; firstRow += bandHeight)
+            {
+                const uint32_t rowCount = std::min(bandHeight, m_settings.height - firstRow);
+
+                const auto [min, max] = renderRows(imageGrid(sliceZ(slice)), firstRow, rowCount, slices[0], true);
+                m_minNoiseValue = std::min(m_minNoiseValue, min);
+                m_maxNoiseValue = std::max(m_maxNoiseValue, max);
+            }
+        }
+    }
+
+    const bool bSingleFile = isRawFormat(m_settings.format);
+
+    const auto fileName = [&](uint32_t slice) {
+        return bSingleFile ? m_settings.outputFile : numberedFileName(m_settings.outputFile, slice, m_settings.depth);
+    };
+
+    std::ofstream volumeFile{};
+    if (!m_settings.bDryRun && bSingleFile)
+    {
+        volumeFile.open(m_settings.outputFile, std::ios::binary);
+        if (!volumeFile)
+            throw Exception{"can't open " + m_settings.outputFile};
+    }
+
+    const auto openSlice = [&](std::ofstream &sliceFile, uint32_t slice) -> std::ofstream & {
+        if (bSingleFile)
+            return volumeFile;
+
+        sliceFile.open(fileName(slice), std::ios::binary);
+        if (!sliceFile)
+            throw Exception{"can't open " + fileName(slice)};
+        return sliceFile;
+    };
+
+    const auto writeSlice = [&](const Image &image, uint32_t slice) {
+        NOISEGEN_SCOPED_PROFILER_ARG("Generator::generateVolume() - write", slice);
+
+        std::ofstream sliceFile{};
+        std::ofstream &file = openSlice(sliceFile, slice);
+
+        PGMWriter writer{file, m_settings.format, m_settings.width, m_settings.height,
+                         m_minNoiseValue, m_maxNoiseValue, outputPool()};
+        writer.writeRows(image, image.height());
+        writer.finish();
+        if (!file)
+            throw Exception{"can't write " + fileName(slice)};
+    };
+
+    if (bBanded)
+    {
+        // Same as streamToPGM(), slice after slice: no overlap between rendering and writing
+        for (uint32_t slice = 0; slice < m_settings.depth; ++slice)
+        {
+            std::ofstream sliceFile{};
+            std::ofstream &file = m_settings.bDryRun ? sliceFile : openSlice(sliceFile, slice);
+            std::optional<PGMWriter> writer{};
+            if (!m_settings.bDryRun)
+                writer.emplace(file, m_settings.format, m_settings.width, m_settings.height, m_minNoiseValue,
+                               m_maxNoiseValue, outputPool());
+
+            for (uint32_t firstRow = 0; firstRow < m_settings.height; firstRow += bandHeight)
+            {
+                const uint32_t rowCount = std::min(bandHeight, m_settings.height - firstRow);
+
+                renderRows(imageGrid(sliceZ(slice)), firstRow, rowCount, slices[0], false);
+                if (writer.has_value())
+                    writer->writeRows(slices[0], rowCount);
+            }
+
+            if (writer.has_value())
+            {
+                writer->finish();
+                if (!file)
+                    throw Exception{"can't write " + fileName(slice)};
+            }
+        }
+        return;
+    }
+
+    std::future<void> pendingWrite{};
+
+    for (uint32_t slice = 0; slice < m_settings.depth; ++slice)
+    {
+        Image &image = slices[slice % 2];
+        renderRows(imageGrid(sliceZ(slice)), 0, m_settings.height, image, false);
+
+        // Slices are written in order, and the other buffer is free again for slice + 1
+        if (pendingWrite.valid())
+            pendingWrite.get();
+        if (!m_settings.bDryRun)
+            pendingWrite = std::async(std::launch::async, writeSlice, std::cref(image), slice);
+    }
+
+    if (pendingWrite.valid())
+        pendingWrite.get();
+}
+
+template<typename Real>
+void noisegen::BasicGenerator<Real>::generateRegion(double offsetX, double offsetY, double scale, uint32_t width,
+                                                    uint32_t height, Image &out) const
+{
+    NOISEGEN_SCOPED_PROFILER("Generator::generateRegion()");
+
+    if (out.width() != width || out.height() != height)
+        out = Image{width, height};
+
+    const SampleGrid grid{static_cast<Real>(offsetX), static_cast<Real>(offsetY), static_cast<Real>(scale),
+                          static_cast<Real>(scale)};
+    renderRows(grid, 0, height, out, false);
+}
+
+template<typename Real>
+std::pair<double, double> noisegen::BasicGenerator<Real>::generateInto(Real *out, size_t stride) const
+{
+    NOISEGEN_SCOPED_PROFILER("Generator::generateInto()");
+
+    const size_t rowStride = stride == 0 ? m_settings.width : stride;
+    const auto knownRange = getNormalizationRange();
+
+    const auto renderedRange = renderRows(
+      imageGrid(), 0, m_settings.height, m_settings.width, !knownRange.has_value(),
+      [out, rowStride](uint32_t row, uint32_t x, Real *) { return out + row * rowStride + x; },
+      [](uint32_t, uint32_t, const Real *, uint32_t) {});
+
+    return knownRange.value_or(renderedRange);
+}
+
+template<typename Real>
+std::pair<double, double> noisegen::BasicGenerator<Real>::generateInto(uint8_t *out, size_t stride) const
+{
+    const size_t rowStride = stride == 0 ? m_settings.width : stride;
+
+    return generateQuantized([out, rowStride](const Real *values, uint32_t n, const std::pair<double, double> &range,
+                                              uint32_t row, uint32_t x) {
+        PGMWriter::quantize8(values, n, range.first, range.second, out + row * rowStride + x);
+    });
+}
+
+template<typename Real>
+std::pair<double, double> noisegen::BasicGenerator<Real>::generateInto(uint16_t *out, size_t stride) const
+{
+    const size_t rowStride = stride == 0 ? m_settings.width : stride;
+
+    return generateQuantized([out, rowStride](const Real *values, uint32_t n, const std::pair<double, double> &range,
+                                              uint32_t row, uint32_t x) {
+        PGMWriter::quantize16(values, n, range.first, range.second, out + row * rowStride + x);
+    });
+}
+
+template<typename Real>
+template<typename Quantize>
+std::pair<double, double> noisegen::BasicGenerator<Real>::generateQuantized(const Quantize &quantize) const
+{
+    NOISEGEN_SCOPED_PROFILER("Generator::generateQuantized()");
+
+    const auto scratchDestination = [](uint32_t, uint32_t, Real *scratch) { return scratch; };
+
+    std::pair<double, double> range{};
+    if (const auto knownRange = getNormalizationRange(); knownRange.has_value())
+        range = *knownRange;
+    else
+    {
+        NOISEGEN_SCOPED_PROFILER("Generator::generateQuantized() - min/max pass");
+
+        range = renderRows(imageGrid(), 0, m_settings.height, m_settings.width, true, scratchDestination,
+                           [](uint32_t, uint32_t, const Real *, uint32_t) {});
+    }
+
+    renderRows(imageGrid(), 0, m_settings.height, m_settings.width, false, scratchDestination,
+               [&quantize, &range](uint32_t row, uint32_t x, const Real *values, uint32_t n) {
+                   quantize(values, n, range, row, x);
+               });
+
+    return range;
+}
+
+template<typename Real>
+void noisegen::BasicGenerator<Real>::mapToPGM()
+{
+    NOISEGEN_SCOPED_PROFILER("Generator::mapToPGM()");
+
+    // Text and compressed sizes aren't known before the pixels are
+    if (m_settings.format == ImageFormat::PGMAscii || isPNGFormat(m_settings.format) || !MappedFile::IsSupported
+        || m_settings.bDryRun)
+    {
+        if (fitsInMemory())
+        {
+            generate();
+            saveToPGM();
+        } else
+            streamToPGM();
+        return;
+    }
+
+    const bool b16Bit = is16BitFormat(m_settings.format);
+    const size_t rowBytes = size_t{m_settings.width} * (b16Bit ? 2 : 1);
+    const std::string header = PGMWriter::header(m_settings.format, m_settings.width, m_settings.height);
+
+    MappedFile file{m_settings.outputFile, header.size() + rowBytes * m_settings.height};
+    std::copy(header.cbegin(), header.cend(), file.data());
+    uint8_t *pixels = file.data() + header.size();
+
+    // PGM wants big-endian 16-bit samples, the byte-oriented quantize16() writes them in that order
+    std::tie(m_minNoiseValue, m_maxNoiseValue) =
+      generateQuantized([pixels, rowBytes, b16Bit](const Real *values, uint32_t n,
+                                                   const std::pair<double, double> &range, uint32_t row, uint32_t x) {
+          uint8_t *out = pixels + row * rowBytes;
+          if (b16Bit)
+              PGMWriter::quantize16(values, n, range.first, range.second, out + 2 * size_t{x});
+          else
+              PGMWriter::quantize8(values, n, range.first, range.second, out + x);
+      });
+
+    file.finish();
+}
+
+template<typename Real>
+bool noisegen::BasicGenerator<Real>::fitsInMemory() const noexcept
+{
+    const uint64_t imageBytes = uint64_t{m_settings.width} * m_settings.height * sizeof(Real);
+
+    return m_settings.maxMemory == 0 || imageBytes <= m_settings.maxMemory;
+}
+
+template<typename Real>
+std::optional<std::pair<double, double>> noisegen::BasicGenerator<Real>::getNormalizationRange() const noexcept
+{
+    switch (m_settings.normalization)
+    {
+    case Normalization::Fixed: return std::make_pair(m_settings.rangeMin, m_settings.rangeMax);
+    case Normalization::Analytic: return getAnalyticRange();
+    case Normalization::MinMax: break;
+    }
+    return std::nullopt;
+}
+
+template<typename Real>
+std::pair<double, double> noisegen::BasicGenerator<Real>::getAnalyticRange() const noexcept
+{
+    if (m_pipeline.has_value())
+        return m_pipeline->getBounds();
+
+    // Every sample is noise2D() (or noise3D() for volumes) scaled by its amplitude
+    double bound = 0.0;
+    for (const Real amplitude : m_amplitudeCache)
+        bound += static_cast<double>(std::abs(amplitude));
+    bound *= noiseBound();
+    return std::make_pair(-bound, bound);
+}
+
+template<typename Real>
+double noisegen::BasicGenerator<Real>::noiseBound() const noexcept
+{
+    // Perlin 2D: gradients have a length of sqrt(2), the peaks are 1. Simplex: scaled to [-1, 1] in 2D and 3D, see
+    // SimplexKernel.hpp. Slices of a volume vary z, the Perlin 3D peaks are a little higher.
+    return m_settings.depth > 1 && m_settings.basis == Basis::Perlin ? Perlin3DBound : 1.0;
+}
+
+template<typename Real>
+typename noisegen::BasicGenerator<Real>::SampleGrid
+noisegen::BasicGenerator<Real>::imageGrid(std::optional<Real> z) const noexcept
+{
+    return {Real{0}, Real{0}, Real{1} / static_cast<Real>(m_settings.width),
+            Real{1} / static_cast<Real>(m_settings.height), z};
+}
+
+template<typename Real>
+std::pair<double, double> noisegen::BasicGenerator<Real>::renderRows(const SampleGrid &grid, uint32_t firstRow,
+                                                                     uint32_t rowCount, Image &out,
+                                                                     bool bTrackRange,
+                                                                     const DerivativeImages *derivatives) const
+{
+    return renderRows(
+      grid, firstRow, rowCount, out.width(), bTrackRange,
+      [&out](uint32_t row, uint32_t x, Real *) { return out.row(row) + x; },
+      [](uint32_t, uint32_t, const Real *, uint32_t) {}, derivatives);
+}
+
+template<typename Real>
+template<typename Destination, typename Store>
+std::pair<double, double> noisegen::BasicGenerator<Real>::renderRows(const SampleGrid &grid, uint32_t firstRow,
+                                                                     uint32_t rowCount, uint32_t width,
+                                                                     bool bTrackRange, const Destination &destination,
+                                                                     const Store &store,
+                                                                     const DerivativeImages *derivatives) const
+{
+    NOISEGEN_SCOPED_PROFILER("Generator::renderRows()");
+
+    // x coordinates only depend on the octave, compute them once for every row
+    // A pipeline scales them itself, it only needs the ones of the grid
+    const uint32_t xsRows = m_pipeline.has_value() ? 1 : m_settings.octaves;
+    std::vector<Real> xsPerOctave(static_cast<size_t>(xsRows) * width);
+    for (uint32_t octave = 0; octave < xsRows; ++octave)
+    {
+        const Real frequency = m_pipeline.has_value() ? Real{1} : m_frequencyCache[octave];
+        for (uint32_t x = 0; x < width; ++x)
+            xsPerOctave[static_cast<size_t>(octave) * width + x] =
+              (grid.originX + static_cast<Real>(x) * grid.stepX) * frequency;
+    }
+
+    // Aligned to keep the min/max of each worker on its own cache line
+    struct alignas(64) Scratch
+    {
+        std::vector<Real> samples = std::vector<Real>(3 * TileWidth);  // derivatives of the samples follow them
+        std::vector<Real> values = std::vector<Real>(TileWidth);
+        Real minValue = std::numeric_limits<Real>::max();
+        Real maxValue = std::numeric_limits<Real>::lowest();
+    };
+    std::vector<Scratch> scratches(m_threadPool->size());
+    if (m_pipeline.has_value())
+        for (auto &scratch : scratches)
+            scratch.samples.resize(pipelineScratchSize());
+
+    const auto renderTileRowFunction = selectRenderTileRow();
+
+    const uint32_t tilesX = (width + TileWidth - 1) / TileWidth;
+    const uint32_t tilesY = (rowCount + TileHeight - 1) / TileHeight;
+
+    m_threadPool->parallelFor(tilesX * tilesY, [&](uint32_t tile, uint32_t workerIndex) {
+        NOISEGEN_SCOPED_PROFILER("Generator::renderRows() - tile");
+
+        auto &[samples, scratchValues, minValue, maxValue] = scratches[workerIndex];
+
+        const uint32_t tileX = tile % tilesX * TileWidth;
+        const uint32_t tileY = tile / tilesX * TileHeight;
+        const uint32_t tileWidth = std::min(TileWidth, width - tileX);
+        const uint32_t tileHeight = std::min(TileHeight, rowCount - tileY);
+
+        for (uint32_t row = tileY; row < tileY + tileHeight; ++row)
+        {
+            const uint32_t y = firstRow + row;
+
+            const Real gridY = grid.originY + static_cast<Real>(y) * grid.stepY;
+
+            Real *values = destination(row, tileX, scratchValues.data());
+            if (m_pipeline.has_value())
+                renderTileRowPipeline(&xsPerOctave[tileX], gridY, grid.z, samples.data(), values, tileWidth);
+            else if (derivatives != nullptr)
+                renderTileRowDerivatives(&xsPerOctave[tileX], width, gridY, samples.data(), values,
+                                         derivatives->dx.row(row) + tileX, derivatives->dy.row(row) + tileX, tileWidth);
+            else if (grid.z.has_value())
+                renderTileRow3D(&xsPerOctave[tileX], width, gridY, *grid.z, samples.data(), values, tileWidth);
+            else
+                (this->*renderTileRowFunction)(&xsPerOctave[tileX], width, gridY, samples.data(), values, tileWidth);
+
+            // The row is still in L1, tracking the range here saves another pass over the whole image
+            if (bTrackRange)
+            {
+                const auto [min, max] = std::minmax_element(values, values + tileWidth);
+
+                minValue = std::min(minValue, *min);
+                maxValue = std::max(maxValue, *max);
+            }
+            store(row, tileX, values, tileWidth);
+        }
+    });
+
+    std::pair range{std::numeric_limits<Real>::max(), std::numeric_limits<Real>::lowest()};
+    for (const auto &scratch : scratches)
+    {
+        range.first = std::min(range.first, scratch.minValue);
+        range.second = std::max(range.second, scratch.maxValue);
+    }
+    return {static_cast<double>(range.first), static_cast<double>(range.second)};
+}
+
+template<typename Real>
+std::pair<double, double> noisegen::BasicGenerator<Real>::renderPyramidLevel(uint32_t level, const Image *coarser,
+                                                                             Image &out, bool bTrackRange) const
+{
+    NOISEGEN_SCOPED_PROFILER_ARG("Generator::renderPyramidLevel()", level);
+
+    const uint32_t width = out.width();
+    const uint32_t height = out.height();
+    const uint32_t octaves = pyramidOctaves(level);
+    const uint32_t reusedOctaves = coarser != nullptr ? pyramidOctaves(level + 1) : 0;
+
+    // Scaling by a power of two is exact: sample (x, y) has the coordinates of sample (x * 2^level, y * 2^level) of
+    // generate(), and even samples the ones of the coarser level
+    const SampleGrid image = imageGrid();
+    const auto scale = static_cast<Real>(std::ldexp(1.0, static_cast<int>(level)));
+    const Real stepX = image.stepX * scale;
+    const Real stepY = image.stepY * scale;
+
+    std::vector<Real> xsPerOctave(static_cast<size_t>(octaves) * width);
+    for (uint32_t octave = 0; octave < octaves; ++octave)
+        for (uint32_t x = 0; x < width; ++x)
+            xsPerOctave[static_cast<size_t>(octave) * width + x] =
+              static_cast<Real>(x) * stepX * m_frequencyCache[octave];
+
+    // Aligned to keep the min/max of each worker on its own cache line
+    struct alignas(64) Scratch
+    {
+        std::vector<Real> samples = std::vector<Real>(TileWidth);
+        std::vector<Real> oddXs = std::vector<Real>(TileWidth / 2);
+        std::vector<Real> oddValues = std::vector<Real>(TileWidth / 2);
+        Real minValue = std::numeric_limits<Real>::max();
+        Real maxValue = std::numeric_limits<Real>::lowest();
+    };
+    std::vector<Scratch> scratches(m_threadPool->size());
+
+    const auto renderTileRowFunction = selectRenderTileRow();
+
+    const uint32_t tilesX = (width + TileWidth - 1) / TileWidth;
+    const uint32_t tilesY = (height + TileHeight - 1) / TileHeight;
+
+    m_threadPool->parallelFor(tilesX * tilesY, [&](uint32_t tile, uint32_t workerIndex) {
+        NOISEGEN_SCOPED_PROFILER("Generator::renderPyramidLevel() - tile");
+
+        auto &[samples, oddXs, oddValues, minValue, maxValue] = scratches[workerIndex];
+
+        // TileWidth is even, columns of the same parity as the tile's
+        const uint32_t tileX = tile % tilesX * TileWidth;
+        const uint32_t tileY = tile / tilesX * TileHeight;
+        const uint32_t tileWidth = std::min(TileWidth, width - tileX);
+        const uint32_t tileHeight = std::min(TileHeight, height - tileY);
+
+        for (uint32_t y = tileY; y < tileY + tileHeight; ++y)
+        {
+            const Real gridY = static_cast<Real>(y) * stepY;
+            Real *values = out.row(y) + tileX;
+            uint32_t firstOctave = 0;
+
+            if (coarser != nullptr && y % 2 == 0)
+            {
+                // Only odd columns need the octaves of the coarser level, even ones already have their sum
+                const uint32_t oddCount = tileWidth / 2;
+                std::fill(oddValues.begin(), oddValues.end(), Real{0});
+
+                for (uint32_t octave = 0; octave < reusedOctaves; ++octave)
+                {
+                    const Real *xs = &xsPerOctave[static_cast<size_t>(octave) * width + tileX];
+                    for (uint32_t x = 0; x < oddCount; ++x)
+                        oddXs[x] = xs[2 * x + 1];
+
+                    noise2DRow(oddXs.data(), gridY * m_frequencyCache[octave], samples.data(), oddCount);
+
+                    const Real amplitude = m_amplitudeCache[octave];
+                    for (uint32_t x = 0; x < oddCount; ++x)
+                        oddValues[x] += samples[x] * amplitude;
+                }
+
+                const Real *coarse = coarser->row(y / 2) + tileX / 2;
+                for (uint32_t x = 0; x < tileWidth; ++x)
+                    values[x] = x % 2 == 0 ? coarse[x / 2] : oddValues[x / 2];
+                firstOctave = reusedOctaves;
+            } else if (octaves == m_settings.octaves)
+            {
+                // Every octave, same coordinates as the octave sum of renderRows()
+                (this->*renderTileRowFunction)(&xsPerOctave[tileX], width, gridY, samples.data(), values, tileWidth);
+                firstOctave = octaves;
+            } else
+                std::fill(values, values + tileWidth, Real{0});
+
+            for (uint32_t octave = firstOctave; octave < octaves; ++octave)
+            {
+                noise2DRow(&xsPerOctave[static_cast<size_t>(octave) * width + tileX], gridY * m_frequencyCache[octave],
+                           samples.data(), tileWidth);
+
+                const Real amplitude = m_amplitudeCache[octave];
+                for (uint32_t x = 0; x < tileWidth; ++x)
+                    values[x] += samples[x] * amplitude;
+            }
+
+            if (bTrackRange)
+            {
+                const auto [min, max] = std::minmax_element(values, values + tileWidth);
+
+                minValue = std::min(minValue, *min);
+                maxValue = std::max(maxValue, *max);
+            }
+        }
+    });
+
+    std::pair range{std::numeric_limits<Real>::max(), std::numeric_limits<Real>::lowest()};
+    for (const auto &scratch : scratches)
+    {
+        range.first = std::min(range.first, scratch.minValue);
+        range.second = std::max(range.second, scratch.maxValue);
+    }
+    return {static_cast<double>(range.first), static_cast<double>(range.second)};
+}
+
+template<typename Real>
+typename noisegen::BasicGenerator<Real>::RenderTileRowFunction
+noisegen::BasicGenerator<Real>::selectRenderTileRow() const noexcept
+{
+    static_assert(MaxUnrolledOctaves == 12, "update the cases below");
+
+    switch (m_settings.octaves)
+    {
+    case 1: return &BasicGenerator::renderTileRowUnrolled<1>;
+    case 2: return &BasicGenerator::renderTileRowUnrolled<2>;
+    case 3: return &BasicGenerator::renderTileRowUnrolled<3>;
+    case 4: return &BasicGenerator::renderTileRowUnrolled<4>;
+    case 5: return &BasicGenerator::renderTileRowUnrolled<5>;
+    case 6: return &BasicGenerator::renderTileRowUnrolled<6>;
+    case 7: return &BasicGenerator::renderTileRowUnrolled<7>;
+    case 8: return &BasicGenerator::renderTileRowUnrolled<8>;
+    case 9: return &BasicGenerator::renderTileRowUnrolled<9>;
+    case 10: return &BasicGenerator::renderTileRowUnrolled<10>;
+    case 11: return &BasicGenerator::renderTileRowUnrolled<11>;
+    case 12: return &BasicGenerator::renderTileRowUnrolled<12>;
+    default: return &BasicGenerator::renderTileRow;
+    }
+}
+
+template<typename Real>
+void noisegen::BasicGenerator<Real>::renderTileRow(const Real *xs, size_t stride, Real y, Real *samples,
+                                                   Real *values, uint32_t n) const noexcept
+{
+    std::fill(values, values + n, Real{0});
+
+    for (uint32_t octave = 0; octave < m_settings.octaves; ++octave)
+    {
+        NOISEGEN_ACCUMULATED_PROFILER_ARG("Generator::renderRows() - octave", octave);
+
+        // z is always 0 for images, the 2D kernel gives the same values for half the work,
+        // and the row kernel reuses the lattice cell data across the many pixels of low octaves
+        noise2DRow(xs + octave * stride, y * m_frequencyCache[octave], samples, n);
+
+        const Real amplitude = m_amplitudeCache[octave];
+        for (uint32_t x = 0; x < n; ++x)
+            values[x] += samples[x] * amplitude;
+    }
+}
+
+template<typename Real>
+template<uint32_t Octaves>
+void noisegen::BasicGenerator<Real>::renderTileRowUnrolled(const Real *xs, size_t stride, Real y, Real *samples,
+                                                           Real *values, uint32_t n) const noexcept
+{
+    static_assert(Octaves > 0 && Octaves <= MaxUnrolledOctaves);
+
+    forEachIndex(std::make_integer_sequence<uint32_t, Octaves>{}, [&](auto index) {
+        constexpr uint32_t Octave = decltype(index)::value;
+        // Same value as m_frequencyCache[Octave], pow(2, octave) is exact
+        constexpr Real Frequency = static_cast<Real>(1U << Octave);
+
+        NOISEGEN_ACCUMULATED_PROFILER_ARG("Generator::renderRows() - octave", Octave);
+
+        noise2DRow(xs + Octave * stride, y * Frequency, samples, n);
+
+        const Real amplitude = m_amplitudeCache[Octave];
+        if constexpr (Octave == 0)
+        {
+            // The first octave initializes the row, no need to clear it beforehand
+            for (uint32_t x = 0; x < n; ++x)
+                values[x] = samples[x] * amplitude;
+        } else
+        {
+            for (uint32_t x = 0; x < n; ++x)
+                values[x] += samples[x] * amplitude;
+        }
+    });
+}
+
+template<typename Real>
+void noisegen::BasicGenerator<Real>::renderTileRow3D(const Real *xs, size_t stride, Real y, Real z, Real *samples,
+                                                     Real *values, uint32_t n) const noexcept
+{
+    std::fill(values, values + n, Real{0});
+
+    for (uint32_t octave = 0; octave < m_settings.octaves; ++octave)
+    {
+        NOISEGEN_ACCUMULATED_PROFILER_ARG("Generator::renderRows() - octave", octave);
+
+        const Real frequency = m_frequencyCache[octave];
+        noise3DRow(xs + octave * stride, y * frequency, z * frequency, samples, n);
+
+        const Real amplitude = m_amplitudeCache[octave];
+        for (uint32_t x = 0; x < n; ++x)
+            values[x] += samples[x] * amplitude;
+    }
+}
+
+template<typename Real>
+void noisegen::BasicGenerator<Real>::renderTileRowDerivatives(const Real *xs, size_t stride, Real y, Real *samples,
+                                                              Real *values, Real *dxs, Real *dys,
+                                                              uint32_t n) const noexcept
+{
+    std::fill(values, values + n, Real{0});
+    std::fill(dxs, dxs + n, Real{0});
+    std::fill(dys, dys + n, Real{0});
+
+    Real *sampleDxs = samples + TileWidth;
+    Real *sampleDys = samples + 2 * TileWidth;
+
+    for (uint32_t octave = 0; octave < m_settings.octaves; ++octave)
+    {
+        NOISEGEN_ACCUMULATED_PROFILER_ARG("Generator::renderRows() - octave", octave);
+
+        const Real frequency = m_frequencyCache[octave];
+        noise2DDerivativesRow(xs + octave * stride, y * frequency, samples, sampleDxs, sampleDys, n);
+
+        // d/dx amplitude * noise(frequency * x) = amplitude * frequency * noise'(frequency * x)
+        const Real amplitude = m_amplitudeCache[octave];
+        const Real slope = amplitude * frequency;
+        for (uint32_t x = 0; x < n; ++x)
+        {
+            values[x] += samples[x] * amplitude;
+            dxs[x] += sampleDxs[x] * slope;
+            dys[x] += sampleDys[x] * slope;
+        }
+    }
+}
+
+template<typename Real>
+void noisegen::BasicGenerator<Real>::renderTileRowPipeline(const Real *xs, Real y, std::optional<Real> z,
+                                                           Real *scratch, Real *values, uint32_t n) const noexcept
+{
+    const uint32_t registerCount = m_pipeline->getRegisterCount();
+    const auto field = [scratch](uint32_t index) { return scratch + static_cast<size_t>(index) * TileWidth; };
+    // Context c > 0 has its x coordinates in field(registerCount + 2 * (c - 1)), followed by its y coordinates
+    const auto contextXs = [&](uint32_t context) { return context == 0 ? xs : field(registerCount + 2 * context - 2); };
+    const auto contextYs = [&](uint32_t context) {
+        return context == 0 ? nullptr : field(registerCount + 2 * context - 1);
+    };
+    Real *buffers = field(registerCount + 2 * (m_pipeline->getContextCount() - 1));
+
+    for (const auto &instruction : m_pipeline->getInstructions())
+    {
+        Real *out = field(instruction.output);
+        const Real *a = field(instruction.a);
+        const Real *b = field(instruction.b);
+
+        switch (instruction.op)
+        {
+        case Pipeline::Op::Constant: std::fill(out, out + n, static_cast<Real>(instruction.value)); break;
+        case Pipeline::Op::Fractal:
+            renderFractal(instruction, contextXs(instruction.context), contextYs(instruction.context), y, z, buffers,
+                          out, n);
+            break;
+        case Pipeline::Op::Warp:
+        {
+            const Real amount = static_cast<Real>(instruction.value);
+            const Real *parentXs = contextXs(instruction.context);
+            const Real *parentYs = contextYs(instruction.context);
+            Real *warpedXs = field(registerCount + 2 * instruction.output - 2);
+            Real *warpedYs = warpedXs + TileWidth;
+
+            for (uint32_t x = 0; x < n; ++x)
+            {
+                warpedXs[x] = parentXs[x] + amount * a[x];
+                warpedYs[x] = (parentYs != nullptr ? parentYs[x] : y) + amount * b[x];
+            }
+            break;
+        }
+        case Pipeline::Op::Add:
+            for (uint32_t x = 0; x < n; ++x)
+                out[x] = a[x] + b[x];
+            break;
+        case Pipeline::Op::Subtract:
+            for (uint32_t x = 0; x < n; ++x)
+                out[x] = a[x] - b[x];
+            break;
+        case Pipeline::Op::Multiply:
+            for (uint32_t x = 0; x < n; ++x)
+                out[x] = a[x] * b[x];
+            break;
+        case Pipeline::Op::Min:
+            for (uint32_t x = 0; x < n; ++x)
+                out[x] = std::min(a[x], b[x]);
+            break;
+        case Pipeline::Op::Max:
+            for (uint32_t x = 0; x < n; ++x)
+                out[x] = std::max(a[x], b[x]);
+            break;
+        case Pipeline::Op::Abs:
+            for (uint32_t x = 0; x < n; ++x)
+                out[x] = std::abs(a[x]);
+            break;
+        }
+    }
+
+    const Real *result = field(m_pipeline->getResult());
+    std::copy(result, result + n, values);
+}
+
+template<typename Real>
+void noisegen::BasicGenerator<Real>::renderFractal(const Pipeline::Instruction &instruction, const Real *xs,
+                                                   const Real *ys, Real y, std::optional<Real> z, Real *buffers,
+                                                   Real *out, uint32_t n) const noexcept
+{
+    Real *scaledXs = buffers;
+    Real *scaledYs = buffers + TileWidth;
+    Real *zs = buffers + 2 * TileWidth;
+    Real *samples = buffers + 3 * TileWidth;
+    Real *weights = buffers + 4 * TileWidth;
+
+    const Real shiftX = static_cast<Real>(instruction.shiftX);
+    const Real shiftY = static_cast<Real>(instruction.shiftY);
+    const Real offset = static_cast<Real>(instruction.offset);
+    const Real gain = static_cast<Real>(instruction.gain);
 
-    file << "P2\n"                                                //
-         << m_settings.width << ' ' << m_settings.height << '\n'  //
-         << "255\n";
+    std::fill(out, out + n, Real{0});
+    if (instruction.fractal == Pipeline::Fractal::Ridged)
+        std::fill(weights, weights + n, Real{1});
 
-    for (const auto &pixel : m_pixels)
+    for (uint32_t octave = 0; octave < instruction.octaves; ++octave)
     {
-        const auto grayscale =
-          static_cast<int>(std::round((pixel.value - m_minNoiseValue) / (m_maxNoiseValue - m_minNoiseValue) * 255.0));
+        NOISEGEN_ACCUMULATED_PROFILER_ARG("Generator::renderRows() - octave", octave);
+
+        // Same frequencies and amplitudes as cacheFrequencyAndAmplitude(), fbm() matches generate()
+        const Real frequency = static_cast<Real>(instruction.frequency * std::pow(instruction.lacunarity, octave));
+        const Real amplitude = static_cast<Real>(std::pow(instruction.persistence, octave));
+
+        for (uint32_t x = 0; x < n; ++x)
+            scaledXs[x] = (xs[x] + shiftX) * frequency;
+
+        if (ys == nullptr)
+        {
+            // Still one row of sorted coordinates, the row kernels apply
+            const Real rowY = (y + shiftY) * frequency;
+            if (z.has_value())
+                noise3DRow(scaledXs, rowY, *z * frequency, samples, n);
+            else
+                noise2DRow(scaledXs, rowY, samples, n);
+        } else
+        {
+            for (uint32_t x = 0; x < n; ++x)
+                scaledYs[x] = (ys[x] + shiftY) * frequency;
+
+            if (z.has_value())
+            {
+                std::fill(zs, zs + n, *z * frequency);
+                noise3DBatch(scaledXs, scaledYs, zs, samples, n);
+            } else
+                noise2DBatch(scaledXs, scaledYs, samples, n);
+        }
 
-        file << grayscale << '\n';
+        switch (instruction.fractal)
+        {
+        case Pipeline::Fractal::Fbm:
+            for (uint32_t x = 0; x < n; ++x)
+                out[x] += samples[x] * amplitude;
+            break;
+        case Pipeline::Fractal::Turbulence:
+            for (uint32_t x = 0; x < n; ++x)
+                out[x] += std::abs(samples[x]) * amplitude;
+            break;
+        case Pipeline::Fractal::Ridged:
+            // Ridges where the noise crosses 0, each octave weighted by the previous one: valleys stay smooth
+            for (uint32_t x = 0; x < n; ++x)
+            {
+                Real signal = offset - std::abs(samples[x]);
+                signal *= signal * weights[x];
+                weights[x] = std::clamp(signal * gain, Real{0}, Real{1});
+                out[x] += signal * amplitude;
+            }
+            break;
+        }
     }
 }
 
-void noisegen::Generator::cacheFrequencyAndAmplitude()
+template<typename Real>
+size_t noisegen::BasicGenerator<Real>::pipelineScratchSize() const noexcept
+{
+    const size_t fields = m_pipeline->getRegisterCount() + 2 * (m_pipeline->getContextCount() - 1) + 5;
+    return fields * TileWidth;
+}
+
+template<typename Real>
+uint32_t noisegen::BasicGenerator<Real>::pyramidLevelCount(uint32_t width, uint32_t height) noexcept
+{
+    uint32_t levels = 1;
+    for (uint32_t size = std::max(width, height); size > 1; size = size / 2 + size % 2)
+        ++levels;
+    return levels;
+}
+
+template<typename Real>
+std::pair<uint32_t, uint32_t> noisegen::BasicGenerator<Real>::pyramidLevelSize(uint32_t level) const noexcept
+{
+    std::pair size{m_settings.width, m_settings.height};
+    for (uint32_t i = 0; i < level; ++i)
+        size = {size.first / 2 + size.first % 2, size.second / 2 + size.second % 2};
+    return size;
+}
+
+template<typename Real>
+uint32_t noisegen::BasicGenerator<Real>::pyramidOctaves(uint32_t level) const noexcept
+{
+    if (level == 0)
+        return m_settings.octaves;
+
+    // Octave k has 2^k lattice cells per unit, level samples min(width, height) / 2^level points per unit:
+    // at least 2 per cell up to octave floor(log2(min(width, height))) - level - 1
+    uint32_t log2Size = 0;
+    for (uint32_t size = std::min(m_settings.width, m_settings.height); size > 1; size /= 2)
+        ++log2Size;
+
+    const uint32_t nyquistOctaves = log2Size > level ? log2Size - level : 0;
+    return std::min(m_settings.octaves, std::max(nyquistOctaves, 1U));
+}
+
+template<typename Real>
+std::shared_ptr<noisegen::ThreadPool> noisegen::BasicGenerator<Real>::outputPool() const
+{
+    return isPNGFormat(m_settings.format) ? ThreadPool::sharedForOutput(m_threadPool->size()) : m_threadPool;
+}
+
+template<typename Real>
+uint32_t noisegen::BasicGenerator<Real>::streamingBandHeight() const noexcept
+{
+    const uint64_t rowBytes = std::max<uint64_t>(uint64_t{m_settings.width} * sizeof(Real), 1);
+    const uint64_t maxRows = m_settings.maxMemory == 0 ? m_settings.height : m_settings.maxMemory / rowBytes;
+
+    return static_cast<uint32_t>(std::clamp<uint64_t>(maxRows, 1, std::max(m_settings.height, 1U)));
+}
+
+template<typename Real>
+Real noisegen::BasicGenerator<Real>::sliceZ(uint32_t slice) const noexcept
+{
+    // Without a spacing, slices are as far apart as rows: cubic voxels
+    const double spacing = m_settings.sliceSpacing > 0.0 ? m_settings.sliceSpacing : 1.0 / m_settings.height;
+
+    return static_cast<Real>(slice * spacing);
+}
+
+template<typename Real>
+typename noisegen::BasicGenerator<Real>::PermutationArray
+noisegen::BasicGenerator<Real>::permutationsFromSeed(uint64_t seed) noexcept
+{
+    PermutationArray permutations{};
+    SplitMix64 random{seed};
+
+    for (size_t i = 0; i < PermutationArraySize; ++i)
+        permutations[i] = static_cast<uint8_t>(i);
+
+    // Index in [0, i] from the high 32 bits by multiply-shift, no modulo; the bias is below 2^-24
+    for (size_t i = PermutationArraySize - 1; i > 0; --i)
+    {
+        const size_t j = ((random() >> 32U) * (i + 1)) >> 32U;
+        std::swap(permutations[i], permutations[j]);
+    }
+    return permutations;
+}
+
+template<typename Real>
+void noisegen::BasicGenerator<Real>::setSeed(uint64_t seed) noexcept
+{
+    m_seed = seed;
+    m_permutations = permutationsFromSeed(seed);
+    updatePermutationTable();
+}
+
+template<typename Real>
+void noisegen::BasicGenerator<Real>::updatePermutationTable() noexcept
+{
+    for (size_t i = 0; i < m_permutationTable.size(); ++i)
+        m_permutationTable[i] = m_permutations[i % PermutationArraySize];
+}
+
+template<typename Real>
+void noisegen::BasicGenerator<Real>::cacheFrequencyAndAmplitude()
 {
     NOISEGEN_SCOPED_PROFILER("Generator::cacheFrequencyAndAmplitude()");
 
@@ -146,7 +1454,10 @@ void noisegen::Generator::cacheFrequencyAndAmplitude()
 
     for (uint32_t octave = 0; octave < m_settings.octaves; octave++)
     {
-        m_frequencyCache[octave] = std::pow(2, octave);
-        m_amplitudeCache[octave] = std::pow(m_settings.persistence, octave);
+        m_frequencyCache[octave] = static_cast<Real>(std::pow(2, octave));
+        m_amplitudeCache[octave] = static_cast<Real>(std::pow(m_settings.persistence, octave));
     }
 }
+
+template class noisegen::BasicGenerator<float>;
+template class noisegen::BasicGenerator<double>;
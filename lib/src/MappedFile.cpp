@@ -0,0 +1,110 @@
+/*
+**   Copyright 2021 Maxime Rayé
+**
+**   Licensed under the Apache License, Version 2.0 (the "License");
+**   you may not use this file except in compliance with the License.
+**   You may obtain a copy of the License at
+**
+**       http://www.apache.org/licenses/LICENSE-2.0
+**
+**   Unless required by applicable law or agreed to in writing, software
+**   distributed under the License is distributed on an "AS IS" BASIS,
+**   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**   See the License for the specific language governing permissions and
+**   limitations under the License.
+*/
+
+#include "MappedFile.hpp"
+#include "Exception.hpp"
+
+#ifndef _WIN32
+
+    #include <cerrno>
+    #include <cstring>
+
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+
+noisegen::MappedFile::MappedFile(const std::string &path, size_t size) : m_path{path}, m_size{size}
+{
+    const auto fail = [&](const char *what) {
+        const std::string error = std::strerror(errno);
+        if (m_file >= 0)
+            ::close(m_file);
+        throw Exception{std::string{what} + ' ' + path + ": " + error};
+    };
+
+    m_file = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (m_file < 0)
+        fail("can't open");
+
+    // Allocating the blocks now turns a full disk into an error here, rather than a SIGBUS while writing pixels
+    #ifdef __linux__
+    if (const int error = ::posix_fallocate(m_file, 0, static_cast<off_t>(size)); error != 0)
+    {
+        errno = error;
+        fail("can't allocate");
+    }
+    #else
+    if (::ftruncate(m_file, static_cast<off_t>(size)) != 0)
+        fail("can't allocate");
+    #endif
+
+    if (size == 0)
+        return;
+
+    void *data = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, m_file, 0);
+    if (data == MAP_FAILED)
+        fail("can't map");
+    m_data = static_cast<uint8_t *>(data);
+
+    // Rows are rendered from top to bottom: larger readahead, and pages behind are reclaimed first
+    ::madvise(m_data, m_size, MADV_SEQUENTIAL);
+}
+
+noisegen::MappedFile::~MappedFile()
+{
+    if (m_data != nullptr)
+        ::munmap(m_data, m_size);
+    if (m_file >= 0)
+        ::close(m_file);
+}
+
+void noisegen::MappedFile::finish()
+{
+    const auto fail = [this](const char *what) {
+        throw Exception{std::string{what} + ' ' + m_path + ": " + std::strerror(errno)};
+    };
+
+    if (m_data != nullptr)
+    {
+        // Writeback errors of shared mappings are only reported to a synchronous msync() (or fsync())
+        if (::msync(m_data, m_size, MS_SYNC) != 0)
+            fail("can't write");
+        if (::munmap(m_data, m_size) != 0)
+            fail("can't unmap");
+        m_data = nullptr;
+    }
+
+    if (m_file >= 0)
+    {
+        const int file = m_file;
+        m_file = -1;
+        if (::close(file) != 0)
+            fail("can't close");
+    }
+}
+
+#else
+
+noisegen::MappedFile::MappedFile(const std::string &path, size_t) : m_size{}
+{
+    throw Exception{"memory-mapped output is not supported on Windows: " + path};
+}
+
+noisegen::MappedFile::~MappedFile() = default;
+
+void noisegen::MappedFile::finish() {}
+
+#endif
@@ -0,0 +1,66 @@
+/*
+**   Copyright 2021 Maxime Rayé
+**
+**   Licensed under the Apache License, Version 2.0 (the "License");
+**   you may not use this file except in compliance with the License.
+**   You may obtain a copy of the License at
+**
+**       http://www.apache.org/licenses/LICENSE-2.0
+**
+**   Unless required by applicable law or agreed to in writing, software
+**   distributed under the License is distributed on an "AS IS" BASIS,
+**   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**   See the License for the specific language governing permissions and
+**   limitations under the License.
+*/
+
+#pragma once
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+namespace noisegen {
+/**
+ * Output file of a known size, preallocated and mapped in memory for writing (POSIX only).
+ * Pages are written back by the kernel: nothing is copied, and there is no write phase. finish() waits for the
+ * writeback, to report the errors the kernel met on the way (ENOSPC, EIO).
+ */
+class MappedFile final
+{
+public:
+#ifdef _WIN32
+    static constexpr bool IsSupported = false;
+#else
+    static constexpr bool IsSupported = true;
+#endif
+
+    /**
+     * Create or truncate path, preallocate size bytes and map them. Throws noisegen::Exception on failure.
+     */
+    MappedFile(const std::string &path, size_t size);
+    /**
+     * Unmap and close without waiting for the writeback, nor reporting its errors, when finish() wasn't called
+     */
+    ~MappedFile();
+
+    MappedFile(MappedFile &&) = delete;
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(MappedFile &&) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    [[nodiscard]] inline uint8_t *data() noexcept { return m_data; }
+    [[nodiscard]] inline size_t size() const noexcept { return m_size; }
+
+    /**
+     * Write every page back, unmap and close. Throws noisegen::Exception on failure.
+     */
+    void finish();
+
+private:
+    std::string m_path{};
+    int m_file{-1};
+    uint8_t *m_data{nullptr};
+    size_t m_size{};
+};
+}  // namespace noisegen
@@ -0,0 +1,240 @@
+/*
+**   Copyright 2021 Maxime Rayé
+**
+**   Licensed under the Apache License, Version 2.0 (the "License");
+**   you may not use this file except in compliance with the License.
+**   You may obtain a copy of the License at
+**
+**       http://www.apache.org/licenses/LICENSE-2.0
+**
+**   Unless required by applicable law or agreed to in writing, software
+**   distributed under the License is distributed on an "AS IS" BASIS,
+**   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**   See the License for the specific language governing permissions and
+**   limitations under the License.
+*/
+
+#include <algorithm>
+
+#include "PGMWriter.hpp"
+#include "PNGEncoder.hpp"
+#include "ScopedProfiler.hpp"
+
+/*
+ * Both quantizers are plain branchless loops (clamp, scale, round half up),
+ * written so that the compiler vectorizes them. Float samples are quantized in float, twice as many per vector.
+ */
+
+namespace {
+template<typename T>
+void quantize8(const T *values, size_t n, double minValue, double maxValue, uint8_t *out) noexcept
+{
+    const auto min = static_cast<T>(minValue);
+    const auto range = maxValue > minValue ? static_cast<T>(maxValue - minValue) : T{1};  // constant images are black
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        const T normalized = std::clamp((values[i] - min) / range, T{0}, T{1});
+        out[i] = static_cast<uint8_t>(static_cast<int32_t>(normalized * T{255} + T{0.5}));
+    }
+}
+
+template<typename T>
+void quantize16(const T *values, size_t n, double minValue, double maxValue, uint8_t *out) noexcept
+{
+    const auto min = static_cast<T>(minValue);
+    const auto range = maxValue > minValue ? static_cast<T>(maxValue - minValue) : T{1};  // constant images are black
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        const T normalized = std::clamp((values[i] - min) / range, T{0}, T{1});
+        const auto sample = static_cast<uint32_t>(normalized * T{65535} + T{0.5});
+
+        out[2 * i] = static_cast<uint8_t>(sample >> 8U);
+        out[2 * i + 1] = static_cast<uint8_t>(sample & 0xFFU);
+    }
+}
+
+template<typename T>
+void quantize16(const T *values, size_t n, double minValue, double maxValue, uint16_t *out) noexcept
+{
+    const auto min = static_cast<T>(minValue);
+    const auto range = maxValue > minValue ? static_cast<T>(maxValue - minValue) : T{1};  // constant images are black
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        const T normalized = std::clamp((values[i] - min) / range, T{0}, T{1});
+        out[i] = static_cast<uint16_t>(static_cast<uint32_t>(normalized * T{65535} + T{0.5}));
+    }
+}
+}  // namespace
+
+noisegen::PGMWriter::PGMWriter(std::ostream &os, ImageFormat format, uint32_t width, uint32_t height,
+                               double minValue, double maxValue, std::shared_ptr<ThreadPool> pool)
+    : m_os{os}, m_format{format}, m_width{width}, m_minValue{minValue}, m_maxValue{maxValue}
+{
+    m_os << header(m_format, width, height);
+
+    if (isPNGFormat(m_format))
+    {
+        m_png = std::make_unique<PNGEncoder>(m_os, width, height, is16BitFormat(m_format),
+                                             pool ? std::move(pool) : ThreadPool::shared());
+        m_flushSize = m_png->batchSize();
+    }
+
+    m_buffer.reserve(m_flushSize);
+    if (m_format == ImageFormat::PGMAscii)
+        m_quantized.resize(width);
+}
+
+noisegen::PGMWriter::~PGMWriter() = default;
+
+void noisegen::PGMWriter::writeRows(const NoiseImage &image, uint32_t rowCount)
+{
+    writeRows<double>(image, rowCount);
+}
+
+void noisegen::PGMWriter::writeRows(const NoiseImageF &image, uint32_t rowCount)
+{
+    writeRows<float>(image, rowCount);
+}
+
+template<typename T>
+void noisegen::PGMWriter::writeRows(const BasicNoiseImage<T> &image, uint32_t rowCount)
+{
+    NOISEGEN_SCOPED_PROFILER("PGMWriter::writeRows()");
+
+    for (uint32_t y = 0; y < rowCount; ++y)
+        writeRow(image.row(y));
+}
+
+void noisegen::PGMWriter::flush()
+{
+    if (m_png)
+    {
+        // The buffer only ever holds whole rows
+        const size_t rowBytes = m_width * (is16BitFormat(m_format) ? size_t{2} : size_t{1});
+        if (rowBytes > 0)
+            m_png->writeRows(m_buffer.data(), static_cast<uint32_t>(m_buffer.size() / rowBytes));
+        m_buffer.clear();
+        return;
+    }
+
+    m_os.write(reinterpret_cast<const char *>(m_buffer.data()), static_cast<std::streamsize>(m_buffer.size()));
+    m_buffer.clear();
+}
+
+void noisegen::PGMWriter::finish()
+{
+    if (m_bFinished)
+        return;
+
+    flush();
+    if (m_png)
+        m_png->finish();
+    m_os.flush();
+    m_bFinished = true;
+}
+
+template<typename T>
+void noisegen::PGMWriter::writeRow(const T *values)
+{
+    // worst case: "255\n" for every sample in ASCII
+    const size_t bytesPerSample = m_format == ImageFormat::PGMAscii ? 4 : is16BitFormat(m_format) ? 2 : 1;
+    const size_t maxRowBytes = m_width * bytesPerSample;
+
+    if (!m_buffer.empty() && m_buffer.size() + maxRowBytes > m_flushSize)
+        flush();
+
+    const size_t offset = m_buffer.size();
+    m_buffer.resize(offset + maxRowBytes);
+    uint8_t *out = m_buffer.data() + offset;
+
+    switch (m_format)
+    {
+    case ImageFormat::PGMBinary8:
+    case ImageFormat::Raw8:
+    case ImageFormat::PNG8: quantize8(values, m_width, m_minValue, m_maxValue, out); break;
+    case ImageFormat::PGMBinary16:
+    case ImageFormat::Raw16:
+    case ImageFormat::PNG16: quantize16(values, m_width, m_minValue, m_maxValue, out); break;
+    case ImageFormat::PGMAscii:
+    {
+        quantize8(values, m_width, m_minValue, m_maxValue, m_quantized.data());
+
+        for (const uint8_t grayscale : m_quantized)
+        {
+            if (grayscale >= 100)
+                *out++ = static_cast<uint8_t>('0' + grayscale / 100);
+            if (grayscale >= 10)
+                *out++ = static_cast<uint8_t>('0' + grayscale / 10 % 10);
+            *out++ = static_cast<uint8_t>('0' + grayscale % 10);
+            *out++ = '\n';
+        }
+        m_buffer.resize(static_cast<size_t>(out - m_buffer.data()));
+        break;
+    }
+    }
+}
+
+void noisegen::PGMWriter::quantize8(const double *values, size_t n, double minValue, double maxValue,
+                                    uint8_t *out) noexcept
+{
+    ::quantize8(values, n, minValue, maxValue, out);
+}
+
+void noisegen::PGMWriter::quantize8(const float *values, size_t n, double minValue, double maxValue,
+                                    uint8_t *out) noexcept
+{
+    ::quantize8(values, n, minValue, maxValue, out);
+}
+
+void noisegen::PGMWriter::quantize16(const double *values, size_t n, double minValue, double maxValue,
+                                     uint8_t *out) noexcept
+{
+    ::quantize16(values, n, minValue, maxValue, out);
+}
+
+void noisegen::PGMWriter::quantize16(const float *values, size_t n, double minValue, double maxValue,
+                                     uint8_t *out) noexcept
+{
+    ::quantize16(values, n, minValue, maxValue, out);
+}
+
+void noisegen::PGMWriter::quantize16(const double *values, size_t n, double minValue, double maxValue,
+                                     uint16_t *out) noexcept
+{
+    ::quantize16(values, n, minValue, maxValue, out);
+}
+
+void noisegen::PGMWriter::quantize16(const float *values, size_t n, double minValue, double maxValue,
+                                     uint16_t *out) noexcept
+{
+    ::quantize16(values, n, minValue, maxValue, out);
+}
+
+std::string noisegen::PGMWriter::header(ImageFormat format, uint32_t width, uint32_t height)
+{
+    if (isRawFormat(format) || isPNGFormat(format))
+        return {};
+
+    return std::string{format == ImageFormat::PGMAscii ? "P2\n" : "P5\n"} + std::to_string(width) + ' '
+           + std::to_string(height) + '\n' + (format == ImageFormat::PGMBinary16 ? "65535\n" : "255\n");
+}
+
+std::string noisegen::numberedFileName(const std::string &fileName, uint32_t index, uint32_t count)
+{
+    if (count <= 1)
+        return fileName;
+
+    const auto digits = std::to_string(count - 1).size();
+    std::string number = std::to_string(index);
+    number.insert(0, digits - number.size(), '0');
+
+    const auto slash = fileName.find_last_of("/\\");
+    const auto dot = fileName.rfind('.');
+
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+        return fileName + '_' + number;
+    return fileName.substr(0, dot) + '_' + number + fileName.substr(dot);
+}
@@ -0,0 +1,283 @@
+/*
+**   Copyright 2021 Maxime Rayé
+**
+**   Licensed under the Apache License, Version 2.0 (the "License");
+**   you may not use this file except in compliance with the License.
+**   You may obtain a copy of the License at
+**
+**       http://www.apache.org/licenses/LICENSE-2.0
+**
+**   Unless required by applicable law or agreed to in writing, software
+**   distributed under the License is distributed on an "AS IS" BASIS,
+**   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**   See the License for the specific language governing permissions and
+**   limitations under the License.
+*/
+
+#include <new>
+#include <array>
+#include <limits>
+#include <cstdlib>
+#include <algorithm>
+
+#define ZLIB_CONST
+#include <zlib.h>
+
+#include "PNGEncoder.hpp"
+#include "Exception.hpp"
+#include "ScopedProfiler.hpp"
+
+namespace {
+constexpr std::array<uint8_t, 8> Signature{0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+// Deflate with a 32 KiB window, default level
+constexpr std::array<uint8_t, 2> ZlibHeader{0x78, 0x9C};
+
+void storeBigEndian(uint32_t value, uint8_t *out) noexcept
+{
+    out[0] = static_cast<uint8_t>(value >> 24U);
+    out[1] = static_cast<uint8_t>(value >> 16U);
+    out[2] = static_cast<uint8_t>(value >> 8U);
+    out[3] = static_cast<uint8_t>(value);
+}
+
+uint8_t paeth(uint8_t left, uint8_t up, uint8_t upLeft) noexcept
+{
+    const int p = left + up - upLeft;
+    const int pLeft = std::abs(p - left);
+    const int pUp = std::abs(p - up);
+    const int pUpLeft = std::abs(p - upLeft);
+
+    if (pLeft <= pUp && pLeft <= pUpLeft)
+        return left;
+    return pUp <= pUpLeft ? up : upLeft;
+}
+
+/**
+ * out[i] = row[i] - predict(left, up, upLeft), returns the sum of |out[i]| read as signed bytes
+ */
+template<typename Predictor>
+uint64_t applyFilter(const uint8_t *row, const uint8_t *above, size_t n, size_t bytesPerPixel, uint8_t *out,
+                     const Predictor &predict) noexcept
+{
+    uint64_t cost = 0;
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        const uint8_t left = i >= bytesPerPixel ? row[i - bytesPerPixel] : uint8_t{0};
+        const uint8_t upLeft = i >= bytesPerPixel ? above[i - bytesPerPixel] : uint8_t{0};
+        const auto value = static_cast<uint8_t>(row[i] - predict(left, above[i], upLeft));
+
+        out[i] = value;
+        cost += value < 128U ? value : 256U - value;
+    }
+    return cost;
+}
+}  // namespace
+
+noisegen::PNGEncoder::PNGEncoder(std::ostream &os, uint32_t width, uint32_t height, bool b16Bit,
+                                 std::shared_ptr<ThreadPool> pool)
+    : m_os{os},
+      m_rowBytes{size_t{width} * (b16Bit ? 2U : 1U)},
+      m_bytesPerPixel{b16Bit ? 2U : 1U},
+      m_pool{std::move(pool)},
+      m_previousRow(m_rowBytes, 0),
+      m_adler{adler32(0, nullptr, 0)}
+{
+    m_os.write(reinterpret_cast<const char *>(Signature.data()), Signature.size());
+
+    // Grayscale, no interlacing
+    std::array<uint8_t, 13> header{};
+    storeBigEndian(width, header.data());
+    storeBigEndian(height, header.data() + 4);
+    header[8] = b16Bit ? 16 : 8;
+    writeChunk("IHDR", header.data(), header.size());
+}
+
+size_t noisegen::PNGEncoder::batchSize() const noexcept
+{
+    return m_pool->size() * 4 * ChunkSize;
+}
+
+void noisegen::PNGEncoder::writeRows(const uint8_t *rows, uint32_t rowCount)
+{
+    NOISEGEN_SCOPED_PROFILER("PNGEncoder::writeRows()");
+
+    if (rowCount == 0)
+        return;
+
+    const size_t filteredRowBytes = m_rowBytes + 1;
+    const auto rowsPerChunk = static_cast<uint32_t>(std::clamp<size_t>(ChunkSize / filteredRowBytes, 1, rowCount));
+    const uint32_t chunkCount = (rowCount + rowsPerChunk - 1) / rowsPerChunk;
+
+    m_filtered.resize(filteredRowBytes * rowCount);
+
+    // Filters only look at the row above, in the source: every row is filtered independently
+    std::vector<std::vector<uint8_t>> scratch(m_pool->size(), std::vector<uint8_t>(m_rowBytes));
+    m_pool->parallelFor(chunkCount, [&](uint32_t chunk, uint32_t workerIndex) {
+        const uint32_t firstRow = chunk * rowsPerChunk;
+        const uint32_t lastRow = std::min(firstRow + rowsPerChunk, rowCount);
+
+        for (uint32_t row = firstRow; row < lastRow; ++row)
+        {
+            const uint8_t *above = row == 0 ? m_previousRow.data() : rows + (row - 1) * m_rowBytes;
+            filterRow(rows + row * m_rowBytes, above, &m_filtered[row * filteredRowBytes],
+                      scratch[workerIndex].data());
+        }
+    });
+
+    struct Chunk
+    {
+        std::vector<uint8_t> compressed{};
+        unsigned long adler{};
+        bool bFailed{false};
+    };
+    std::vector<Chunk> chunks(chunkCount);
+
+    // Each chunk is primed with the 32 KiB before it (the previous batch's for the first one), then sync-flushed so
+    // that the next stream starts on a byte boundary, none of them being final
+    m_pool->parallelFor(chunkCount, [&](uint32_t index, uint32_t) {
+        Chunk &chunk = chunks[index];
+        const size_t begin = size_t{index} * rowsPerChunk * filteredRowBytes;
+        const size_t size = std::min(size_t{rowsPerChunk} * filteredRowBytes, m_filtered.size() - begin);
+
+        z_stream stream{};
+        if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8, Z_FILTERED) != Z_OK)
+        {
+            chunk.bFailed = true;
+            return;
+        }
+
+        if (index > 0)
+        {
+            const size_t windowBytes = std::min(WindowSize, begin);
+            deflateSetDictionary(&stream, m_filtered.data() + begin - windowBytes, static_cast<uInt>(windowBytes));
+        } else if (!m_window.empty())
+        {
+            deflateSetDictionary(&stream, m_window.data(), static_cast<uInt>(m_window.size()));
+        }
+
+        stream.next_in = m_filtered.data() + begin;
+        stream.avail_in = static_cast<uInt>(size);
+
+        int status = Z_OK;
+        try
+        {
+            // Room for the sync flush markers on top of the bound, a single deflate() call is enough
+            chunk.compressed.resize(deflateBound(&stream, static_cast<uLong>(size)) + 16);
+
+            while (status == Z_OK && (stream.avail_in > 0 || stream.avail_out == 0))
+            {
+                if (stream.avail_out == 0 && stream.total_out > 0)
+                    chunk.compressed.resize(chunk.compressed.size() * 2);
+                stream.next_out = chunk.compressed.data() + stream.total_out;
+                stream.avail_out = static_cast<uInt>(chunk.compressed.size() - stream.total_out);
+                status = deflate(&stream, Z_SYNC_FLUSH);
+            }
+            chunk.compressed.resize(stream.total_out);
+        } catch (const std::bad_alloc &)
+        {
+            // parallelFor() tasks must not throw, the failure is reported with the deflate errors below
+            status = Z_MEM_ERROR;
+        }
+        chunk.bFailed = status != Z_OK;
+        deflateEnd(&stream);
+
+        chunk.adler = adler32(adler32(0, nullptr, 0), m_filtered.data() + begin, static_cast<uInt>(size));
+    });
+
+    for (uint32_t index = 0; index < chunkCount; ++index)
+    {
+        Chunk &chunk = chunks[index];
+        if (chunk.bFailed)
+            throw Exception{"PNG encoding failed: deflate error"};
+
+        const size_t begin = size_t{index} * rowsPerChunk * filteredRowBytes;
+        const size_t size = std::min(size_t{rowsPerChunk} * filteredRowBytes, m_filtered.size() - begin);
+        m_adler = adler32_combine(m_adler, chunk.adler, static_cast<z_off_t>(size));
+
+        if (!m_bStreamStarted)
+        {
+            chunk.compressed.insert(chunk.compressed.begin(), ZlibHeader.begin(), ZlibHeader.end());
+            m_bStreamStarted = true;
+        }
+        writeChunk("IDAT", chunk.compressed.data(), chunk.compressed.size());
+    }
+
+    // Keep what the next batch needs: the last row for the filters, the last 32 KiB for the dictionary
+    std::copy_n(rows + size_t{rowCount - 1} * m_rowBytes, m_rowBytes, m_previousRow.begin());
+
+    if (m_filtered.size() >= WindowSize)
+    {
+        m_window.assign(m_filtered.end() - static_cast<std::ptrdiff_t>(WindowSize), m_filtered.end());
+    } else
+    {
+        m_window.insert(m_window.end(), m_filtered.begin(), m_filtered.end());
+        if (m_window.size() > WindowSize)
+            m_window.erase(m_window.begin(), m_window.end() - static_cast<std::ptrdiff_t>(WindowSize));
+    }
+}
+
+void noisegen::PNGEncoder::finish()
+{
+    if (m_bFinished)
+        return;
+    m_bFinished = true;
+
+    // An empty final fixed-Huffman block ends the deflate stream, the Adler-32 of the whole data the zlib stream
+    std::vector<uint8_t> trailer{};
+    if (!m_bStreamStarted)
+        trailer.assign(ZlibHeader.begin(), ZlibHeader.end());
+    trailer.insert(trailer.end(), {0x03, 0x00, 0, 0, 0, 0});
+    storeBigEndian(static_cast<uint32_t>(m_adler), trailer.data() + trailer.size() - 4);
+
+    writeChunk("IDAT", trailer.data(), trailer.size());
+    writeChunk("IEND", nullptr, 0);
+}
+
+void noisegen::PNGEncoder::writeChunk(const char *type, const uint8_t *data, size_t size)
+{
+    std::array<uint8_t, 8> prefix{};
+    storeBigEndian(static_cast<uint32_t>(size), prefix.data());
+    std::copy_n(type, 4, prefix.begin() + 4);
+
+    // The CRC covers the type and the data, not the length
+    unsigned long crc = crc32(0, prefix.data() + 4, 4);
+    if (size > 0)
+        crc = crc32(crc, data, static_cast<uInt>(size));
+
+    std::array<uint8_t, 4> suffix{};
+    storeBigEndian(static_cast<uint32_t>(crc), suffix.data());
+
+    m_os.write(reinterpret_cast<const char *>(prefix.data()), prefix.size());
+    if (size > 0)
+        m_os.write(reinterpret_cast<const char *>(data), static_cast<std::streamsize>(size));
+    m_os.write(reinterpret_cast<const char *>(suffix.data()), suffix.size());
+}
+
+void noisegen::PNGEncoder::filterRow(const uint8_t *row, const uint8_t *above, uint8_t *out,
+                                     uint8_t *scratch) const noexcept
+{
+    const auto none = [](uint8_t, uint8_t, uint8_t) { return uint8_t{0}; };
+    const auto sub = [](uint8_t left, uint8_t, uint8_t) { return left; };
+    const auto up = [](uint8_t, uint8_t upValue, uint8_t) { return upValue; };
+    const auto average = [](uint8_t left, uint8_t upValue, uint8_t) {
+        return static_cast<uint8_t>((left + upValue) / 2);
+    };
+
+    uint64_t bestCost = std::numeric_limits<uint64_t>::max();
+    const auto tryFilter = [&](uint8_t type, const auto &predict) {
+        const uint64_t cost = applyFilter(row, above, m_rowBytes, m_bytesPerPixel, scratch, predict);
+        if (cost < bestCost)
+        {
+            bestCost = cost;
+            out[0] = type;
+            std::copy_n(scratch, m_rowBytes, out + 1);
+        }
+    };
+
+    tryFilter(0, none);
+    tryFilter(1, sub);
+    tryFilter(2, up);
+    tryFilter(3, average);
+    tryFilter(4, paeth);
+}
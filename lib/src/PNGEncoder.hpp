@@ -0,0 +1,84 @@
+/*
+**   Copyright 2021 Maxime Rayé
+**
+**   Licensed under the Apache License, Version 2.0 (the "License");
+**   you may not use this file except in compliance with the License.
+**   You may obtain a copy of the License at
+**
+**       http://www.apache.org/licenses/LICENSE-2.0
+**
+**   Unless required by applicable law or agreed to in writing, software
+**   distributed under the License is distributed on an "AS IS" BASIS,
+**   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**   See the License for the specific language governing permissions and
+**   limitations under the License.
+*/
+
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+#include "ThreadPool.hpp"
+
+namespace noisegen {
+/**
+ * Grayscale PNG encoder whose deflate runs in parallel, the way pigz does it: rows are cut into chunks of about
+ * ChunkSize bytes, each chunk is filtered and deflated independently (primed with the 32 KiB before it, so the ratio
+ * stays close to a serial deflate) and ends on a byte boundary with a sync flush. The raw deflate streams are then
+ * concatenated into one zlib stream, their Adler-32 checksums combined.
+ */
+class PNGEncoder final
+{
+public:
+    /**
+     * Uncompressed bytes per deflate task
+     */
+    static constexpr size_t ChunkSize = size_t{256} << 10U;
+
+    /**
+     * Write the signature and the header chunk
+     */
+    PNGEncoder(std::ostream &os, uint32_t width, uint32_t height, bool b16Bit, std::shared_ptr<ThreadPool> pool);
+
+    /**
+     * Bytes of rows worth passing to writeRows() at once, a few chunks for every worker of the pool
+     */
+    [[nodiscard]] size_t batchSize() const noexcept;
+
+    /**
+     * Filter, deflate and write rowCount rows, in order. 16-bit samples are big-endian.
+     */
+    void writeRows(const uint8_t *rows, uint32_t rowCount);
+    /**
+     * End the image, once every row has been written
+     */
+    void finish();
+
+private:
+    static constexpr size_t WindowSize = size_t{32} << 10U;
+
+    std::ostream &m_os;
+    const size_t m_rowBytes;
+    const size_t m_bytesPerPixel;
+    std::shared_ptr<ThreadPool> m_pool;
+
+    std::vector<uint8_t> m_previousRow;  // last row written, zeros above the first one
+    std::vector<uint8_t> m_filtered{};   // rows of the current batch, each one behind its filter type
+    std::vector<uint8_t> m_window{};     // last WindowSize filtered bytes of the previous batches
+    unsigned long m_adler;  // Adler-32 of every filtered byte written so far
+    bool m_bStreamStarted{false};
+    bool m_bFinished{false};
+
+    void writeChunk(const char *type, const uint8_t *data, size_t size);
+    /**
+     * Write the row with the filter giving the lowest sum of absolute differences (the heuristic of the PNG
+     * specification) into out, filter type first
+     * @param scratch m_rowBytes bytes
+     */
+    void filterRow(const uint8_t *row, const uint8_t *above, uint8_t *out, uint8_t *scratch) const noexcept;
+};
+}  // namespace noisegen
@@ -0,0 +1,581 @@
+/*
+**   Copyright 2021 Maxime Rayé
+**
+**   Licensed under the Apache License, Version 2.0 (the "License");
+**   you may not use this file except in compliance with the License.
+**   You may obtain a copy of the License at
+**
+**       http://www.apache.org/licenses/LICENSE-2.0
+**
+**   Unless required by applicable law or agreed to in writing, software
+**   distributed under the License is distributed on an "AS IS" BASIS,
+**   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**   See the License for the specific language governing permissions and
+**   limitations under the License.
+*/
+
+#include <cmath>
+#include <array>
+#include <tuple>
+#include <memory>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+#include "Pipeline.hpp"
+#include "Exception.hpp"
+
+namespace {
+using Op = noisegen::Pipeline::Op;
+using Fractal = noisegen::Pipeline::Fractal;
+using Instruction = noisegen::Pipeline::Instruction;
+using Bounds = std::pair<double, double>;
+
+/**
+ * Expression tree, compiled to instructions once parsed: a warp has to compile its offsets before its source
+ */
+struct Node
+{
+    Instruction instruction{};                    // op and parameters, registers are assigned by Compiler
+    std::vector<std::unique_ptr<Node>> children{};  // operands, warp: source, x, y
+    uint32_t height{1};                           // of the subtree, bounded so that nothing recurses past it
+};
+
+/**
+ * Recursive descent parser of the grammar described in Pipeline.hpp:
+ *
+ *     expression := product (('+' | '-') product)*
+ *     product    := unary ('*' unary)*
+ *     unary      := '-'* (number | name '(' arguments ')' | '(' expression ')')
+ *     argument   := [name '='] (expression | number)
+ *
+ * Parentheses and calls nest at most Pipeline::MaxDepth deep, as do the trees they build, and a tree has at most
+ * Pipeline::MaxNodes nodes: parsing, compiling and destroying the tree all recurse on it.
+ */
+class Parser final
+{
+public:
+    explicit Parser(std::string_view source) : m_source{source} {}
+
+    std::unique_ptr<Node> parse()
+    {
+        auto root = parseExpression();
+        if (peek() != '\0')
+            fail("unexpected '" + std::string(1, peek()) + "'");
+        return root;
+    }
+
+private:
+    std::string_view m_source;
+    size_t m_position{0};
+    uint32_t m_depth{0};
+    size_t m_nodeCount{0};
+
+    [[noreturn]] void fail(const std::string &what) const
+    {
+        throw noisegen::Exception{"pipeline, column " + std::to_string(m_position + 1) + ": " + what};
+    }
+
+    /**
+     * Next character after whitespace and comments, '\0' at the end
+     */
+    char peek()
+    {
+        while (m_position < m_source.size())
+        {
+            if (m_source[m_position] == '#')
+            {
+                while (m_position < m_source.size() && m_source[m_position] != '\n')
+                    ++m_position;
+            } else if (std::isspace(static_cast<unsigned char>(m_source[m_position])) != 0)
+                ++m_position;
+            else
+                break;
+        }
+        return m_position < m_source.size() ? m_source[m_position] : '\0';
+    }
+
+    bool accept(char c)
+    {
+        if (peek() != c)
+            return false;
+        ++m_position;
+        return true;
+    }
+
+    void expect(char c)
+    {
+        if (!accept(c))
+            fail(std::string{"expected '"} + c + "'");
+    }
+
+    /**
+     * Count a nesting level of the source, until leave()
+     */
+    void enter()
+    {
+        if (++m_depth > noisegen::Pipeline::MaxDepth)
+            fail("expression nested deeper than " + std::to_string(noisegen::Pipeline::MaxDepth) + " levels");
+    }
+
+    void leave() noexcept { --m_depth; }
+
+    std::unique_ptr<Node> makeNode()
+    {
+        if (++m_nodeCount > noisegen::Pipeline::MaxNodes)
+            fail("expression larger than " + std::to_string(noisegen::Pipeline::MaxNodes) + " nodes");
+        return std::make_unique<Node>();
+    }
+
+    /**
+     * Set the height of node once its children are attached
+     */
+    std::unique_ptr<Node> seal(std::unique_ptr<Node> node)
+    {
+        for (const auto &child : node->children)
+            node->height = std::max(node->height, child->height + 1);
+
+        if (node->height > noisegen::Pipeline::MaxDepth)
+            fail("expression nested deeper than " + std::to_string(noisegen::Pipeline::MaxDepth) + " levels");
+        return node;
+    }
+
+    std::unique_ptr<Node> makeConstant(double value)
+    {
+        auto node = makeNode();
+        node->instruction.op = Op::Constant;
+        node->instruction.value = value;
+        return node;
+    }
+
+    /**
+     * Operation on a and b, folded to a constant when both are
+     */
+    std::unique_ptr<Node> makeBinary(Op op, std::unique_ptr<Node> a, std::unique_ptr<Node> b)
+    {
+        if (a->instruction.op == Op::Constant && b->instruction.op == Op::Constant)
+        {
+            const double x = a->instruction.value, y = b->instruction.value;
+            return makeConstant(op == Op::Add ? x + y : op == Op::Subtract ? x - y : x * y);
+        }
+
+        auto node = makeNode();
+        node->instruction.op = op;
+        node->children.push_back(std::move(a));
+        node->children.push_back(std::move(b));
+        return seal(std::move(node));
+    }
+
+    std::unique_ptr<Node> parseExpression()
+    {
+        auto node = parseProduct();
+        while (true)
+        {
+            if (accept('+'))
+                node = makeBinary(Op::Add, std::move(node), parseProduct());
+            else if (accept('-'))
+                node = makeBinary(Op::Subtract, std::move(node), parseProduct());
+            else
+                return node;
+        }
+    }
+
+    std::unique_ptr<Node> parseProduct()
+    {
+        auto node = parseUnary();
+        while (accept('*'))
+            node = makeBinary(Op::Multiply, std::move(node), parseUnary());
+        return node;
+    }
+
+    std::unique_ptr<Node> parseUnary()
+    {
+        // A run of signs is counted rather than recursed into
+        bool bNegative = false;
+        while (accept('-'))
+            bNegative = !bNegative;
+
+        auto operand = parsePrimary();
+        if (!bNegative)
+            return operand;
+        if (operand->instruction.op == Op::Constant)
+        {
+            operand->instruction.value = -operand->instruction.value;
+            return operand;
+        }
+        return makeBinary(Op::Subtract, makeConstant(0.0), std::move(operand));
+    }
+
+    std::unique_ptr<Node> parsePrimary()
+    {
+        if (accept('('))
+        {
+            enter();
+            auto node = parseExpression();
+            expect(')');
+            leave();
+            return node;
+        }
+
+        const char c = peek();
+        if (std::isdigit(static_cast<unsigned char>(c)) != 0 || c == '.')
+            return makeConstant(parseNumber());
+        if (std::isalpha(static_cast<unsigned char>(c)) != 0)
+            return parseCall();
+
+        fail(c == '\0' ? "unexpected end of the expression" : "unexpected '" + std::string(1, c) + "'");
+    }
+
+    std::string_view parseName()
+    {
+        peek();
+        const size_t start = m_position;
+        while (m_position < m_source.size() && std::isalnum(static_cast<unsigned char>(m_source[m_position])) != 0)
+            ++m_position;
+        return m_source.substr(start, m_position - start);
+    }
+
+    /**
+     * Number literal, with an optional sign for parameters
+     */
+    double parseNumber()
+    {
+        const bool bNegative = accept('-');
+        peek();
+
+        const size_t start = m_position;
+        const auto isDigit = [this](size_t i) {
+            return i < m_source.size() && std::isdigit(static_cast<unsigned char>(m_source[i])) != 0;
+        };
+        while (isDigit(m_position) || (m_position < m_source.size() && m_source[m_position] == '.'))
+            ++m_position;
+        if (m_position < m_source.size() && (m_source[m_position] == 'e' || m_source[m_position] == 'E'))
+        {
+            const size_t exponent = m_position + 1;
+            const size_t digits = exponent < m_source.size() && std::strchr("+-", m_source[exponent]) != nullptr
+                                    ? exponent + 1
+                                    : exponent;
+            if (isDigit(digits))
+            {
+                m_position = digits;
+                while (isDigit(m_position))
+                    ++m_position;
+            }
+        }
+
+        const std::string token{m_source.substr(start, m_position - start)};
+        char *end{};
+        const double value = std::strtod(token.c_str(), &end);
+        if (token.empty() || end != token.c_str() + token.size() || !std::isfinite(value))
+        {
+            m_position = start;
+            fail("expected a number");
+        }
+        return bNegative ? -value : value;
+    }
+
+    std::unique_ptr<Node> parseCall()
+    {
+        const size_t start = m_position;
+        const std::string name{parseName()};
+
+        auto node = makeNode();
+        auto &instruction = node->instruction;
+        size_t operandCount = 0;
+
+        if (name == "noise" || name == "fbm" || name == "turbulence" || name == "ridged")
+        {
+            instruction.op = Op::Fractal;
+            instruction.fractal = name == "turbulence" ? Fractal::Turbulence
+                                  : name == "ridged"   ? Fractal::Ridged
+                                                       : Fractal::Fbm;
+            instruction.octaves = name == "noise" ? 1 : 8;
+            instruction.frequency = 1.0;
+            instruction.lacunarity = 2.0;
+            instruction.persistence = 0.5;
+            instruction.offset = 1.0;
+            instruction.gain = 2.0;
+        } else if (name == "warp")
+        {
+            instruction.op = Op::Warp;
+            instruction.value = 0.1;
+            operandCount = 1;
+        } else if (name == "abs")
+        {
+            instruction.op = Op::Abs;
+            operandCount = 1;
+        } else if (name == "min" || name == "max")
+        {
+            instruction.op = name == "min" ? Op::Min : Op::Max;
+            operandCount = 2;
+        } else
+        {
+            m_position = start;
+            fail("unknown function " + name);
+        }
+
+        std::unique_ptr<Node> warpX{};
+        std::unique_ptr<Node> warpY{};
+
+        expect('(');
+        enter();
+        if (!accept(')'))
+        {
+            do
+            {
+                const size_t argumentStart = m_position;
+                std::string parameter{};
+                if (std::isalpha(static_cast<unsigned char>(peek())) != 0)
+                {
+                    parameter = parseName();
+                    if (!accept('='))
+                    {
+                        // Not a named argument but an expression starting with a call
+                        m_position = argumentStart;
+                        parameter.clear();
+                    }
+                }
+
+                if (parameter.empty())
+                {
+                    if (node->children.size() == operandCount)
+                        fail(operandCount == 0 ? name + "() only takes name=value parameters"
+                                               : arityError(name, operandCount));
+                    node->children.push_back(parseExpression());
+                } else if (instruction.op == Op::Warp)
+                {
+                    if (parameter == "x")
+                        warpX = parseExpression();
+                    else if (parameter == "y")
+                        warpY = parseExpression();
+                    else if (parameter == "amount")
+                        instruction.value = parseNumber();
+                    else
+                        failParameter(argumentStart, name, parameter);
+                } else if (instruction.op == Op::Fractal)
+                    parseFractalParameter(argumentStart, name, parameter, instruction);
+                else
+                    failParameter(argumentStart, name, parameter);
+            } while (accept(','));
+            expect(')');
+        }
+        leave();
+
+        if (node->children.size() != operandCount)
+        {
+            m_position = start;
+            fail(arityError(name, operandCount));
+        }
+
+        if (instruction.op == Op::Warp)
+        {
+            node->children.push_back(warpX ? std::move(warpX) : defaultWarp(5.2, 1.3));
+            node->children.push_back(warpY ? std::move(warpY) : defaultWarp(1.7, 9.2));
+        }
+        return seal(std::move(node));
+    }
+
+    static std::string arityError(const std::string &name, size_t operandCount)
+    {
+        return name + "() takes " + std::to_string(operandCount) + (operandCount == 1 ? " operand" : " operands");
+    }
+
+    [[noreturn]] void failParameter(size_t argumentStart, const std::string &name, const std::string &parameter)
+    {
+        m_position = argumentStart;
+        fail(name + "() has no parameter " + parameter);
+    }
+
+    void parseFractalParameter(size_t argumentStart, const std::string &name, const std::string &parameter,
+                               Instruction &instruction)
+    {
+        const size_t valueStart = m_position;
+        const double value = parseNumber();
+
+        const auto check = [&](bool bValid, const char *requirement) {
+            if (!bValid)
+            {
+                m_position = valueStart;
+                fail(parameter + " must be " + requirement);
+            }
+        };
+
+        if (parameter == "frequency")
+            instruction.frequency = value;
+        else if (parameter == "shiftX")
+            instruction.shiftX = value;
+        else if (parameter == "shiftY")
+            instruction.shiftY = value;
+        else if (name == "noise")
+            failParameter(argumentStart, name, parameter);
+        else if (parameter == "octaves")
+        {
+            check(value >= 1.0 && value <= 64.0 && value == std::floor(value), "an integer in [1, 64]");
+            instruction.octaves = static_cast<uint32_t>(value);
+        } else if (parameter == "persistence")
+            instruction.persistence = value;
+        else if (parameter == "lacunarity")
+        {
+            check(value > 0.0, "positive");
+            instruction.lacunarity = value;
+        } else if (name == "ridged" && parameter == "offset")
+            instruction.offset = value;
+        else if (name == "ridged" && parameter == "gain")
+            instruction.gain = value;
+        else
+            failParameter(argumentStart, name, parameter);
+    }
+
+    /**
+     * fbm(octaves=4, shiftX, shiftY): the shift decorrelates the x and y offsets of a warp
+     */
+    std::unique_ptr<Node> defaultWarp(double shiftX, double shiftY)
+    {
+        auto node = makeNode();
+        node->instruction.op = Op::Fractal;
+        node->instruction.fractal = Fractal::Fbm;
+        node->instruction.octaves = 4;
+        node->instruction.frequency = 1.0;
+        node->instruction.lacunarity = 2.0;
+        node->instruction.persistence = 0.5;
+        node->instruction.shiftX = shiftX;
+        node->instruction.shiftY = shiftY;
+        return node;
+    }
+};
+
+/**
+ * Bounds of the octave sum of a fractal node, every noise sample being within [-1, 1]
+ */
+Bounds fractalBounds(const Instruction &instruction, double noiseBound) noexcept
+{
+    // Ridged: (offset - |noise|)^2 with |noise| in [0, noiseBound], times a weight in [0, 1]
+    const double ridgeMax = std::max(instruction.offset * instruction.offset,
+                                     (instruction.offset - noiseBound) * (instruction.offset - noiseBound));
+
+    Bounds bounds{0.0, 0.0};
+    for (uint32_t octave = 0; octave < instruction.octaves; ++octave)
+    {
+        const double amplitude = std::pow(instruction.persistence, octave);
+        const double term = instruction.fractal == Fractal::Ridged ? amplitude * ridgeMax : amplitude * noiseBound;
+        if (instruction.fractal == Fractal::Fbm)
+        {
+            bounds.first -= std::abs(term);
+            bounds.second += std::abs(term);
+        } else
+        {
+            bounds.first += std::min(term, 0.0);
+            bounds.second += std::max(term, 0.0);
+        }
+    }
+    return bounds;
+}
+
+/**
+ * Emits the instructions of a tree, one register per value
+ */
+class Compiler final
+{
+public:
+    Compiler(std::vector<Instruction> &instructions, uint32_t &registerCount, uint32_t &contextCount,
+             double noiseBound)
+        : m_instructions{instructions},
+          m_registerCount{registerCount},
+          m_contextCount{contextCount},
+          m_noiseBound{noiseBound}
+    {
+    }
+
+    /**
+     * @return register holding the value of node evaluated in context, and its bounds
+     */
+    std::pair<uint32_t, Bounds> compile(const Node &node, uint32_t context)
+    {
+        Instruction instruction = node.instruction;
+
+        switch (instruction.op)
+        {
+        case Op::Constant: return {emit(instruction), {instruction.value, instruction.value}};
+        case Op::Fractal:
+            instruction.context = context;
+            return {emit(instruction), fractalBounds(instruction, m_noiseBound)};
+        case Op::Warp:
+        {
+            // The offsets are evaluated where the warp is, its source at the displaced coordinates
+            instruction.a = compile(*node.children[1], context).first;
+            instruction.b = compile(*node.children[2], context).first;
+            instruction.context = context;
+            instruction.output = m_contextCount++;
+            m_instructions.push_back(instruction);
+            return compile(*node.children[0], instruction.output);
+        }
+        case Op::Abs:
+        {
+            const auto [a, bounds] = compile(*node.children[0], context);
+            instruction.a = a;
+
+            if (bounds.first >= 0.0)
+                return {emit(instruction), bounds};
+            if (bounds.second <= 0.0)
+                return {emit(instruction), {-bounds.second, -bounds.first}};
+            return {emit(instruction), {0.0, std::max(-bounds.first, bounds.second)}};
+        }
+        default: break;
+        }
+
+        const auto [a, boundsA] = compile(*node.children[0], context);
+        const auto [b, boundsB] = compile(*node.children[1], context);
+        instruction.a = a;
+        instruction.b = b;
+
+        Bounds bounds{};
+        switch (instruction.op)
+        {
+        case Op::Add: bounds = {boundsA.first + boundsB.first, boundsA.second + boundsB.second}; break;
+        case Op::Subtract: bounds = {boundsA.first - boundsB.second, boundsA.second - boundsB.first}; break;
+        case Op::Multiply:
+        {
+            const std::array products{boundsA.first * boundsB.first, boundsA.first * boundsB.second,
+                                      boundsA.second * boundsB.first, boundsA.second * boundsB.second};
+            const auto [min, max] = std::minmax_element(products.begin(), products.end());
+            bounds = {*min, *max};
+            break;
+        }
+        case Op::Min:
+            bounds = {std::min(boundsA.first, boundsB.first), std::min(boundsA.second, boundsB.second)};
+            break;
+        case Op::Max:
+            bounds = {std::max(boundsA.first, boundsB.first), std::max(boundsA.second, boundsB.second)};
+            break;
+        default: break;
+        }
+        return {emit(instruction), bounds};
+    }
+
+private:
+    std::vector<Instruction> &m_instructions;
+    uint32_t &m_registerCount;
+    uint32_t &m_contextCount;
+    const double m_noiseBound;
+
+    uint32_t emit(Instruction instruction)
+    {
+        instruction.output = m_registerCount++;
+        m_instructions.push_back(instruction);
+        return instruction.output;
+    }
+};
+}  // namespace
+
+noisegen::Pipeline noisegen::Pipeline::compile(std::string_view source, double noiseBound)
+{
+    const auto root = Parser{source}.parse();
+
+    Pipeline pipeline{};
+    pipeline.m_source = source;
+
+    Compiler compiler{pipeline.m_instructions, pipeline.m_registerCount, pipeline.m_contextCount, noiseBound};
+    std::tie(pipeline.m_result, pipeline.m_bounds) = compiler.compile(*root, 0);
+    return pipeline;
+}
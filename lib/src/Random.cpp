@@ -17,7 +17,19 @@
  * 3. This notice may not be removed or altered from any source distribution.
  */
 
+#include <atomic>
+#include <random>
+
 #include "Random.hpp"
 
-std::random_device noisegen::Random::s_randomDevice{};
-std::mt19937 noisegen::Random::s_generator{s_randomDevice()};
+uint64_t noisegen::Random::randomSeed()
+{
+    static const uint64_t s_processSeed = [] {
+        std::random_device randomDevice{};
+        return (uint64_t{randomDevice()} << 32U) ^ randomDevice();
+    }();
+    static std::atomic<uint64_t> s_counter{0};
+
+    // Consecutive SplitMix64 outputs of the process stream, one per call
+    return SplitMix64{s_processSeed + s_counter.fetch_add(1, std::memory_order_relaxed) * 0x9E3779B97F4A7C15ULL}();
+}
@@ -17,28 +17,301 @@
  * 3. This notice may not be removed or altered from any source distribution.
  */
 
+
+#include <cstdlib>
 #include <iomanip>
+#include <fstream>
 #include <iostream>
-#include <sstream>
+#include <algorithm>
+#include <unordered_map>
 
 #include "ScopedProfiler.hpp"
 
-noisegen::utils::ScopedProfiler::ScopedProfiler(const char *name) noexcept : m_start{Clock::now()}, m_name{name}
+namespace {
+std::string displayName(const char *name, int64_t argument)
 {
+    std::string out{name};
+
+    if (argument != noisegen::utils::Profiler::NoArgument)
+        out += '[' + std::to_string(argument) + ']';
+    return out;
 }
 
-noisegen::utils::ScopedProfiler::~ScopedProfiler()
+uint64_t nanoseconds(std::chrono::steady_clock::duration duration) noexcept
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+}
+
+void writeJsonString(std::ostream &os, const std::string &value)
+{
+    os << '"';
+    for (const char c : value)
+    {
+        if (c == '"' || c == '\\')
+            os << '\\';
+        os << c;
+    }
+    os << '"';
+}
+}  // namespace
+
+noisegen::utils::Profiler &noisegen::utils::Profiler::instance()
+{
+    static Profiler s_instance{};
+
+    return s_instance;
+}
+
+noisegen::utils::Profiler::~Profiler()
+{
+    if (aggregate().empty())
+        return;
+
+    writeSummary(std::cerr);
+
+    if (const char *traceFile = std::getenv("NOISEGEN_TRACE_FILE"); traceFile != nullptr)
+    {
+        std::ofstream file{traceFile};
+        writeChromeTrace(file);
+    }
+}
+
+noisegen::utils::Profiler::ThreadBuffer &noisegen::utils::Profiler::threadBuffer()
+{
+    thread_local ThreadBuffer *t_buffer = nullptr;
+
+    if (t_buffer == nullptr)
+    {
+        const std::lock_guard lock{m_mutex};
+
+        m_buffers.push_back(std::make_unique<ThreadBuffer>());
+        t_buffer = m_buffers.back().get();
+        t_buffer->threadIndex = static_cast<uint32_t>(m_buffers.size() - 1);
+        t_buffer->events.reserve(4096);
+        t_buffer->random.seed(t_buffer->threadIndex + 1);
+    }
+    return *t_buffer;
+}
+
+uint32_t noisegen::utils::Profiler::enter()
+{
+    return threadBuffer().depth++;
+}
+
+void noisegen::utils::Profiler::leave(const char *name, int64_t argument, TimePoint start, TimePoint end,
+                                      uint32_t depth)
+{
+    auto &buffer = threadBuffer();
+
+    buffer.depth = depth;
+
+    // Accumulated scopes inside this one, one after the other from its start
+    uint64_t accumulatedStartNs = nanoseconds(start - m_epoch);
+    const auto inside = std::stable_partition(buffer.accumulated.begin(), buffer.accumulated.end(),
+                                              [depth](const Accumulated &entry) { return entry.depth <= depth; });
+    for (auto entry = inside; entry != buffer.accumulated.end(); ++entry)
+    {
+        record(buffer, entry->name, entry->argument, accumulatedStartNs, entry->durationNs, entry->depth);
+        accumulatedStartNs += entry->durationNs;
+    }
+    buffer.accumulated.erase(inside, buffer.accumulated.end());
+
+    record(buffer, name, argument, nanoseconds(start - m_epoch), nanoseconds(end - start), depth);
+}
+
+void noisegen::utils::Profiler::accumulate(const char *name, int64_t argument, TimePoint start, TimePoint end)
+{
+    auto &buffer = threadBuffer();
+    auto &accumulated = buffer.accumulated;
+
+    const auto it = std::find_if(accumulated.begin(), accumulated.end(), [&](const Accumulated &entry) {
+        return entry.name == name && entry.argument == argument && entry.depth == buffer.depth;
+    });
+    if (it != accumulated.end())
+        it->durationNs += nanoseconds(end - start);
+    else
+        accumulated.push_back({name, argument, buffer.depth, nanoseconds(end - start)});
+}
+
+void noisegen::utils::Profiler::record(ThreadBuffer &buffer, const char *name, int64_t argument, uint64_t startNs,
+                                       uint64_t durationNs, uint32_t depth)
+{
+    auto &statistics = buffer.statistics[{name, argument}];
+
+    ++statistics.count;
+    statistics.totalNs += durationNs;
+    statistics.minNs = std::min(statistics.minNs, durationNs);
+    statistics.maxNs = std::max(statistics.maxNs, durationNs);
+
+    // Reservoir sampling: every duration ends up in the reservoir with the same probability
+    if (statistics.reservoir.size() < ReservoirSize)
+        statistics.reservoir.push_back(durationNs);
+    else if (const uint64_t slot = buffer.random() % statistics.count; slot < ReservoirSize)
+        statistics.reservoir[slot] = durationNs;
+
+    const Event event{name, argument, startNs, durationNs, depth};
+    if (buffer.events.size() < MaxTraceEvents)
+        buffer.events.push_back(event);
+    else
+        buffer.events[buffer.eventCount % MaxTraceEvents] = event;
+    ++buffer.eventCount;
+}
+
+std::vector<noisegen::utils::Profiler::Aggregate> noisegen::utils::Profiler::aggregate() const
+{
+    const std::lock_guard lock{m_mutex};
+
+    // Threads are merged by display name, the same name can have a different address in another translation unit
+    struct Merged
+    {
+        Statistics statistics{};
+        std::vector<std::pair<uint64_t, double>> samples{};  // reservoir durations, weighted by what they stand for
+    };
+    std::unordered_map<std::string, Merged> mergedByName{};
+
+    for (const auto &buffer : m_buffers)
+    {
+        for (const auto &[key, statistics] : buffer->statistics)
+        {
+            auto &merged = mergedByName[displayName(key.first, key.second)];
+
+            merged.statistics.count += statistics.count;
+            merged.statistics.totalNs += statistics.totalNs;
+            merged.statistics.minNs = std::min(merged.statistics.minNs, statistics.minNs);
+            merged.statistics.maxNs = std::max(merged.statistics.maxNs, statistics.maxNs);
+
+            const double weight =
+              static_cast<double>(statistics.count) / static_cast<double>(statistics.reservoir.size());
+            for (const uint64_t duration : statistics.reservoir)
+                merged.samples.emplace_back(duration, weight);
+        }
+    }
+
+    std::vector<Aggregate> aggregates{};
+    aggregates.reserve(mergedByName.size());
+
+    for (auto &[name, merged] : mergedByName)
+    {
+        auto &samples = merged.samples;
+        std::sort(samples.begin(), samples.end());
+
+        // First duration with 99% of the weight at or below it
+        const double p99Weight = 0.99 * static_cast<double>(merged.statistics.count);
+        double weight = 0.0;
+        uint64_t p99 = samples.back().first;
+        for (const auto &[duration, sampleWeight] : samples)
+        {
+            weight += sampleWeight;
+            if (weight >= p99Weight)
+            {
+                p99 = duration;
+                break;
+            }
+        }
+
+        Aggregate aggregate{};
+        aggregate.name = name;
+        aggregate.count = merged.statistics.count;
+        aggregate.totalMs = static_cast<double>(merged.statistics.totalNs) / 1e6;
+        aggregate.minMs = static_cast<double>(merged.statistics.minNs) / 1e6;
+        aggregate.maxMs = static_cast<double>(merged.statistics.maxNs) / 1e6;
+        aggregate.p99Ms = static_cast<double>(p99) / 1e6;
+
+        aggregates.push_back(std::move(aggregate));
+    }
+
+    std::sort(aggregates.begin(), aggregates.end(),
+              [](const Aggregate &lhs, const Aggregate &rhs) { return lhs.totalMs > rhs.totalMs; });
+    return aggregates;
+}
+
+void noisegen::utils::Profiler::writeSummary(std::ostream &os) const
 {
-    const auto end = Clock::now();
-    const DurationSeconds durationSeconds = end - m_start;
-    const DurationMillis durationMillis = durationSeconds;
+    const auto aggregates = aggregate();
+
+    size_t nameWidth = 4;
+    for (const auto &aggregate : aggregates)
+        nameWidth = std::max(nameWidth, aggregate.name.size());
 
-    std::ostringstream oss{};
+    const auto flags = os.flags();
+    os << std::left << std::setw(static_cast<int>(nameWidth)) << "name" << std::right  //
+       << std::setw(10) << "count" << std::setw(14) << "total ms" << std::setw(12) << "min ms"
+       << std::setw(12) << "max ms" << std::setw(12) << "p99 ms" << '\n';
 
-    /*if (durationSeconds.count() >= 1)
-        oss << durationSeconds.count() << "s";
-    else*/
-    oss << durationMillis.count() << "ms";
+    os << std::fixed << std::setprecision(3);
+    for (const auto &[name, count, totalMs, minMs, maxMs, p99Ms] : aggregates)
+    {
+        os << std::left << std::setw(static_cast<int>(nameWidth)) << name << std::right  //
+           << std::setw(10) << count << std::setw(14) << totalMs << std::setw(12) << minMs << std::setw(12) << maxMs
+           << std::setw(12) << p99Ms << '\n';
+    }
+    os.flags(flags);
 
-    std::cerr << m_name << " => " << oss.str() << '\n';
+    uint64_t droppedEvents = 0;
+    {
+        const std::lock_guard lock{m_mutex};
+        for (const auto &buffer : m_buffers)
+            droppedEvents += buffer->eventCount - buffer->events.size();
+    }
+    if (droppedEvents != 0)
+        os << droppedEvents << " trace events dropped, the trace keeps the last " << MaxTraceEvents
+           << " of each thread\n";
+}
+
+void noisegen::utils::Profiler::writeChromeTrace(std::ostream &os) const
+{
+    const std::lock_guard lock{m_mutex};
+
+    // Complete ("X") events, timestamps and durations in microseconds
+    os << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+
+    bool bFirst = true;
+    os << std::fixed << std::setprecision(3);
+    for (const auto &buffer : m_buffers)
+    {
+        for (const auto &event : buffer->events)
+        {
+            os << (bFirst ? "" : ",\n") << "{\"name\": ";
+            writeJsonString(os, displayName(event.name, event.argument));
+            os << ", \"ph\": \"X\", \"pid\": 1, \"tid\": " << buffer->threadIndex
+               << ", \"ts\": " << static_cast<double>(event.startNs) / 1e3
+               << ", \"dur\": " << static_cast<double>(event.durationNs) / 1e3  //
+               << ", \"args\": {\"depth\": " << event.depth << "}}";
+            bFirst = false;
+        }
+    }
+    os << "\n]}\n";
+}
+
+void noisegen::utils::Profiler::clear()
+{
+    const std::lock_guard lock{m_mutex};
+
+    for (const auto &buffer : m_buffers)
+    {
+        buffer->statistics.clear();
+        buffer->events.clear();
+        buffer->eventCount = 0;
+        buffer->accumulated.clear();
+    }
+}
+
+noisegen::utils::ScopedProfiler::ScopedProfiler(const char *name, int64_t argument)
+    : m_name{name}, m_argument{argument}, m_depth{Profiler::instance().enter()}, m_start{Clock::now()}
+{
+}
+
+noisegen::utils::ScopedProfiler::~ScopedProfiler()
+{
+    Profiler::instance().leave(m_name, m_argument, m_start, Clock::now(), m_depth);
+}
+
+noisegen::utils::AccumulatedScopedProfiler::AccumulatedScopedProfiler(const char *name, int64_t argument) noexcept
+    : m_name{name}, m_argument{argument}, m_start{Clock::now()}
+{
+}
+
+noisegen::utils::AccumulatedScopedProfiler::~AccumulatedScopedProfiler()
+{
+    Profiler::instance().accumulate(m_name, m_argument, m_start, Clock::now());
 }
@@ -21,12 +21,81 @@
 
 #include "Settings.hpp"
 
+const char *noisegen::toString(ImageFormat format) noexcept
+{
+    switch (format)
+    {
+    case ImageFormat::PGMAscii: return "p2";
+    case ImageFormat::PGMBinary8: return "p5";
+    case ImageFormat::PGMBinary16: return "p5-16";
+    case ImageFormat::Raw8: return "raw";
+    case ImageFormat::Raw16: return "raw-16";
+    case ImageFormat::PNG8: return "png";
+    case ImageFormat::PNG16: return "png-16";
+    }
+    return "unknown";
+}
+
+bool noisegen::isRawFormat(ImageFormat format) noexcept
+{
+    return format == ImageFormat::Raw8 || format == ImageFormat::Raw16;
+}
+
+bool noisegen::isPNGFormat(ImageFormat format) noexcept
+{
+    return format == ImageFormat::PNG8 || format == ImageFormat::PNG16;
+}
+
+bool noisegen::is16BitFormat(ImageFormat format) noexcept
+{
+    return format == ImageFormat::PGMBinary16 || format == ImageFormat::Raw16 || format == ImageFormat::PNG16;
+}
+
+const char *noisegen::toString(Normalization normalization) noexcept
+{
+    switch (normalization)
+    {
+    case Normalization::MinMax: return "minmax";
+    case Normalization::Fixed: return "fixed";
+    case Normalization::Analytic: return "analytic";
+    }
+    return "unknown";
+}
+
+const char *noisegen::toString(Basis basis) noexcept
+{
+    switch (basis)
+    {
+    case Basis::Perlin: return "perlin";
+    case Basis::Simplex: return "simplex";
+    }
+    return "unknown";
+}
+
+const char *noisegen::toString(Precision precision) noexcept
+{
+    switch (precision)
+    {
+    case Precision::Float: return "float";
+    case Precision::Double: return "double";
+    }
+    return "unknown";
+}
+
 std::ostream &noisegen::operator<<(std::ostream &os, const noisegen::Settings &settings)
 {
     os << "width: " << settings.width << " height: " << settings.height << " octaves: " << settings.octaves
-       << " persistence: " << settings.persistence << " count: " << settings.count
+       << " persistence: " << settings.persistence << " count: " << settings.count << " depth: " << settings.depth
+       << " sliceSpacing: " << settings.sliceSpacing << " threads: " << settings.threads
+       << " maxMemory: " << settings.maxMemory << " normalization: " << noisegen::toString(settings.normalization)
+       << " rangeMin: " << settings.rangeMin << " rangeMax: " << settings.rangeMax
+       << " bPyramid: " << settings.bPyramid << " bMemoryMap: " << settings.bMemoryMap
        << " bUseKenPerlinPermutations: " << settings.bUseKenPerlinPermutations
-       << " outputFile: " << settings.outputFile;
+       << " seed: " << (settings.seed.has_value() ? std::to_string(settings.seed.value()) : "random")
+       << " outputFile: " << settings.outputFile << " normalMapFile: " << settings.normalMapFile
+       << " normalStrength: " << settings.normalStrength << " format: " << noisegen::toString(settings.format)
+       << " basis: " << noisegen::toString(settings.basis)
+       << " precision: " << noisegen::toString(settings.precision) << " pipeline: " << settings.pipeline;
     return os;
 }
 
@@ -0,0 +1,209 @@
+/*
+**   Copyright 2021 Maxime Rayé
+**
+**   Licensed under the Apache License, Version 2.0 (the "License");
+**   you may not use this file except in compliance with the License.
+**   You may obtain a copy of the License at
+**
+**       http://www.apache.org/licenses/LICENSE-2.0
+**
+**   Unless required by applicable law or agreed to in writing, software
+**   distributed under the License is distributed on an "AS IS" BASIS,
+**   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**   See the License for the specific language governing permissions and
+**   limitations under the License.
+*/
+
+#include <map>
+#include <utility>
+
+#include "ThreadPool.hpp"
+
+namespace {
+/**
+ * Pool and worker index of the parallelFor() task running on this thread, if any
+ */
+struct CurrentWorker
+{
+    const noisegen::ThreadPool *pool{};
+    uint32_t workerIndex{};
+};
+
+thread_local CurrentWorker t_currentWorker{};
+
+constexpr uint64_t packRange(uint32_t begin, uint32_t end) noexcept
+{
+    return (uint64_t{end} << 32U) | begin;
+}
+
+constexpr uint32_t rangeBegin(uint64_t range) noexcept
+{
+    return static_cast<uint32_t>(range);
+}
+
+constexpr uint32_t rangeEnd(uint64_t range) noexcept
+{
+    return static_cast<uint32_t>(range >> 32U);
+}
+}  // namespace
+
+noisegen::ThreadPool::ThreadPool(uint32_t threadCount)
+    : m_size{threadCount != 0 ? threadCount : std::max(std::thread::hardware_concurrency(), 1U)},
+      m_ranges{new WorkerRange[m_size]}
+{
+    m_threads.reserve(m_size - 1);
+    for (uint32_t workerIndex = 1; workerIndex < m_size; ++workerIndex)
+        m_threads.emplace_back(&ThreadPool::workerLoop, this, workerIndex);
+}
+
+noisegen::ThreadPool::~ThreadPool()
+{
+    {
+        const std::lock_guard lock{m_mutex};
+        m_bStop = true;
+    }
+    m_wakeCondition.notify_all();
+
+    for (auto &thread : m_threads)
+        thread.join();
+}
+
+std::shared_ptr<noisegen::ThreadPool> noisegen::ThreadPool::shared(uint32_t threadCount)
+{
+    return shared(threadCount, false);
+}
+
+std::shared_ptr<noisegen::ThreadPool> noisegen::ThreadPool::sharedForOutput(uint32_t threadCount)
+{
+    return shared(threadCount, true);
+}
+
+std::shared_ptr<noisegen::ThreadPool> noisegen::ThreadPool::shared(uint32_t threadCount, bool bOutput)
+{
+    static std::mutex s_mutex{};
+    static std::map<std::pair<uint32_t, bool>, std::shared_ptr<ThreadPool>> s_pools{};
+
+    const std::lock_guard lock{s_mutex};
+    auto &pool = s_pools[{threadCount, bOutput}];
+
+    if (pool == nullptr)
+        pool = std::make_shared<ThreadPool>(threadCount);
+    return pool;
+}
+
+void noisegen::ThreadPool::run(uint32_t count, Task task, const void *context)
+{
+    if (count == 0)
+        return;
+
+    // Nested in a task of this pool: waiting for m_runMutex would deadlock, the indices run inline instead
+    if (t_currentWorker.pool == this)
+    {
+        for (uint32_t index = 0; index < count; ++index)
+            task(context, index, t_currentWorker.workerIndex);
+        return;
+    }
+
+    const std::lock_guard runLock{m_runMutex};
+
+    {
+        const std::lock_guard lock{m_mutex};
+
+        for (uint32_t workerIndex = 0; workerIndex < m_size; ++workerIndex)
+        {
+            const auto begin = static_cast<uint32_t>(uint64_t{count} * workerIndex / m_size);
+            const auto end = static_cast<uint32_t>(uint64_t{count} * (workerIndex + 1) / m_size);
+
+            m_ranges[workerIndex].range.store(packRange(begin, end), std::memory_order_relaxed);
+        }
+
+        m_task = task;
+        m_context = context;
+        m_pendingWorkers = m_size - 1;
+        ++m_generation;
+    }
+    m_wakeCondition.notify_all();
+
+    work(0);
+
+    std::unique_lock lock{m_mutex};
+    m_doneCondition.wait(lock, [this] { return m_pendingWorkers == 0; });
+}
+
+void noisegen::ThreadPool::workerLoop(uint32_t workerIndex)
+{
+    uint64_t lastGeneration = 0;
+
+    while (true)
+    {
+        {
+            std::unique_lock lock{m_mutex};
+            m_wakeCondition.wait(lock, [&] { return m_bStop || m_generation != lastGeneration; });
+
+            if (m_bStop)
+                return;
+            lastGeneration = m_generation;
+        }
+
+        work(workerIndex);
+
+        {
+            const std::lock_guard lock{m_mutex};
+            if (--m_pendingWorkers == 0)
+                m_doneCondition.notify_one();
+        }
+    }
+}
+
+void noisegen::ThreadPool::work(uint32_t workerIndex) noexcept
+{
+    uint32_t index{};
+    const CurrentWorker previousWorker = t_currentWorker;
+
+    t_currentWorker = CurrentWorker{this, workerIndex};
+    while (popIndex(workerIndex, index) || stealIndex(workerIndex, index))
+        m_task(m_context, index, workerIndex);
+    t_currentWorker = previousWorker;
+}
+
+bool noisegen::ThreadPool::popIndex(uint32_t workerIndex, uint32_t &index) noexcept
+{
+    auto &range = m_ranges[workerIndex].range;
+    uint64_t current = range.load(std::memory_order_acquire);
+
+    while (rangeBegin(current) < rangeEnd(current))
+    {
+        if (range.compare_exchange_weak(current, packRange(rangeBegin(current) + 1, rangeEnd(current)),
+                                        std::memory_order_acq_rel))
+        {
+            index = rangeBegin(current);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool noisegen::ThreadPool::stealIndex(uint32_t workerIndex, uint32_t &index) noexcept
+{
+    for (uint32_t offset = 1; offset < m_size; ++offset)
+    {
+        auto &victim = m_ranges[(workerIndex + offset) % m_size].range;
+        uint64_t current = victim.load(std::memory_order_acquire);
+
+        while (rangeBegin(current) < rangeEnd(current))
+        {
+            const uint32_t begin = rangeBegin(current);
+            const uint32_t end = rangeEnd(current);
+            const uint32_t middle = begin + (end - begin) / 2;
+
+            if (victim.compare_exchange_weak(current, packRange(begin, middle), std::memory_order_acq_rel))
+            {
+                // Keep the first stolen index, the rest becomes our own range (which nobody steals from while empty)
+                index = middle;
+                m_ranges[workerIndex].range.store(packRange(middle + 1, end), std::memory_order_release);
+                return true;
+            }
+        }
+    }
+    return false;
+}
@@ -0,0 +1,188 @@
+/*
+**   Copyright 2021 Maxime Rayé
+**
+**   Licensed under the Apache License, Version 2.0 (the "License");
+**   you may not use this file except in compliance with the License.
+**   You may obtain a copy of the License at
+**
+**       http://www.apache.org/licenses/LICENSE-2.0
+**
+**   Unless required by applicable law or agreed to in writing, software
+**   distributed under the License is distributed on an "AS IS" BASIS,
+**   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**   See the License for the specific language governing permissions and
+**   limitations under the License.
+*/
+
+#include <cmath>
+#include <algorithm>
+#include <functional>
+
+#include "TileCache.hpp"
+#include "ScopedProfiler.hpp"
+
+namespace {
+int64_t floorDivide(int64_t value, int64_t divisor) noexcept
+{
+    return value / divisor - (value % divisor < 0 ? 1 : 0);
+}
+}  // namespace
+
+template<typename Real>
+noisegen::BasicTileCache<Real>::BasicTileCache(uint64_t maxBytes, uint32_t tileSize)
+    : m_maxBytes{maxBytes}, m_tileSize{std::max(tileSize, 1U)}
+{
+}
+
+template<typename Real>
+typename noisegen::BasicTileCache<Real>::Tile
+noisegen::BasicTileCache<Real>::getTile(const BasicGenerator<Real> &generator, int32_t zoom, int64_t tileX,
+                                        int64_t tileY)
+{
+    NOISEGEN_SCOPED_PROFILER("TileCache::getTile()");
+
+    const Key key = makeKey(generator, zoom, tileX, tileY);
+
+    {
+        const std::lock_guard lock{m_mutex};
+
+        if (const auto it = m_index.find(key); it != m_index.end())
+        {
+            m_lru.splice(m_lru.begin(), m_lru, it->second);
+            ++m_statistics.hits;
+            return it->second->second;
+        }
+        ++m_statistics.misses;
+    }
+
+    // Rendered outside of the lock, hits don't wait for misses
+    // Tile origins are integers divided by a power of two, exact like the samples inside the tiles
+    const double scale = std::ldexp(1.0 / m_tileSize, -zoom);
+    auto image = std::make_shared<Image>();
+    generator.generateRegion(std::ldexp(static_cast<double>(tileX), -zoom),
+                             std::ldexp(static_cast<double>(tileY), -zoom), scale, m_tileSize, m_tileSize, *image);
+    Tile tile = std::move(image);
+
+    const std::lock_guard lock{m_mutex};
+
+    if (const auto it = m_index.find(key); it != m_index.end())
+    {
+        m_lru.splice(m_lru.begin(), m_lru, it->second);
+        return it->second->second;
+    }
+
+    m_lru.emplace_front(key, tile);
+    m_index.emplace(key, m_lru.begin());
+    m_statistics.bytes += tile->size() * sizeof(Real);
+    evict();
+
+    return tile;
+}
+
+template<typename Real>
+void noisegen::BasicTileCache<Real>::renderViewport(const BasicGenerator<Real> &generator, int32_t zoom, int64_t x,
+                                                    int64_t y, uint32_t width, uint32_t height, Image &out)
+{
+    NOISEGEN_SCOPED_PROFILER("TileCache::renderViewport()");
+
+    if (out.width() != width || out.height() != height)
+        out = Image{width, height};
+
+    const int64_t size = m_tileSize;
+    const int64_t right = x + width;
+    const int64_t bottom = y + height;
+
+    for (int64_t tileY = floorDivide(y, size); tileY * size < bottom; ++tileY)
+    {
+        for (int64_t tileX = floorDivide(x, size); tileX * size < right; ++tileX)
+        {
+            const Tile tile = getTile(generator, zoom, tileX, tileY);
+
+            // Part of the tile inside the window, in level coordinates
+            const int64_t left = std::max(tileX * size, x);
+            const int64_t top = std::max(tileY * size, y);
+            const int64_t count = std::min((tileX + 1) * size, right) - left;
+
+            for (int64_t row = top; row < std::min((tileY + 1) * size, bottom); ++row)
+            {
+                const Real *source = tile->row(static_cast<uint32_t>(row - tileY * size)) + (left - tileX * size);
+                std::copy(source, source + count, out.row(static_cast<uint32_t>(row - y)) + (left - x));
+            }
+        }
+    }
+}
+
+template<typename Real>
+typename noisegen::BasicTileCache<Real>::Statistics noisegen::BasicTileCache<Real>::getStatistics() const
+{
+    const std::lock_guard lock{m_mutex};
+
+    Statistics statistics = m_statistics;
+    statistics.tileCount = m_lru.size();
+    return statistics;
+}
+
+template<typename Real>
+void noisegen::BasicTileCache<Real>::clear()
+{
+    const std::lock_guard lock{m_mutex};
+
+    m_index.clear();
+    m_lru.clear();
+    m_statistics.bytes = 0;
+}
+
+template<typename Real>
+bool noisegen::BasicTileCache<Real>::Key::operator==(const Key &other) const noexcept
+{
+    return permutations == other.permutations && octaves == other.octaves && persistence == other.persistence
+           && pipeline == other.pipeline && basis == other.basis && zoom == other.zoom && tileX == other.tileX
+           && tileY == other.tileY;
+}
+
+template<typename Real>
+size_t noisegen::BasicTileCache<Real>::KeyHash::operator()(const Key &key) const noexcept
+{
+    // FNV-1a over the permutations, then boost::hash_combine style mixing of the other members
+    uint64_t hash = 14695981039346656037ULL;
+    for (const uint8_t value : key.permutations)
+        hash = (hash ^ value) * 1099511628211ULL;
+
+    const auto combine = [&hash](size_t value) { hash ^= value + 0x9E3779B97F4A7C15ULL + (hash << 6U) + (hash >> 2U); };
+    combine(std::hash<uint32_t>{}(key.octaves));
+    combine(std::hash<double>{}(key.persistence));
+    combine(std::hash<std::string>{}(key.pipeline));
+    combine(std::hash<int32_t>{}(static_cast<int32_t>(key.basis)));
+    combine(std::hash<int32_t>{}(key.zoom));
+    combine(std::hash<int64_t>{}(key.tileX));
+    combine(std::hash<int64_t>{}(key.tileY));
+
+    return hash;
+}
+
+template<typename Real>
+typename noisegen::BasicTileCache<Real>::Key
+noisegen::BasicTileCache<Real>::makeKey(const BasicGenerator<Real> &generator, int32_t zoom, int64_t tileX,
+                                        int64_t tileY) const
+{
+    const Settings &settings = generator.getSettings();
+
+    return {generator.getPermutationArray(), settings.octaves, settings.persistence, settings.pipeline, settings.basis,
+            zoom, tileX, tileY};
+}
+
+template<typename Real>
+void noisegen::BasicTileCache<Real>::evict()
+{
+    while (m_statistics.bytes > m_maxBytes && !m_lru.empty())
+    {
+        m_statistics.bytes -= m_lru.back().second->size() * sizeof(Real);
+        ++m_statistics.evictions;
+
+        m_index.erase(m_lru.back().first);
+        m_lru.pop_back();
+    }
+}
+
+template class noisegen::BasicTileCache<float>;
+template class noisegen::BasicTileCache<double>;
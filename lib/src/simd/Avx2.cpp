@@ -0,0 +1,258 @@
+/*
+**   Copyright 2021 Maxime Rayé
+**
+**   Licensed under the Apache License, Version 2.0 (the "License");
+**   you may not use this file except in compliance with the License.
+**   You may obtain a copy of the License at
+**
+**       http://www.apache.org/licenses/LICENSE-2.0
+**
+**   Unless required by applicable law or agreed to in writing, software
+**   distributed under the License is distributed on an "AS IS" BASIS,
+**   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**   See the License for the specific language governing permissions and
+**   limitations under the License.
+*/
+
+/*
+ * Compiled with -mavx2 (/arch:AVX2), only ever called after a runtime check, see Dispatch.cpp.
+ */
+
+#if NOISEGEN_SIMD_X86
+
+    #include <immintrin.h>
+
+    #include "Kernels.hpp"
+    #include "PerlinKernel.hpp"
+    #include "SimplexKernel.hpp"
+
+namespace {
+struct Avx2Double
+{
+    using Real = double;
+    using Vec = __m256d;
+    using Index = __m128i;
+    static constexpr size_t Width = 4;
+
+    static inline Vec load(const Real *p) noexcept { return _mm256_loadu_pd(p); }
+    static inline void store(Real *p, Vec v) noexcept { _mm256_storeu_pd(p, v); }
+    static inline Vec set1(int value) noexcept { return _mm256_set1_pd(value); }
+    static inline Vec broadcast(Real value) noexcept { return _mm256_set1_pd(value); }
+    static inline Vec add(Vec a, Vec b) noexcept { return _mm256_add_pd(a, b); }
+    static inline Vec sub(Vec a, Vec b) noexcept { return _mm256_sub_pd(a, b); }
+    static inline Vec mul(Vec a, Vec b) noexcept { return _mm256_mul_pd(a, b); }
+    static inline Vec floor(Vec v) noexcept { return _mm256_floor_pd(v); }
+    static inline Vec max(Vec a, Vec b) noexcept { return _mm256_max_pd(a, b); }
+    static inline Vec greaterEqual(Vec a, Vec b) noexcept
+    {
+        return _mm256_and_pd(_mm256_cmp_pd(a, b, _CMP_GE_OQ), _mm256_set1_pd(1.0));
+    }
+
+    static inline Index toIndex(Vec floored) noexcept
+    {
+        return _mm_and_si128(_mm256_cvttpd_epi32(floored), _mm_set1_epi32(255));
+    }
+    static inline Index addIndex(Index a, Index b) noexcept { return _mm_add_epi32(a, b); }
+    static inline Index increment(Index a) noexcept { return _mm_add_epi32(a, _mm_set1_epi32(1)); }
+    static inline Index gather(const int32_t *table, Index index) noexcept
+    {
+        return _mm_i32gather_epi32(table, index, 4);
+    }
+
+    static inline Vec grad(Index hash, Vec x, Vec y, Vec z) noexcept
+    {
+        const __m256i h = _mm256_and_si256(_mm256_cvtepi32_epi64(hash), _mm256_set1_epi64x(15));
+
+        const __m256i hLess8 = _mm256_cmpgt_epi64(_mm256_set1_epi64x(8), h);
+        const __m256i hLess4 = _mm256_cmpgt_epi64(_mm256_set1_epi64x(4), h);
+        const __m256i h12or14 =
+          _mm256_or_si256(_mm256_cmpeq_epi64(h, _mm256_set1_epi64x(12)), _mm256_cmpeq_epi64(h, _mm256_set1_epi64x(14)));
+
+        const Vec u = _mm256_blendv_pd(y, x, _mm256_castsi256_pd(hLess8));
+        const Vec v = _mm256_blendv_pd(_mm256_blendv_pd(z, x, _mm256_castsi256_pd(h12or14)), y,
+                                       _mm256_castsi256_pd(hLess4));
+
+        // (h & 1) and (h & 2) moved to the sign bit, to negate u and v without branching
+        const __m256i signU = _mm256_slli_epi64(_mm256_and_si256(h, _mm256_set1_epi64x(1)), 63);
+        const __m256i signV = _mm256_slli_epi64(_mm256_and_si256(h, _mm256_set1_epi64x(2)), 62);
+
+        return _mm256_add_pd(_mm256_xor_pd(u, _mm256_castsi256_pd(signU)),
+                             _mm256_xor_pd(v, _mm256_castsi256_pd(signV)));
+    }
+};
+
+struct Avx2Float
+{
+    using Real = float;
+    using Vec = __m256;
+    using Index = __m256i;
+    static constexpr size_t Width = 8;
+
+    static inline Vec load(const Real *p) noexcept { return _mm256_loadu_ps(p); }
+    static inline void store(Real *p, Vec v) noexcept { _mm256_storeu_ps(p, v); }
+    static inline Vec set1(int value) noexcept { return _mm256_set1_ps(static_cast<float>(value)); }
+    static inline Vec broadcast(Real value) noexcept { return _mm256_set1_ps(value); }
+    static inline Vec add(Vec a, Vec b) noexcept { return _mm256_add_ps(a, b); }
+    static inline Vec sub(Vec a, Vec b) noexcept { return _mm256_sub_ps(a, b); }
+    static inline Vec mul(Vec a, Vec b) noexcept { return _mm256_mul_ps(a, b); }
+    static inline Vec floor(Vec v) noexcept { return _mm256_floor_ps(v); }
+    static inline Vec max(Vec a, Vec b) noexcept { return _mm256_max_ps(a, b); }
+    static inline Vec greaterEqual(Vec a, Vec b) noexcept
+    {
+        return _mm256_and_ps(_mm256_cmp_ps(a, b, _CMP_GE_OQ), _mm256_set1_ps(1.0F));
+    }
+
+    static inline Index toIndex(Vec floored) noexcept
+    {
+        return _mm256_and_si256(_mm256_cvttps_epi32(floored), _mm256_set1_epi32(255));
+    }
+    static inline Index addIndex(Index a, Index b) noexcept { return _mm256_add_epi32(a, b); }
+    static inline Index increment(Index a) noexcept { return _mm256_add_epi32(a, _mm256_set1_epi32(1)); }
+    static inline Index gather(const int32_t *table, Index index) noexcept
+    {
+        return _mm256_i32gather_epi32(table, index, 4);
+    }
+
+    static inline Vec grad(Index hash, Vec x, Vec y, Vec z) noexcept
+    {
+        const __m256i h = _mm256_and_si256(hash, _mm256_set1_epi32(15));
+
+        const __m256i hLess8 = _mm256_cmpgt_epi32(_mm256_set1_epi32(8), h);
+        const __m256i hLess4 = _mm256_cmpgt_epi32(_mm256_set1_epi32(4), h);
+        const __m256i h12or14 =
+          _mm256_or_si256(_mm256_cmpeq_epi32(h, _mm256_set1_epi32(12)), _mm256_cmpeq_epi32(h, _mm256_set1_epi32(14)));
+
+        const Vec u = _mm256_blendv_ps(y, x, _mm256_castsi256_ps(hLess8));
+        const Vec v = _mm256_blendv_ps(_mm256_blendv_ps(z, x, _mm256_castsi256_ps(h12or14)), y,
+                                       _mm256_castsi256_ps(hLess4));
+
+        const __m256i signU = _mm256_slli_epi32(_mm256_and_si256(h, _mm256_set1_epi32(1)), 31);
+        const __m256i signV = _mm256_slli_epi32(_mm256_and_si256(h, _mm256_set1_epi32(2)), 30);
+
+        return _mm256_add_ps(_mm256_xor_ps(u, _mm256_castsi256_ps(signU)),
+                             _mm256_xor_ps(v, _mm256_castsi256_ps(signV)));
+    }
+};
+}  // namespace
+
+void noisegen::simd::noise3DBatchAvx2(const int32_t *permutations, const double *xs, const double *ys,
+                                      const double *zs, double *out, size_t n) noexcept
+{
+    noise3DBatch<Avx2Double>(permutations, xs, ys, zs, out, n);
+}
+
+void noisegen::simd::noise3DBatchAvx2(const int32_t *permutations, const float *xs, const float *ys, const float *zs,
+                                      float *out, size_t n) noexcept
+{
+    noise3DBatch<Avx2Float>(permutations, xs, ys, zs, out, n);
+}
+
+void noisegen::simd::noise2DBatchAvx2(const int32_t *permutations, const double *xs, const double *ys, double *out,
+                                      size_t n) noexcept
+{
+    noise2DBatch<Avx2Double>(permutations, xs, ys, out, n);
+}
+
+void noisegen::simd::noise2DBatchAvx2(const int32_t *permutations, const float *xs, const float *ys, float *out,
+                                      size_t n) noexcept
+{
+    noise2DBatch<Avx2Float>(permutations, xs, ys, out, n);
+}
+
+void noisegen::simd::noise3DRowAvx2(const int32_t *permutations, const double *xs, double y, double z, double *out,
+                                    size_t n) noexcept
+{
+    noise3DRow<Avx2Double>(permutations, xs, y, z, out, n);
+}
+
+void noisegen::simd::noise3DRowAvx2(const int32_t *permutations, const float *xs, float y, float z, float *out,
+                                    size_t n) noexcept
+{
+    noise3DRow<Avx2Float>(permutations, xs, y, z, out, n);
+}
+
+void noisegen::simd::noise2DRowAvx2(const int32_t *permutations, const double *xs, double y, double *out,
+                                    size_t n) noexcept
+{
+    noise2DRow<Avx2Double>(permutations, xs, y, out, n);
+}
+
+void noisegen::simd::noise2DRowAvx2(const int32_t *permutations, const float *xs, float y, float *out,
+                                    size_t n) noexcept
+{
+    noise2DRow<Avx2Float>(permutations, xs, y, out, n);
+}
+
+void noisegen::simd::simplex3DBatchAvx2(const int32_t *permutations, const double *xs, const double *ys,
+                                        const double *zs, double *out, size_t n) noexcept
+{
+    simplex3DBatch<Avx2Double>(permutations, xs, ys, zs, out, n);
+}
+
+void noisegen::simd::simplex3DBatchAvx2(const int32_t *permutations, const float *xs, const float *ys,
+                                        const float *zs, float *out, size_t n) noexcept
+{
+    simplex3DBatch<Avx2Float>(permutations, xs, ys, zs, out, n);
+}
+
+void noisegen::simd::simplex2DBatchAvx2(const int32_t *permutations, const double *xs, const double *ys,
+                                        double *out, size_t n) noexcept
+{
+    simplex2DBatch<Avx2Double>(permutations, xs, ys, out, n);
+}
+
+void noisegen::simd::simplex2DBatchAvx2(const int32_t *permutations, const float *xs, const float *ys,
+                                        float *out, size_t n) noexcept
+{
+    simplex2DBatch<Avx2Float>(permutations, xs, ys, out, n);
+}
+
+void noisegen::simd::simplex3DRowAvx2(const int32_t *permutations, const double *xs, double y, double z, double *out,
+                                      size_t n) noexcept
+{
+    simplex3DRow<Avx2Double>(permutations, xs, y, z, out, n);
+}
+
+void noisegen::simd::simplex3DRowAvx2(const int32_t *permutations, const float *xs, float y, float z, float *out,
+                                      size_t n) noexcept
+{
+    simplex3DRow<Avx2Float>(permutations, xs, y, z, out, n);
+}
+
+void noisegen::simd::simplex2DRowAvx2(const int32_t *permutations, const double *xs, double y, double *out,
+                                      size_t n) noexcept
+{
+    simplex2DRow<Avx2Double>(permutations, xs, y, out, n);
+}
+
+void noisegen::simd::simplex2DRowAvx2(const int32_t *permutations, const float *xs, float y, float *out,
+                                      size_t n) noexcept
+{
+    simplex2DRow<Avx2Float>(permutations, xs, y, out, n);
+}
+
+void noisegen::simd::noise2DDerivativesRowAvx2(const int32_t *permutations, const double *xs, double y, double *out,
+                                               double *dxs, double *dys, size_t n) noexcept
+{
+    noise2DDerivativesRow<Avx2Double>(permutations, xs, y, out, dxs, dys, n);
+}
+
+void noisegen::simd::noise2DDerivativesRowAvx2(const int32_t *permutations, const float *xs, float y, float *out,
+                                               float *dxs, float *dys, size_t n) noexcept
+{
+    noise2DDerivativesRow<Avx2Float>(permutations, xs, y, out, dxs, dys, n);
+}
+
+void noisegen::simd::simplex2DDerivativesRowAvx2(const int32_t *permutations, const double *xs, double y, double *out,
+                                                 double *dxs, double *dys, size_t n) noexcept
+{
+    simplex2DDerivativesRow<Avx2Double>(permutations, xs, y, out, dxs, dys, n);
+}
+
+void noisegen::simd::simplex2DDerivativesRowAvx2(const int32_t *permutations, const float *xs, float y, float *out,
+                                                 float *dxs, float *dys, size_t n) noexcept
+{
+    simplex2DDerivativesRow<Avx2Float>(permutations, xs, y, out, dxs, dys, n);
+}
+
+#endif
@@ -0,0 +1,263 @@
+/*
+**   Copyright 2021 Maxime Rayé
+**
+**   Licensed under the Apache License, Version 2.0 (the "License");
+**   you may not use this file except in compliance with the License.
+**   You may obtain a copy of the License at
+**
+**       http://www.apache.org/licenses/LICENSE-2.0
+**
+**   Unless required by applicable law or agreed to in writing, software
+**   distributed under the License is distributed on an "AS IS" BASIS,
+**   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**   See the License for the specific language governing permissions and
+**   limitations under the License.
+*/
+
+/*
+ * Compiled with -mavx512f (/arch:AVX512), only ever called after a runtime check, see Dispatch.cpp.
+ * Only AVX-512F instructions are used.
+ */
+
+#if NOISEGEN_SIMD_X86
+
+    #include <immintrin.h>
+
+    #include "Kernels.hpp"
+    #include "PerlinKernel.hpp"
+    #include "SimplexKernel.hpp"
+
+namespace {
+struct Avx512Double
+{
+    using Real = double;
+    using Vec = __m512d;
+    using Index = __m256i;
+    static constexpr size_t Width = 8;
+
+    static inline Vec load(const Real *p) noexcept { return _mm512_loadu_pd(p); }
+    static inline void store(Real *p, Vec v) noexcept { _mm512_storeu_pd(p, v); }
+    static inline Vec set1(int value) noexcept { return _mm512_set1_pd(value); }
+    static inline Vec broadcast(Real value) noexcept { return _mm512_set1_pd(value); }
+    static inline Vec add(Vec a, Vec b) noexcept { return _mm512_add_pd(a, b); }
+    static inline Vec sub(Vec a, Vec b) noexcept { return _mm512_sub_pd(a, b); }
+    static inline Vec mul(Vec a, Vec b) noexcept { return _mm512_mul_pd(a, b); }
+    static inline Vec floor(Vec v) noexcept
+    {
+        return _mm512_roundscale_pd(v, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+    }
+    static inline Vec max(Vec a, Vec b) noexcept { return _mm512_max_pd(a, b); }
+    static inline Vec greaterEqual(Vec a, Vec b) noexcept
+    {
+        return _mm512_maskz_mov_pd(_mm512_cmp_pd_mask(a, b, _CMP_GE_OQ), _mm512_set1_pd(1.0));
+    }
+
+    static inline Index toIndex(Vec floored) noexcept
+    {
+        return _mm256_and_si256(_mm512_cvttpd_epi32(floored), _mm256_set1_epi32(255));
+    }
+    static inline Index addIndex(Index a, Index b) noexcept { return _mm256_add_epi32(a, b); }
+    static inline Index increment(Index a) noexcept { return _mm256_add_epi32(a, _mm256_set1_epi32(1)); }
+    static inline Index gather(const int32_t *table, Index index) noexcept
+    {
+        return _mm256_i32gather_epi32(table, index, 4);
+    }
+
+    static inline Vec grad(Index hash, Vec x, Vec y, Vec z) noexcept
+    {
+        const __m512i h = _mm512_and_si512(_mm512_cvtepi32_epi64(hash), _mm512_set1_epi64(15));
+
+        const __mmask8 hLess8 = _mm512_cmplt_epi64_mask(h, _mm512_set1_epi64(8));
+        const __mmask8 hLess4 = _mm512_cmplt_epi64_mask(h, _mm512_set1_epi64(4));
+        const __mmask8 h12or14 = static_cast<__mmask8>(_mm512_cmpeq_epi64_mask(h, _mm512_set1_epi64(12))
+                                                       | _mm512_cmpeq_epi64_mask(h, _mm512_set1_epi64(14)));
+
+        const Vec u = _mm512_mask_blend_pd(hLess8, y, x);
+        const Vec v = _mm512_mask_blend_pd(hLess4, _mm512_mask_blend_pd(h12or14, z, x), y);
+
+        // (h & 1) and (h & 2) moved to the sign bit, to negate u and v without branching
+        const __m512i signU = _mm512_slli_epi64(_mm512_and_si512(h, _mm512_set1_epi64(1)), 63);
+        const __m512i signV = _mm512_slli_epi64(_mm512_and_si512(h, _mm512_set1_epi64(2)), 62);
+
+        return _mm512_add_pd(_mm512_castsi512_pd(_mm512_xor_si512(_mm512_castpd_si512(u), signU)),
+                             _mm512_castsi512_pd(_mm512_xor_si512(_mm512_castpd_si512(v), signV)));
+    }
+};
+
+struct Avx512Float
+{
+    using Real = float;
+    using Vec = __m512;
+    using Index = __m512i;
+    static constexpr size_t Width = 16;
+
+    static inline Vec load(const Real *p) noexcept { return _mm512_loadu_ps(p); }
+    static inline void store(Real *p, Vec v) noexcept { _mm512_storeu_ps(p, v); }
+    static inline Vec set1(int value) noexcept { return _mm512_set1_ps(static_cast<float>(value)); }
+    static inline Vec broadcast(Real value) noexcept { return _mm512_set1_ps(value); }
+    static inline Vec add(Vec a, Vec b) noexcept { return _mm512_add_ps(a, b); }
+    static inline Vec sub(Vec a, Vec b) noexcept { return _mm512_sub_ps(a, b); }
+    static inline Vec mul(Vec a, Vec b) noexcept { return _mm512_mul_ps(a, b); }
+    static inline Vec floor(Vec v) noexcept
+    {
+        return _mm512_roundscale_ps(v, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+    }
+    static inline Vec max(Vec a, Vec b) noexcept { return _mm512_max_ps(a, b); }
+    static inline Vec greaterEqual(Vec a, Vec b) noexcept
+    {
+        return _mm512_maskz_mov_ps(_mm512_cmp_ps_mask(a, b, _CMP_GE_OQ), _mm512_set1_ps(1.0F));
+    }
+
+    static inline Index toIndex(Vec floored) noexcept
+    {
+        return _mm512_and_si512(_mm512_cvttps_epi32(floored), _mm512_set1_epi32(255));
+    }
+    static inline Index addIndex(Index a, Index b) noexcept { return _mm512_add_epi32(a, b); }
+    static inline Index increment(Index a) noexcept { return _mm512_add_epi32(a, _mm512_set1_epi32(1)); }
+    static inline Index gather(const int32_t *table, Index index) noexcept
+    {
+        return _mm512_i32gather_epi32(index, table, 4);
+    }
+
+    static inline Vec grad(Index hash, Vec x, Vec y, Vec z) noexcept
+    {
+        const __m512i h = _mm512_and_si512(hash, _mm512_set1_epi32(15));
+
+        const __mmask16 hLess8 = _mm512_cmplt_epi32_mask(h, _mm512_set1_epi32(8));
+        const __mmask16 hLess4 = _mm512_cmplt_epi32_mask(h, _mm512_set1_epi32(4));
+        const __mmask16 h12or14 = static_cast<__mmask16>(_mm512_cmpeq_epi32_mask(h, _mm512_set1_epi32(12))
+                                                         | _mm512_cmpeq_epi32_mask(h, _mm512_set1_epi32(14)));
+
+        const Vec u = _mm512_mask_blend_ps(hLess8, y, x);
+        const Vec v = _mm512_mask_blend_ps(hLess4, _mm512_mask_blend_ps(h12or14, z, x), y);
+
+        const __m512i signU = _mm512_slli_epi32(_mm512_and_si512(h, _mm512_set1_epi32(1)), 31);
+        const __m512i signV = _mm512_slli_epi32(_mm512_and_si512(h, _mm512_set1_epi32(2)), 30);
+
+        return _mm512_add_ps(_mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(u), signU)),
+                             _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(v), signV)));
+    }
+};
+}  // namespace
+
+void noisegen::simd::noise3DBatchAvx512(const int32_t *permutations, const double *xs, const double *ys,
+                                        const double *zs, double *out, size_t n) noexcept
+{
+    noise3DBatch<Avx512Double>(permutations, xs, ys, zs, out, n);
+}
+
+void noisegen::simd::noise3DBatchAvx512(const int32_t *permutations, const float *xs, const float *ys,
+                                        const float *zs, float *out, size_t n) noexcept
+{
+    noise3DBatch<Avx512Float>(permutations, xs, ys, zs, out, n);
+}
+
+void noisegen::simd::noise2DBatchAvx512(const int32_t *permutations, const double *xs, const double *ys, double *out,
+                                        size_t n) noexcept
+{
+    noise2DBatch<Avx512Double>(permutations, xs, ys, out, n);
+}
+
+void noisegen::simd::noise2DBatchAvx512(const int32_t *permutations, const float *xs, const float *ys, float *out,
+                                        size_t n) noexcept
+{
+    noise2DBatch<Avx512Float>(permutations, xs, ys, out, n);
+}
+
+void noisegen::simd::noise3DRowAvx512(const int32_t *permutations, const double *xs, double y, double z, double *out,
+                                      size_t n) noexcept
+{
+    noise3DRow<Avx512Double>(permutations, xs, y, z, out, n);
+}
+
+void noisegen::simd::noise3DRowAvx512(const int32_t *permutations, const float *xs, float y, float z, float *out,
+                                      size_t n) noexcept
+{
+    noise3DRow<Avx512Float>(permutations, xs, y, z, out, n);
+}
+
+void noisegen::simd::noise2DRowAvx512(const int32_t *permutations, const double *xs, double y, double *out,
+                                      size_t n) noexcept
+{
+    noise2DRow<Avx512Double>(permutations, xs, y, out, n);
+}
+
+void noisegen::simd::noise2DRowAvx512(const int32_t *permutations, const float *xs, float y, float *out,
+                                      size_t n) noexcept
+{
+    noise2DRow<Avx512Float>(permutations, xs, y, out, n);
+}
+
+void noisegen::simd::simplex3DBatchAvx512(const int32_t *permutations, const double *xs, const double *ys,
+                                          const double *zs, double *out, size_t n) noexcept
+{
+    simplex3DBatch<Avx512Double>(permutations, xs, ys, zs, out, n);
+}
+
+void noisegen::simd::simplex3DBatchAvx512(const int32_t *permutations, const float *xs, const float *ys,
+                                          const float *zs, float *out, size_t n) noexcept
+{
+    simplex3DBatch<Avx512Float>(permutations, xs, ys, zs, out, n);
+}
+
+void noisegen::simd::simplex2DBatchAvx512(const int32_t *permutations, const double *xs, const double *ys,
+                                          double *out, size_t n) noexcept
+{
+    simplex2DBatch<Avx512Double>(permutations, xs, ys, out, n);
+}
+
+void noisegen::simd::simplex2DBatchAvx512(const int32_t *permutations, const float *xs, const float *ys,
+                                          float *out, size_t n) noexcept
+{
+    simplex2DBatch<Avx512Float>(permutations, xs, ys, out, n);
+}
+
+void noisegen::simd::simplex3DRowAvx512(const int32_t *permutations, const double *xs, double y, double z, double *out,
+                                        size_t n) noexcept
+{
+    simplex3DRow<Avx512Double>(permutations, xs, y, z, out, n);
+}
+
+void noisegen::simd::simplex3DRowAvx512(const int32_t *permutations, const float *xs, float y, float z, float *out,
+                                        size_t n) noexcept
+{
+    simplex3DRow<Avx512Float>(permutations, xs, y, z, out, n);
+}
+
+void noisegen::simd::simplex2DRowAvx512(const int32_t *permutations, const double *xs, double y, double *out,
+                                        size_t n) noexcept
+{
+    simplex2DRow<Avx512Double>(permutations, xs, y, out, n);
+}
+
+void noisegen::simd::simplex2DRowAvx512(const int32_t *permutations, const float *xs, float y, float *out,
+                                        size_t n) noexcept
+{
+    simplex2DRow<Avx512Float>(permutations, xs, y, out, n);
+}
+
+void noisegen::simd::noise2DDerivativesRowAvx512(const int32_t *permutations, const double *xs, double y, double *out,
+                                                 double *dxs, double *dys, size_t n) noexcept
+{
+    noise2DDerivativesRow<Avx512Double>(permutations, xs, y, out, dxs, dys, n);
+}
+
+void noisegen::simd::noise2DDerivativesRowAvx512(const int32_t *permutations, const float *xs, float y, float *out,
+                                                 float *dxs, float *dys, size_t n) noexcept
+{
+    noise2DDerivativesRow<Avx512Float>(permutations, xs, y, out, dxs, dys, n);
+}
+
+void noisegen::simd::simplex2DDerivativesRowAvx512(const int32_t *permutations, const double *xs, double y, double *out,
+                                                   double *dxs, double *dys, size_t n) noexcept
+{
+    simplex2DDerivativesRow<Avx512Double>(permutations, xs, y, out, dxs, dys, n);
+}
+
+void noisegen::simd::simplex2DDerivativesRowAvx512(const int32_t *permutations, const float *xs, float y, float *out,
+                                                   float *dxs, float *dys, size_t n) noexcept
+{
+    simplex2DDerivativesRow<Avx512Float>(permutations, xs, y, out, dxs, dys, n);
+}
+
+#endif
@@ -0,0 +1,160 @@
+/*
+**   Copyright 2021 Maxime Rayé
+**
+**   Licensed under the Apache License, Version 2.0 (the "License");
+**   you may not use this file except in compliance with the License.
+**   You may obtain a copy of the License at
+**
+**       http://www.apache.org/licenses/LICENSE-2.0
+**
+**   Unless required by applicable law or agreed to in writing, software
+**   distributed under the License is distributed on an "AS IS" BASIS,
+**   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**   See the License for the specific language governing permissions and
+**   limitations under the License.
+*/
+
+#include <cstdlib>
+#include <cstring>
+
+#if NOISEGEN_SIMD_X86 && defined(_MSC_VER)
+    #include <intrin.h>
+#endif
+
+#include "Kernels.hpp"
+
+namespace {
+namespace simd = noisegen::simd;
+using noisegen::simd::InstructionSet;
+
+InstructionSet detectInstructionSet() noexcept
+{
+#if NOISEGEN_SIMD_X86 && (defined(__GNUC__) || defined(__clang__))
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+        return InstructionSet::Avx512;
+    if (__builtin_cpu_supports("avx2"))
+        return InstructionSet::Avx2;
+    return InstructionSet::Scalar;
+#elif NOISEGEN_SIMD_X86 && defined(_MSC_VER)
+    int info[4]{};
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return InstructionSet::Scalar;
+
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    if (!osxsave)
+        return InstructionSet::Scalar;
+
+    // The OS must save the YMM (and ZMM) registers on context switches
+    const auto xcr0 = _xgetbv(0);
+    __cpuidex(info, 7, 0);
+    if ((xcr0 & 0xE6) == 0xE6 && (info[1] & (1 << 16)) != 0)
+        return InstructionSet::Avx512;
+    if ((xcr0 & 0x6) == 0x6 && (info[1] & (1 << 5)) != 0)
+        return InstructionSet::Avx2;
+    return InstructionSet::Scalar;
+#elif NOISEGEN_SIMD_NEON
+    return InstructionSet::Neon;
+#else
+    return InstructionSet::Scalar;
+#endif
+}
+
+/**
+ * NOISEGEN_SIMD can lower the detected instruction set, never raise it.
+ */
+InstructionSet applyEnvironmentOverride(InstructionSet detected) noexcept
+{
+    const char *value = std::getenv("NOISEGEN_SIMD");
+
+    if (value == nullptr)
+        return detected;
+    if (std::strcmp(value, "scalar") == 0)
+        return InstructionSet::Scalar;
+    if (std::strcmp(value, "avx2") == 0 && detected == InstructionSet::Avx512)
+        return InstructionSet::Avx2;
+    return detected;
+}
+
+noisegen::simd::BatchKernels resolveBatchKernels() noexcept
+{
+    noisegen::simd::BatchKernels kernels{};
+
+    kernels.instructionSet = applyEnvironmentOverride(detectInstructionSet());
+    kernels.perlinDouble = {&simd::noise3DBatchScalar, &simd::noise2DBatchScalar, &simd::noise3DRowScalar,
+                            &simd::noise2DRowScalar, &simd::noise2DDerivativesRowScalar};
+    kernels.perlinFloat = {&simd::noise3DBatchScalar, &simd::noise2DBatchScalar, &simd::noise3DRowScalar,
+                           &simd::noise2DRowScalar, &simd::noise2DDerivativesRowScalar};
+    kernels.simplexDouble = {&simd::simplex3DBatchScalar, &simd::simplex2DBatchScalar, &simd::simplex3DRowScalar,
+                             &simd::simplex2DRowScalar, &simd::simplex2DDerivativesRowScalar};
+    kernels.simplexFloat = {&simd::simplex3DBatchScalar, &simd::simplex2DBatchScalar, &simd::simplex3DRowScalar,
+                            &simd::simplex2DRowScalar, &simd::simplex2DDerivativesRowScalar};
+
+    switch (kernels.instructionSet)
+    {
+#if NOISEGEN_SIMD_X86
+    case InstructionSet::Avx512:
+        kernels.perlinDouble = {&simd::noise3DBatchAvx512, &simd::noise2DBatchAvx512, &simd::noise3DRowAvx512,
+                                &simd::noise2DRowAvx512, &simd::noise2DDerivativesRowAvx512};
+        kernels.perlinFloat = {&simd::noise3DBatchAvx512, &simd::noise2DBatchAvx512, &simd::noise3DRowAvx512,
+                               &simd::noise2DRowAvx512, &simd::noise2DDerivativesRowAvx512};
+        kernels.simplexDouble = {&simd::simplex3DBatchAvx512, &simd::simplex2DBatchAvx512, &simd::simplex3DRowAvx512,
+                                 &simd::simplex2DRowAvx512, &simd::simplex2DDerivativesRowAvx512};
+        kernels.simplexFloat = {&simd::simplex3DBatchAvx512, &simd::simplex2DBatchAvx512, &simd::simplex3DRowAvx512,
+                                &simd::simplex2DRowAvx512, &simd::simplex2DDerivativesRowAvx512};
+        break;
+    case InstructionSet::Avx2:
+        kernels.perlinDouble = {&simd::noise3DBatchAvx2, &simd::noise2DBatchAvx2, &simd::noise3DRowAvx2,
+                                &simd::noise2DRowAvx2, &simd::noise2DDerivativesRowAvx2};
+        kernels.perlinFloat = {&simd::noise3DBatchAvx2, &simd::noise2DBatchAvx2, &simd::noise3DRowAvx2,
+                               &simd::noise2DRowAvx2, &simd::noise2DDerivativesRowAvx2};
+        kernels.simplexDouble = {&simd::simplex3DBatchAvx2, &simd::simplex2DBatchAvx2, &simd::simplex3DRowAvx2,
+                                 &simd::simplex2DRowAvx2, &simd::simplex2DDerivativesRowAvx2};
+        kernels.simplexFloat = {&simd::simplex3DBatchAvx2, &simd::simplex2DBatchAvx2, &simd::simplex3DRowAvx2,
+                                &simd::simplex2DRowAvx2, &simd::simplex2DDerivativesRowAvx2};
+        break;
+#endif
+#if NOISEGEN_SIMD_NEON
+    case InstructionSet::Neon:
+        kernels.perlinDouble = {&simd::noise3DBatchNeon, &simd::noise2DBatchNeon, &simd::noise3DRowNeon,
+                                &simd::noise2DRowNeon, &simd::noise2DDerivativesRowNeon};
+        kernels.perlinFloat = {&simd::noise3DBatchNeon, &simd::noise2DBatchNeon, &simd::noise3DRowNeon,
+                               &simd::noise2DRowNeon, &simd::noise2DDerivativesRowNeon};
+        kernels.simplexDouble = {&simd::simplex3DBatchNeon, &simd::simplex2DBatchNeon, &simd::simplex3DRowNeon,
+                                 &simd::simplex2DRowNeon, &simd::simplex2DDerivativesRowNeon};
+        kernels.simplexFloat = {&simd::simplex3DBatchNeon, &simd::simplex2DBatchNeon, &simd::simplex3DRowNeon,
+                                &simd::simplex2DRowNeon, &simd::simplex2DDerivativesRowNeon};
+        break;
+#endif
+    default: break;
+    }
+
+    return kernels;
+}
+}  // namespace
+
+const noisegen::simd::BatchKernels &noisegen::simd::batchKernels() noexcept
+{
+    static const BatchKernels s_kernels = resolveBatchKernels();
+
+    return s_kernels;
+}
+
+noisegen::simd::InstructionSet noisegen::simd::activeInstructionSet() noexcept
+{
+    return batchKernels().instructionSet;
+}
+
+const char *noisegen::simd::toString(InstructionSet instructionSet) noexcept
+{
+    switch (instructionSet)
+    {
+    case InstructionSet::Scalar: return "scalar";
+    case InstructionSet::Neon: return "neon";
+    case InstructionSet::Avx2: return "avx2";
+    case InstructionSet::Avx512: return "avx512";
+    }
+    return "unknown";
+}
@@ -0,0 +1,221 @@
+/*
+**   Copyright 2021 Maxime Rayé
+**
+**   Licensed under the Apache License, Version 2.0 (the "License");
+**   you may not use this file except in compliance with the License.
+**   You may obtain a copy of the License at
+**
+**       http://www.apache.org/licenses/LICENSE-2.0
+**
+**   Unless required by applicable law or agreed to in writing, software
+**   distributed under the License is distributed on an "AS IS" BASIS,
+**   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**   See the License for the specific language governing permissions and
+**   limitations under the License.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "Simd.hpp"
+#include "Settings.hpp"
+
+namespace noisegen::simd {
+template<typename Real>
+using Noise3DBatchFunction = void (*)(const int32_t *permutations, const Real *xs, const Real *ys, const Real *zs,
+                                      Real *out, size_t n) noexcept;
+template<typename Real>
+using Noise2DBatchFunction = void (*)(const int32_t *permutations, const Real *xs, const Real *ys, Real *out,
+                                      size_t n) noexcept;
+template<typename Real>
+using Noise3DRowFunction = void (*)(const int32_t *permutations, const Real *xs, Real y, Real z, Real *out,
+                                    size_t n) noexcept;
+template<typename Real>
+using Noise2DRowFunction = void (*)(const int32_t *permutations, const Real *xs, Real y, Real *out, size_t n) noexcept;
+template<typename Real>
+using Noise2DDerivativesRowFunction = void (*)(const int32_t *permutations, const Real *xs, Real y, Real *out,
+                                               Real *dxs, Real *dys, size_t n) noexcept;
+
+/**
+ * Kernels of one basis function, for one precision
+ */
+template<typename Real>
+struct BasisKernels
+{
+    Noise3DBatchFunction<Real> noise3D{};
+    Noise2DBatchFunction<Real> noise2D{};
+    Noise3DRowFunction<Real> noise3DRow{};
+    Noise2DRowFunction<Real> noise2DRow{};
+    Noise2DDerivativesRowFunction<Real> noise2DDerivativesRow{};
+};
+
+struct BatchKernels
+{
+    InstructionSet instructionSet{InstructionSet::Scalar};
+    BasisKernels<double> perlinDouble{};
+    BasisKernels<float> perlinFloat{};
+    BasisKernels<double> simplexDouble{};
+    BasisKernels<float> simplexFloat{};
+};
+
+/**
+ * Kernels for the best instruction set supported by the running CPU, resolved once.
+ */
+[[nodiscard]] const BatchKernels &batchKernels() noexcept;
+
+template<typename Real>
+[[nodiscard]] inline const BasisKernels<Real> &basisKernels(Basis basis) noexcept
+{
+    const auto &kernels = batchKernels();
+
+    if constexpr (std::is_same_v<Real, float>)
+        return basis == Basis::Simplex ? kernels.simplexFloat : kernels.perlinFloat;
+    else
+        return basis == Basis::Simplex ? kernels.simplexDouble : kernels.perlinDouble;
+}
+
+void noise3DBatchScalar(const int32_t *permutations, const double *xs, const double *ys, const double *zs,
+                        double *out, size_t n) noexcept;
+void noise3DBatchScalar(const int32_t *permutations, const float *xs, const float *ys, const float *zs, float *out,
+                        size_t n) noexcept;
+void noise2DBatchScalar(const int32_t *permutations, const double *xs, const double *ys, double *out,
+                        size_t n) noexcept;
+void noise2DBatchScalar(const int32_t *permutations, const float *xs, const float *ys, float *out, size_t n) noexcept;
+void noise3DRowScalar(const int32_t *permutations, const double *xs, double y, double z, double *out,
+                      size_t n) noexcept;
+void noise3DRowScalar(const int32_t *permutations, const float *xs, float y, float z, float *out, size_t n) noexcept;
+void noise2DRowScalar(const int32_t *permutations, const double *xs, double y, double *out, size_t n) noexcept;
+void noise2DRowScalar(const int32_t *permutations, const float *xs, float y, float *out, size_t n) noexcept;
+
+void simplex3DBatchScalar(const int32_t *permutations, const double *xs, const double *ys, const double *zs,
+                          double *out, size_t n) noexcept;
+void simplex3DBatchScalar(const int32_t *permutations, const float *xs, const float *ys, const float *zs,
+                          float *out, size_t n) noexcept;
+void simplex2DBatchScalar(const int32_t *permutations, const double *xs, const double *ys, double *out,
+                          size_t n) noexcept;
+void simplex2DBatchScalar(const int32_t *permutations, const float *xs, const float *ys, float *out,
+                          size_t n) noexcept;
+void simplex3DRowScalar(const int32_t *permutations, const double *xs, double y, double z, double *out,
+                        size_t n) noexcept;
+void simplex3DRowScalar(const int32_t *permutations, const float *xs, float y, float z, float *out, size_t n) noexcept;
+void simplex2DRowScalar(const int32_t *permutations, const double *xs, double y, double *out, size_t n) noexcept;
+void simplex2DRowScalar(const int32_t *permutations, const float *xs, float y, float *out, size_t n) noexcept;
+void noise2DDerivativesRowScalar(const int32_t *permutations, const double *xs, double y, double *out, double *dxs,
+                                 double *dys, size_t n) noexcept;
+void noise2DDerivativesRowScalar(const int32_t *permutations, const float *xs, float y, float *out, float *dxs,
+                                 float *dys, size_t n) noexcept;
+void simplex2DDerivativesRowScalar(const int32_t *permutations, const double *xs, double y, double *out, double *dxs,
+                                   double *dys, size_t n) noexcept;
+void simplex2DDerivativesRowScalar(const int32_t *permutations, const float *xs, float y, float *out, float *dxs,
+                                   float *dys, size_t n) noexcept;
+
+#if NOISEGEN_SIMD_X86
+void noise3DBatchAvx2(const int32_t *permutations, const double *xs, const double *ys, const double *zs, double *out,
+                      size_t n) noexcept;
+void noise3DBatchAvx2(const int32_t *permutations, const float *xs, const float *ys, const float *zs, float *out,
+                      size_t n) noexcept;
+void noise2DBatchAvx2(const int32_t *permutations, const double *xs, const double *ys, double *out,
+                      size_t n) noexcept;
+void noise2DBatchAvx2(const int32_t *permutations, const float *xs, const float *ys, float *out, size_t n) noexcept;
+void noise3DRowAvx2(const int32_t *permutations, const double *xs, double y, double z, double *out, size_t n) noexcept;
+void noise3DRowAvx2(const int32_t *permutations, const float *xs, float y, float z, float *out, size_t n) noexcept;
+void noise2DRowAvx2(const int32_t *permutations, const double *xs, double y, double *out, size_t n) noexcept;
+void noise2DRowAvx2(const int32_t *permutations, const float *xs, float y, float *out, size_t n) noexcept;
+
+void simplex3DBatchAvx2(const int32_t *permutations, const double *xs, const double *ys, const double *zs,
+                        double *out, size_t n) noexcept;
+void simplex3DBatchAvx2(const int32_t *permutations, const float *xs, const float *ys, const float *zs,
+                        float *out, size_t n) noexcept;
+void simplex2DBatchAvx2(const int32_t *permutations, const double *xs, const double *ys, double *out,
+                        size_t n) noexcept;
+void simplex2DBatchAvx2(const int32_t *permutations, const float *xs, const float *ys, float *out,
+                        size_t n) noexcept;
+void simplex3DRowAvx2(const int32_t *permutations, const double *xs, double y, double z, double *out,
+                      size_t n) noexcept;
+void simplex3DRowAvx2(const int32_t *permutations, const float *xs, float y, float z, float *out, size_t n) noexcept;
+void simplex2DRowAvx2(const int32_t *permutations, const double *xs, double y, double *out, size_t n) noexcept;
+void simplex2DRowAvx2(const int32_t *permutations, const float *xs, float y, float *out, size_t n) noexcept;
+void noise2DDerivativesRowAvx2(const int32_t *permutations, const double *xs, double y, double *out, double *dxs,
+                               double *dys, size_t n) noexcept;
+void noise2DDerivativesRowAvx2(const int32_t *permutations, const float *xs, float y, float *out, float *dxs,
+                               float *dys, size_t n) noexcept;
+void simplex2DDerivativesRowAvx2(const int32_t *permutations, const double *xs, double y, double *out, double *dxs,
+                                 double *dys, size_t n) noexcept;
+void simplex2DDerivativesRowAvx2(const int32_t *permutations, const float *xs, float y, float *out, float *dxs,
+                                 float *dys, size_t n) noexcept;
+
+void noise3DBatchAvx512(const int32_t *permutations, const double *xs, const double *ys, const double *zs,
+                        double *out, size_t n) noexcept;
+void noise3DBatchAvx512(const int32_t *permutations, const float *xs, const float *ys, const float *zs, float *out,
+                        size_t n) noexcept;
+void noise2DBatchAvx512(const int32_t *permutations, const double *xs, const double *ys, double *out,
+                        size_t n) noexcept;
+void noise2DBatchAvx512(const int32_t *permutations, const float *xs, const float *ys, float *out, size_t n) noexcept;
+void noise3DRowAvx512(const int32_t *permutations, const double *xs, double y, double z, double *out,
+                      size_t n) noexcept;
+void noise3DRowAvx512(const int32_t *permutations, const float *xs, float y, float z, float *out, size_t n) noexcept;
+void noise2DRowAvx512(const int32_t *permutations, const double *xs, double y, double *out, size_t n) noexcept;
+void noise2DRowAvx512(const int32_t *permutations, const float *xs, float y, float *out, size_t n) noexcept;
+
+void simplex3DBatchAvx512(const int32_t *permutations, const double *xs, const double *ys, const double *zs,
+                          double *out, size_t n) noexcept;
+void simplex3DBatchAvx512(const int32_t *permutations, const float *xs, const float *ys, const float *zs,
+                          float *out, size_t n) noexcept;
+void simplex2DBatchAvx512(const int32_t *permutations, const double *xs, const double *ys, double *out,
+                          size_t n) noexcept;
+void simplex2DBatchAvx512(const int32_t *permutations, const float *xs, const float *ys, float *out,
+                          size_t n) noexcept;
+void simplex3DRowAvx512(const int32_t *permutations, const double *xs, double y, double z, double *out,
+                        size_t n) noexcept;
+void simplex3DRowAvx512(const int32_t *permutations, const float *xs, float y, float z, float *out, size_t n) noexcept;
+void simplex2DRowAvx512(const int32_t *permutations, const double *xs, double y, double *out, size_t n) noexcept;
+void simplex2DRowAvx512(const int32_t *permutations, const float *xs, float y, float *out, size_t n) noexcept;
+void noise2DDerivativesRowAvx512(const int32_t *permutations, const double *xs, double y, double *out, double *dxs,
+                                 double *dys, size_t n) noexcept;
+void noise2DDerivativesRowAvx512(const int32_t *permutations, const float *xs, float y, float *out, float *dxs,
+                                 float *dys, size_t n) noexcept;
+void simplex2DDerivativesRowAvx512(const int32_t *permutations, const double *xs, double y, double *out, double *dxs,
+                                   double *dys, size_t n) noexcept;
+void simplex2DDerivativesRowAvx512(const int32_t *permutations, const float *xs, float y, float *out, float *dxs,
+                                   float *dys, size_t n) noexcept;
+#endif
+
+#if NOISEGEN_SIMD_NEON
+void noise3DBatchNeon(const int32_t *permutations, const double *xs, const double *ys, const double *zs, double *out,
+                      size_t n) noexcept;
+void noise3DBatchNeon(const int32_t *permutations, const float *xs, const float *ys, const float *zs, float *out,
+                      size_t n) noexcept;
+void noise2DBatchNeon(const int32_t *permutations, const double *xs, const double *ys, double *out,
+                      size_t n) noexcept;
+void noise2DBatchNeon(const int32_t *permutations, const float *xs, const float *ys, float *out, size_t n) noexcept;
+void noise3DRowNeon(const int32_t *permutations, const double *xs, double y, double z, double *out, size_t n) noexcept;
+void noise3DRowNeon(const int32_t *permutations, const float *xs, float y, float z, float *out, size_t n) noexcept;
+void noise2DRowNeon(const int32_t *permutations, const double *xs, double y, double *out, size_t n) noexcept;
+void noise2DRowNeon(const int32_t *permutations, const float *xs, float y, float *out, size_t n) noexcept;
+
+void simplex3DBatchNeon(const int32_t *permutations, const double *xs, const double *ys, const double *zs,
+                        double *out, size_t n) noexcept;
+void simplex3DBatchNeon(const int32_t *permutations, const float *xs, const float *ys, const float *zs,
+                        float *out, size_t n) noexcept;
+void simplex2DBatchNeon(const int32_t *permutations, const double *xs, const double *ys, double *out,
+                        size_t n) noexcept;
+void simplex2DBatchNeon(const int32_t *permutations, const float *xs, const float *ys, float *out,
+                        size_t n) noexcept;
+void simplex3DRowNeon(const int32_t *permutations, const double *xs, double y, double z, double *out,
+                      size_t n) noexcept;
+void simplex3DRowNeon(const int32_t *permutations, const float *xs, float y, float z, float *out, size_t n) noexcept;
+void simplex2DRowNeon(const int32_t *permutations, const double *xs, double y, double *out, size_t n) noexcept;
+void simplex2DRowNeon(const int32_t *permutations, const float *xs, float y, float *out, size_t n) noexcept;
+void noise2DDerivativesRowNeon(const int32_t *permutations, const double *xs, double y, double *out, double *dxs,
+                               double *dys, size_t n) noexcept;
+void noise2DDerivativesRowNeon(const int32_t *permutations, const float *xs, float y, float *out, float *dxs,
+                               float *dys, size_t n) noexcept;
+void simplex2DDerivativesRowNeon(const int32_t *permutations, const double *xs, double y, double *out, double *dxs,
+                                 double *dys, size_t n) noexcept;
+void simplex2DDerivativesRowNeon(const int32_t *permutations, const float *xs, float y, float *out, float *dxs,
+                                 float *dys, size_t n) noexcept;
+#endif
+}  // namespace noisegen::simd
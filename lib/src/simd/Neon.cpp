@@ -0,0 +1,252 @@
+/*
+**   Copyright 2021 Maxime Rayé
+**
+**   Licensed under the Apache License, Version 2.0 (the "License");
+**   you may not use this file except in compliance with the License.
+**   You may obtain a copy of the License at
+**
+**       http://www.apache.org/licenses/LICENSE-2.0
+**
+**   Unless required by applicable law or agreed to in writing, software
+**   distributed under the License is distributed on an "AS IS" BASIS,
+**   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**   See the License for the specific language governing permissions and
+**   limitations under the License.
+*/
+
+/*
+ * NEON is part of the AArch64 baseline, no runtime check needed.
+ * There is no gather instruction, so lookups are done lane by lane and only the arithmetic is vectorized.
+ */
+
+#if NOISEGEN_SIMD_NEON
+
+    #include <arm_neon.h>
+
+    #include "Kernels.hpp"
+    #include "PerlinKernel.hpp"
+    #include "SimplexKernel.hpp"
+
+namespace {
+struct NeonDouble
+{
+    using Real = double;
+    using Vec = float64x2_t;
+    using Index = int64x2_t;
+    static constexpr size_t Width = 2;
+
+    static inline Vec load(const Real *p) noexcept { return vld1q_f64(p); }
+    static inline void store(Real *p, Vec v) noexcept { vst1q_f64(p, v); }
+    static inline Vec set1(int value) noexcept { return vdupq_n_f64(value); }
+    static inline Vec broadcast(Real value) noexcept { return vdupq_n_f64(value); }
+    static inline Vec add(Vec a, Vec b) noexcept { return vaddq_f64(a, b); }
+    static inline Vec sub(Vec a, Vec b) noexcept { return vsubq_f64(a, b); }
+    static inline Vec mul(Vec a, Vec b) noexcept { return vmulq_f64(a, b); }
+    static inline Vec floor(Vec v) noexcept { return vrndmq_f64(v); }
+    static inline Vec max(Vec a, Vec b) noexcept { return vmaxq_f64(a, b); }
+    static inline Vec greaterEqual(Vec a, Vec b) noexcept
+    {
+        return vreinterpretq_f64_u64(vandq_u64(vcgeq_f64(a, b), vreinterpretq_u64_f64(vdupq_n_f64(1.0))));
+    }
+
+    static inline Index toIndex(Vec floored) noexcept { return vandq_s64(vcvtq_s64_f64(floored), vdupq_n_s64(255)); }
+    static inline Index addIndex(Index a, Index b) noexcept { return vaddq_s64(a, b); }
+    static inline Index increment(Index a) noexcept { return vaddq_s64(a, vdupq_n_s64(1)); }
+    static inline Index gather(const int32_t *table, Index index) noexcept
+    {
+        const int64_t values[Width] = {table[vgetq_lane_s64(index, 0)], table[vgetq_lane_s64(index, 1)]};
+        return vld1q_s64(values);
+    }
+
+    static inline Vec grad(Index hash, Vec x, Vec y, Vec z) noexcept
+    {
+        const int64x2_t h = vandq_s64(hash, vdupq_n_s64(15));
+
+        const uint64x2_t hLess8 = vcltq_s64(h, vdupq_n_s64(8));
+        const uint64x2_t hLess4 = vcltq_s64(h, vdupq_n_s64(4));
+        const uint64x2_t h12or14 = vorrq_u64(vceqq_s64(h, vdupq_n_s64(12)), vceqq_s64(h, vdupq_n_s64(14)));
+
+        const Vec u = vbslq_f64(hLess8, x, y);
+        const Vec v = vbslq_f64(hLess4, y, vbslq_f64(h12or14, x, z));
+
+        // (h & 1) and (h & 2) moved to the sign bit, to negate u and v without branching
+        const uint64x2_t signU = vreinterpretq_u64_s64(vshlq_n_s64(vandq_s64(h, vdupq_n_s64(1)), 63));
+        const uint64x2_t signV = vreinterpretq_u64_s64(vshlq_n_s64(vandq_s64(h, vdupq_n_s64(2)), 62));
+
+        return vaddq_f64(vreinterpretq_f64_u64(veorq_u64(vreinterpretq_u64_f64(u), signU)),
+                         vreinterpretq_f64_u64(veorq_u64(vreinterpretq_u64_f64(v), signV)));
+    }
+};
+
+struct NeonFloat
+{
+    using Real = float;
+    using Vec = float32x4_t;
+    using Index = int32x4_t;
+    static constexpr size_t Width = 4;
+
+    static inline Vec load(const Real *p) noexcept { return vld1q_f32(p); }
+    static inline void store(Real *p, Vec v) noexcept { vst1q_f32(p, v); }
+    static inline Vec set1(int value) noexcept { return vdupq_n_f32(static_cast<float>(value)); }
+    static inline Vec broadcast(Real value) noexcept { return vdupq_n_f32(value); }
+    static inline Vec add(Vec a, Vec b) noexcept { return vaddq_f32(a, b); }
+    static inline Vec sub(Vec a, Vec b) noexcept { return vsubq_f32(a, b); }
+    static inline Vec mul(Vec a, Vec b) noexcept { return vmulq_f32(a, b); }
+    static inline Vec floor(Vec v) noexcept { return vrndmq_f32(v); }
+    static inline Vec max(Vec a, Vec b) noexcept { return vmaxq_f32(a, b); }
+    static inline Vec greaterEqual(Vec a, Vec b) noexcept
+    {
+        return vreinterpretq_f32_u32(vandq_u32(vcgeq_f32(a, b), vreinterpretq_u32_f32(vdupq_n_f32(1.0F))));
+    }
+
+    static inline Index toIndex(Vec floored) noexcept { return vandq_s32(vcvtq_s32_f32(floored), vdupq_n_s32(255)); }
+    static inline Index addIndex(Index a, Index b) noexcept { return vaddq_s32(a, b); }
+    static inline Index increment(Index a) noexcept { return vaddq_s32(a, vdupq_n_s32(1)); }
+    static inline Index gather(const int32_t *table, Index index) noexcept
+    {
+        const int32_t values[Width] = {table[vgetq_lane_s32(index, 0)], table[vgetq_lane_s32(index, 1)],
+                                       table[vgetq_lane_s32(index, 2)], table[vgetq_lane_s32(index, 3)]};
+        return vld1q_s32(values);
+    }
+
+    static inline Vec grad(Index hash, Vec x, Vec y, Vec z) noexcept
+    {
+        const int32x4_t h = vandq_s32(hash, vdupq_n_s32(15));
+
+        const uint32x4_t hLess8 = vcltq_s32(h, vdupq_n_s32(8));
+        const uint32x4_t hLess4 = vcltq_s32(h, vdupq_n_s32(4));
+        const uint32x4_t h12or14 = vorrq_u32(vceqq_s32(h, vdupq_n_s32(12)), vceqq_s32(h, vdupq_n_s32(14)));
+
+        const Vec u = vbslq_f32(hLess8, x, y);
+        const Vec v = vbslq_f32(hLess4, y, vbslq_f32(h12or14, x, z));
+
+        const uint32x4_t signU = vreinterpretq_u32_s32(vshlq_n_s32(vandq_s32(h, vdupq_n_s32(1)), 31));
+        const uint32x4_t signV = vreinterpretq_u32_s32(vshlq_n_s32(vandq_s32(h, vdupq_n_s32(2)), 30));
+
+        return vaddq_f32(vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(u), signU)),
+                         vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(v), signV)));
+    }
+};
+}  // namespace
+
+void noisegen::simd::noise3DBatchNeon(const int32_t *permutations, const double *xs, const double *ys,
+                                      const double *zs, double *out, size_t n) noexcept
+{
+    noise3DBatch<NeonDouble>(permutations, xs, ys, zs, out, n);
+}
+
+void noisegen::simd::noise3DBatchNeon(const int32_t *permutations, const float *xs, const float *ys, const float *zs,
+                                      float *out, size_t n) noexcept
+{
+    noise3DBatch<NeonFloat>(permutations, xs, ys, zs, out, n);
+}
+
+void noisegen::simd::noise2DBatchNeon(const int32_t *permutations, const double *xs, const double *ys, double *out,
+                                      size_t n) noexcept
+{
+    noise2DBatch<NeonDouble>(permutations, xs, ys, out, n);
+}
+
+void noisegen::simd::noise2DBatchNeon(const int32_t *permutations, const float *xs, const float *ys, float *out,
+                                      size_t n) noexcept
+{
+    noise2DBatch<NeonFloat>(permutations, xs, ys, out, n);
+}
+
+void noisegen::simd::noise3DRowNeon(const int32_t *permutations, const double *xs, double y, double z, double *out,
+                                    size_t n) noexcept
+{
+    noise3DRow<NeonDouble>(permutations, xs, y, z, out, n);
+}
+
+void noisegen::simd::noise3DRowNeon(const int32_t *permutations, const float *xs, float y, float z, float *out,
+                                    size_t n) noexcept
+{
+    noise3DRow<NeonFloat>(permutations, xs, y, z, out, n);
+}
+
+void noisegen::simd::noise2DRowNeon(const int32_t *permutations, const double *xs, double y, double *out,
+                                    size_t n) noexcept
+{
+    noise2DRow<NeonDouble>(permutations, xs, y, out, n);
+}
+
+void noisegen::simd::noise2DRowNeon(const int32_t *permutations, const float *xs, float y, float *out,
+                                    size_t n) noexcept
+{
+    noise2DRow<NeonFloat>(permutations, xs, y, out, n);
+}
+
+void noisegen::simd::simplex3DBatchNeon(const int32_t *permutations, const double *xs, const double *ys,
+                                        const double *zs, double *out, size_t n) noexcept
+{
+    simplex3DBatch<NeonDouble>(permutations, xs, ys, zs, out, n);
+}
+
+void noisegen::simd::simplex3DBatchNeon(const int32_t *permutations, const float *xs, const float *ys,
+                                        const float *zs, float *out, size_t n) noexcept
+{
+    simplex3DBatch<NeonFloat>(permutations, xs, ys, zs, out, n);
+}
+
+void noisegen::simd::simplex2DBatchNeon(const int32_t *permutations, const double *xs, const double *ys,
+                                        double *out, size_t n) noexcept
+{
+    simplex2DBatch<NeonDouble>(permutations, xs, ys, out, n);
+}
+
+void noisegen::simd::simplex2DBatchNeon(const int32_t *permutations, const float *xs, const float *ys,
+                                        float *out, size_t n) noexcept
+{
+    simplex2DBatch<NeonFloat>(permutations, xs, ys, out, n);
+}
+
+void noisegen::simd::simplex3DRowNeon(const int32_t *permutations, const double *xs, double y, double z, double *out,
+                                      size_t n) noexcept
+{
+    simplex3DRow<NeonDouble>(permutations, xs, y, z, out, n);
+}
+
+void noisegen::simd::simplex3DRowNeon(const int32_t *permutations, const float *xs, float y, float z, float *out,
+                                      size_t n) noexcept
+{
+    simplex3DRow<NeonFloat>(permutations, xs, y, z, out, n);
+}
+
+void noisegen::simd::simplex2DRowNeon(const int32_t *permutations, const double *xs, double y, double *out,
+                                      size_t n) noexcept
+{
+    simplex2DRow<NeonDouble>(permutations, xs, y, out, n);
+}
+
+void noisegen::simd::simplex2DRowNeon(const int32_t *permutations, const float *xs, float y, float *out,
+                                      size_t n) noexcept
+{
+    simplex2DRow<NeonFloat>(permutations, xs, y, out, n);
+}
+
+void noisegen::simd::noise2DDerivativesRowNeon(const int32_t *permutations, const double *xs, double y, double *out,
+                                               double *dxs, double *dys, size_t n) noexcept
+{
+    noise2DDerivativesRow<NeonDouble>(permutations, xs, y, out, dxs, dys, n);
+}
+
+void noisegen::simd::noise2DDerivativesRowNeon(const int32_t *permutations, const float *xs, float y, float *out,
+                                               float *dxs, float *dys, size_t n) noexcept
+{
+    noise2DDerivativesRow<NeonFloat>(permutations, xs, y, out, dxs, dys, n);
+}
+
+void noisegen::simd::simplex2DDerivativesRowNeon(const int32_t *permutations, const double *xs, double y, double *out,
+                                                 double *dxs, double *dys, size_t n) noexcept
+{
+    simplex2DDerivativesRow<NeonDouble>(permutations, xs, y, out, dxs, dys, n);
+}
+
+void noisegen::simd::simplex2DDerivativesRowNeon(const int32_t *permutations, const float *xs, float y, float *out,
+                                                 float *dxs, float *dys, size_t n) noexcept
+{
+    simplex2DDerivativesRow<NeonFloat>(permutations, xs, y, out, dxs, dys, n);
+}
+
+#endif
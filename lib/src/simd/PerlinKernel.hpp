@@ -0,0 +1,686 @@
+/*
+**   Copyright 2021 Maxime Rayé
+**
+**   Licensed under the Apache License, Version 2.0 (the "License");
+**   you may not use this file except in compliance with the License.
+**   You may obtain a copy of the License at
+**
+**       http://www.apache.org/licenses/LICENSE-2.0
+**
+**   Unless required by applicable law or agreed to in writing, software
+**   distributed under the License is distributed on an "AS IS" BASIS,
+**   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**   See the License for the specific language governing permissions and
+**   limitations under the License.
+*/
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+/*
+ * Vectorized version of Generator::noise3D(), written once against a small set of primitives.
+ * Every instruction set provides a traits struct (see Avx2.cpp, Avx512.cpp, Neon.cpp, Scalar.cpp) with:
+ *   Real, Vec, Index, Width
+ *   load, store, set1, broadcast, add, sub, mul, floor
+ *   toIndex (floored Vec -> lattice index & 255), addIndex, increment, gather, grad
+ *
+ * Operations are done in the same order as the scalar implementation (and without FMA),
+ * so every instruction set returns bit-identical results for double precision.
+ *
+ * This header must only be included from a single kernel translation unit per instruction set,
+ * and the traits structs must live in an anonymous namespace, so that no inline function compiled
+ * with extended instruction sets can leak into the rest of the library.
+ */
+
+namespace noisegen::simd {
+template<typename Isa>
+inline typename Isa::Vec fade(typename Isa::Vec t) noexcept
+{
+    const auto t3 = Isa::mul(Isa::mul(t, t), t);
+    const auto inner = Isa::add(Isa::mul(t, Isa::sub(Isa::mul(t, Isa::set1(6)), Isa::set1(15))), Isa::set1(10));
+
+    return Isa::mul(t3, inner);
+}
+
+template<typename Isa>
+inline typename Isa::Vec lerp(typename Isa::Vec t, typename Isa::Vec a, typename Isa::Vec b) noexcept
+{
+    return Isa::add(a, Isa::mul(t, Isa::sub(b, a)));
+}
+
+/**
+ * Derivative of fade(): 30 t^2 (t - 1)^2
+ */
+template<typename Isa>
+inline typename Isa::Vec fadeDerivative(typename Isa::Vec t) noexcept
+{
+    const auto tt1 = Isa::mul(t, Isa::sub(t, Isa::set1(1)));
+
+    return Isa::mul(Isa::mul(tt1, tt1), Isa::set1(30));
+}
+
+/**
+ * Evaluate Isa::Width samples.
+ * @param permutations doubled permutation table (2 * Generator::PermutationArraySize entries), so no modulo is needed
+ */
+template<typename Isa>
+inline typename Isa::Vec perlin3D(const int32_t *permutations, typename Isa::Vec x, typename Isa::Vec y,
+                                  typename Isa::Vec z) noexcept
+{
+    const auto floorX = Isa::floor(x);
+    const auto floorY = Isa::floor(y);
+    const auto floorZ = Isa::floor(z);
+
+    const auto X = Isa::toIndex(floorX);
+    const auto Y = Isa::toIndex(floorY);
+    const auto Z = Isa::toIndex(floorZ);
+
+    x = Isa::sub(x, floorX);
+    y = Isa::sub(y, floorY);
+    z = Isa::sub(z, floorZ);
+
+    const auto u = fade<Isa>(x);
+    const auto v = fade<Isa>(y);
+    const auto w = fade<Isa>(z);
+
+    const auto A = Isa::addIndex(Isa::gather(permutations, X), Y);
+    const auto AA = Isa::addIndex(Isa::gather(permutations, A), Z);
+    const auto AB = Isa::addIndex(Isa::gather(permutations, Isa::increment(A)), Z);
+    const auto B = Isa::addIndex(Isa::gather(permutations, Isa::increment(X)), Y);
+    const auto BA = Isa::addIndex(Isa::gather(permutations, B), Z);
+    const auto BB = Isa::addIndex(Isa::gather(permutations, Isa::increment(B)), Z);
+
+    const auto one = Isa::set1(1);
+    const auto x1 = Isa::sub(x, one);
+    const auto y1 = Isa::sub(y, one);
+    const auto z1 = Isa::sub(z, one);
+
+    const auto gAA = Isa::grad(Isa::gather(permutations, AA), x, y, z);
+    const auto gBA = Isa::grad(Isa::gather(permutations, BA), x1, y, z);
+    const auto gAB = Isa::grad(Isa::gather(permutations, AB), x, y1, z);
+    const auto gBB = Isa::grad(Isa::gather(permutations, BB), x1, y1, z);
+    const auto gAA1 = Isa::grad(Isa::gather(permutations, Isa::increment(AA)), x, y, z1);
+    const auto gBA1 = Isa::grad(Isa::gather(permutations, Isa::increment(BA)), x1, y, z1);
+    const auto gAB1 = Isa::grad(Isa::gather(permutations, Isa::increment(AB)), x, y1, z1);
+    const auto gBB1 = Isa::grad(Isa::gather(permutations, Isa::increment(BB)), x1, y1, z1);
+
+    return lerp<Isa>(w, lerp<Isa>(v, lerp<Isa>(u, gAA, gBA), lerp<Isa>(u, gAB, gBB)),
+                     lerp<Isa>(v, lerp<Isa>(u, gAA1, gBA1), lerp<Isa>(u, gAB1, gBB1)));
+}
+
+/**
+ * perlin3D() restricted to the z = 0 plane: only the 4 corners of that face are evaluated.
+ */
+template<typename Isa>
+inline typename Isa::Vec perlin2D(const int32_t *permutations, typename Isa::Vec x, typename Isa::Vec y) noexcept
+{
+    const auto floorX = Isa::floor(x);
+    const auto floorY = Isa::floor(y);
+
+    const auto X = Isa::toIndex(floorX);
+    const auto Y = Isa::toIndex(floorY);
+
+    x = Isa::sub(x, floorX);
+    y = Isa::sub(y, floorY);
+
+    const auto u = fade<Isa>(x);
+    const auto v = fade<Isa>(y);
+
+    const auto A = Isa::addIndex(Isa::gather(permutations, X), Y);
+    const auto AA = Isa::gather(permutations, A);
+    const auto AB = Isa::gather(permutations, Isa::increment(A));
+    const auto B = Isa::addIndex(Isa::gather(permutations, Isa::increment(X)), Y);
+    const auto BA = Isa::gather(permutations, B);
+    const auto BB = Isa::gather(permutations, Isa::increment(B));
+
+    const auto zero = Isa::set1(0);
+    const auto one = Isa::set1(1);
+    const auto x1 = Isa::sub(x, one);
+    const auto y1 = Isa::sub(y, one);
+
+    const auto gAA = Isa::grad(Isa::gather(permutations, AA), x, y, zero);
+    const auto gBA = Isa::grad(Isa::gather(permutations, BA), x1, y, zero);
+    const auto gAB = Isa::grad(Isa::gather(permutations, AB), x, y1, zero);
+    const auto gBB = Isa::grad(Isa::gather(permutations, BB), x1, y1, zero);
+
+    return lerp<Isa>(v, lerp<Isa>(u, gAA, gBA), lerp<Isa>(u, gAB, gBB));
+}
+
+/**
+ * perlin2D() along with its partial derivatives along x and y, stored in dx and dy.
+ * The value is computed with the exact same operations as perlin2D(), the derivatives reuse its hashes, fade()
+ * weights and interpolated gradients.
+ */
+template<typename Isa>
+inline typename Isa::Vec perlin2DDerivatives(const int32_t *permutations, typename Isa::Vec x, typename Isa::Vec y,
+                                             typename Isa::Vec &dx, typename Isa::Vec &dy) noexcept
+{
+    const auto floorX = Isa::floor(x);
+    const auto floorY = Isa::floor(y);
+
+    const auto X = Isa::toIndex(floorX);
+    const auto Y = Isa::toIndex(floorY);
+
+    x = Isa::sub(x, floorX);
+    y = Isa::sub(y, floorY);
+
+    const auto u = fade<Isa>(x);
+    const auto v = fade<Isa>(y);
+
+    const auto A = Isa::addIndex(Isa::gather(permutations, X), Y);
+    const auto AA = Isa::gather(permutations, A);
+    const auto AB = Isa::gather(permutations, Isa::increment(A));
+    const auto B = Isa::addIndex(Isa::gather(permutations, Isa::increment(X)), Y);
+    const auto BA = Isa::gather(permutations, B);
+    const auto BB = Isa::gather(permutations, Isa::increment(B));
+
+    const auto zero = Isa::set1(0);
+    const auto one = Isa::set1(1);
+    const auto x1 = Isa::sub(x, one);
+    const auto y1 = Isa::sub(y, one);
+
+    const auto hashAA = Isa::gather(permutations, AA);
+    const auto hashBA = Isa::gather(permutations, BA);
+    const auto hashAB = Isa::gather(permutations, AB);
+    const auto hashBB = Isa::gather(permutations, BB);
+
+    const auto gAA = Isa::grad(hashAA, x, y, zero);
+    const auto gBA = Isa::grad(hashBA, x1, y, zero);
+    const auto gAB = Isa::grad(hashAB, x, y1, zero);
+    const auto gBB = Isa::grad(hashBB, x1, y1, zero);
+
+    // grad() is a dot product with the corner gradient, whose components are grad() of the unit vectors
+    const auto gxAA = Isa::grad(hashAA, one, zero, zero);
+    const auto gxBA = Isa::grad(hashBA, one, zero, zero);
+    const auto gxAB = Isa::grad(hashAB, one, zero, zero);
+    const auto gxBB = Isa::grad(hashBB, one, zero, zero);
+    const auto gyAA = Isa::grad(hashAA, zero, one, zero);
+    const auto gyBA = Isa::grad(hashBA, zero, one, zero);
+    const auto gyAB = Isa::grad(hashAB, zero, one, zero);
+    const auto gyBB = Isa::grad(hashBB, zero, one, zero);
+
+    const auto bottom = lerp<Isa>(u, gAA, gBA);
+    const auto top = lerp<Isa>(u, gAB, gBB);
+
+    // d/dx lerp(v, lerp(u, a, b), lerp(u, c, d)) = lerp(v, lerp(u, a', b'), lerp(u, c', d')) + u' lerp(v, b - a, d - c)
+    const auto du = fadeDerivative<Isa>(x);
+    const auto dv = fadeDerivative<Isa>(y);
+
+    dx = Isa::add(lerp<Isa>(v, lerp<Isa>(u, gxAA, gxBA), lerp<Isa>(u, gxAB, gxBB)),
+                  Isa::mul(du, lerp<Isa>(v, Isa::sub(gBA, gAA), Isa::sub(gBB, gAB))));
+    dy = Isa::add(lerp<Isa>(v, lerp<Isa>(u, gyAA, gyBA), lerp<Isa>(u, gyAB, gyBB)),
+                  Isa::mul(dv, Isa::sub(top, bottom)));
+
+    return lerp<Isa>(v, bottom, top);
+}
+
+template<typename Isa>
+inline void noise3DBatch(const int32_t *permutations, const typename Isa::Real *xs, const typename Isa::Real *ys,
+                         const typename Isa::Real *zs, typename Isa::Real *out, size_t n) noexcept
+{
+    using Real = typename Isa::Real;
+    constexpr size_t Width = Isa::Width;
+
+    size_t i = 0;
+    for (; i + Width <= n; i += Width)
+        Isa::store(out + i, perlin3D<Isa>(permutations, Isa::load(xs + i), Isa::load(ys + i), Isa::load(zs + i)));
+
+    if (i == n)
+        return;
+
+    // Remainder: pad with zeros and run one last full-width iteration
+    Real tailX[Width]{}, tailY[Width]{}, tailZ[Width]{}, tailOut[Width]{};
+    for (size_t j = 0; i + j < n; ++j)
+    {
+        tailX[j] = xs[i + j];
+        tailY[j] = ys[i + j];
+        tailZ[j] = zs[i + j];
+    }
+
+    Isa::store(tailOut, perlin3D<Isa>(permutations, Isa::load(tailX), Isa::load(tailY), Isa::load(tailZ)));
+
+    for (size_t j = 0; i + j < n; ++j)
+        out[i + j] = tailOut[j];
+}
+
+template<typename Isa>
+inline void noise2DBatch(const int32_t *permutations, const typename Isa::Real *xs, const typename Isa::Real *ys,
+                         typename Isa::Real *out, size_t n) noexcept
+{
+    using Real = typename Isa::Real;
+    constexpr size_t Width = Isa::Width;
+
+    size_t i = 0;
+    for (; i + Width <= n; i += Width)
+        Isa::store(out + i, perlin2D<Isa>(permutations, Isa::load(xs + i), Isa::load(ys + i)));
+
+    if (i == n)
+        return;
+
+    Real tailX[Width]{}, tailY[Width]{}, tailOut[Width]{};
+    for (size_t j = 0; i + j < n; ++j)
+    {
+        tailX[j] = xs[i + j];
+        tailY[j] = ys[i + j];
+    }
+
+    Isa::store(tailOut, perlin2D<Isa>(permutations, Isa::load(tailX), Isa::load(tailY)));
+
+    for (size_t j = 0; i + j < n; ++j)
+        out[i + j] = tailOut[j];
+}
+
+/**
+ * Coefficients of grad(hash, x, y, z) == gradientX(hash) * x + gradientY(hash) * y + gradientZ(hash) * z.
+ * Every coefficient is -1, 0 or 1 and at most two of them are not 0, so both forms give the same values.
+ * They are only templated on Real, so they live in an anonymous namespace to keep each kernel's copy local.
+ */
+namespace {
+template<typename Real>
+constexpr Real gradientX(int32_t hash) noexcept
+{
+    const int32_t h = hash & 15;
+
+    if (h < 8)
+        return (h & 1) == 0 ? 1 : -1;
+    if (h == 12 || h == 14)
+        return (h & 2) == 0 ? 1 : -1;
+    return 0;
+}
+
+template<typename Real>
+constexpr Real gradientY(int32_t hash) noexcept
+{
+    const int32_t h = hash & 15;
+
+    if (h < 4)
+        return (h & 2) == 0 ? 1 : -1;
+    if (h < 8)
+        return 0;
+    return (h & 1) == 0 ? 1 : -1;
+}
+
+template<typename Real>
+constexpr Real gradientZ(int32_t hash) noexcept
+{
+    const int32_t h = hash & 15;
+
+    if (h < 4 || h == 12 || h == 14)
+        return 0;
+    return (h & 2) == 0 ? 1 : -1;
+}
+}  // namespace
+
+/**
+ * Store f(xs[i]) for i in [begin, end), one full vector at a time.
+ * The last vector may write past end (but never past n): callers go from left to right and overwrite it.
+ */
+template<typename Isa, typename F>
+inline void evaluateRun(const typename Isa::Real *xs, typename Isa::Real *out, size_t begin, size_t end, size_t n,
+                        const F &f) noexcept
+{
+    using Real = typename Isa::Real;
+    constexpr size_t Width = Isa::Width;
+
+    size_t i = begin;
+    for (; i < end && i + Width <= n; i += Width)
+        Isa::store(out + i, f(Isa::load(xs + i)));
+
+    if (i >= end)
+        return;
+
+    Real tailX[Width]{}, tailOut[Width]{};
+    for (size_t j = 0; i + j < end; ++j)
+        tailX[j] = xs[i + j];
+
+    Isa::store(tailOut, f(Isa::load(tailX)));
+
+    for (size_t j = 0; i + j < end; ++j)
+        out[i + j] = tailOut[j];
+}
+
+/**
+ * evaluateRun() for kernels returning derivatives as well: out[i] = f(xs[i], dxs[i], dys[i]), for i in [begin, end)
+ */
+template<typename Isa, typename F>
+inline void evaluateDerivativesRun(const typename Isa::Real *xs, typename Isa::Real *out, typename Isa::Real *dxs,
+                                   typename Isa::Real *dys, size_t begin, size_t end, size_t n, const F &f) noexcept
+{
+    using Real = typename Isa::Real;
+    constexpr size_t Width = Isa::Width;
+
+    typename Isa::Vec dx{}, dy{};
+
+    size_t i = begin;
+    for (; i < end && i + Width <= n; i += Width)
+    {
+        Isa::store(out + i, f(Isa::load(xs + i), dx, dy));
+        Isa::store(dxs + i, dx);
+        Isa::store(dys + i, dy);
+    }
+
+    if (i >= end)
+        return;
+
+    Real tailX[Width]{}, tailOut[Width]{}, tailDx[Width]{}, tailDy[Width]{};
+    for (size_t j = 0; i + j < end; ++j)
+        tailX[j] = xs[i + j];
+
+    Isa::store(tailOut, f(Isa::load(tailX), dx, dy));
+    Isa::store(tailDx, dx);
+    Isa::store(tailDy, dy);
+
+    for (size_t j = 0; i + j < end; ++j)
+    {
+        out[i + j] = tailOut[j];
+        dxs[i + j] = tailDx[j];
+        dys[i + j] = tailDy[j];
+    }
+}
+
+/**
+ * perlin2D() for a row of samples sharing the same y, with xs sorted in increasing order.
+ *
+ * Samples are walked lattice cell by lattice cell: the corner hashes and gradients are computed once per cell,
+ * leaving only fade() and the interpolation per sample, without any gather.
+ * Rows with only a few samples per cell (high frequencies) use the gather kernel instead.
+ */
+template<typename Isa>
+inline void noise2DRow(const int32_t *permutations, const typename Isa::Real *xs, typename Isa::Real y,
+                       typename Isa::Real *out, size_t n) noexcept
+{
+    using Real = typename Isa::Real;
+    constexpr size_t MinSamplesPerCell = Isa::Width;
+
+    if (n == 0)
+        return;
+
+    const Real cellCount = std::floor(xs[n - 1]) - std::floor(xs[0]) + 1;
+
+    if (static_cast<Real>(n) < cellCount * static_cast<Real>(MinSamplesPerCell))
+    {
+        const auto ys = Isa::broadcast(y);
+
+        evaluateRun<Isa>(xs, out, 0, n, n, [&](typename Isa::Vec x) { return perlin2D<Isa>(permutations, x, ys); });
+        return;
+    }
+
+    const Real floorY = std::floor(y);
+    const int32_t Y = static_cast<int32_t>(floorY) & 255;
+
+    y -= floorY;
+    const Real y1 = y - 1;
+
+    const auto v = fade<Isa>(Isa::broadcast(y));
+    const auto one = Isa::set1(1);
+
+    for (size_t begin = 0; begin < n;)
+    {
+        const Real floorX = std::floor(xs[begin]);
+        const int32_t X = static_cast<int32_t>(floorX) & 255;
+
+        size_t end = begin + 1;
+        while (end < n && xs[end] < floorX + 1)
+            ++end;
+
+        const int32_t A = permutations[X] + Y;
+        const int32_t B = permutations[X + 1] + Y;
+
+        const int32_t hashAA = permutations[permutations[A]];
+        const int32_t hashBA = permutations[permutations[B]];
+        const int32_t hashAB = permutations[permutations[A + 1]];
+        const int32_t hashBB = permutations[permutations[B + 1]];
+
+        const auto cellX = Isa::broadcast(floorX);
+
+        const auto gxAA = Isa::broadcast(gradientX<Real>(hashAA));
+        const auto gxBA = Isa::broadcast(gradientX<Real>(hashBA));
+        const auto gxAB = Isa::broadcast(gradientX<Real>(hashAB));
+        const auto gxBB = Isa::broadcast(gradientX<Real>(hashBB));
+
+        const auto gyAA = Isa::broadcast(gradientY<Real>(hashAA) * y);
+        const auto gyBA = Isa::broadcast(gradientY<Real>(hashBA) * y);
+        const auto gyAB = Isa::broadcast(gradientY<Real>(hashAB) * y1);
+        const auto gyBB = Isa::broadcast(gradientY<Real>(hashBB) * y1);
+
+        evaluateRun<Isa>(xs, out, begin, end, n, [&](typename Isa::Vec x) {
+            x = Isa::sub(x, cellX);
+
+            const auto u = fade<Isa>(x);
+            const auto x1 = Isa::sub(x, one);
+
+            const auto gAA = Isa::add(Isa::mul(gxAA, x), gyAA);
+            const auto gBA = Isa::add(Isa::mul(gxBA, x1), gyBA);
+            const auto gAB = Isa::add(Isa::mul(gxAB, x), gyAB);
+            const auto gBB = Isa::add(Isa::mul(gxBB, x1), gyBB);
+
+            return lerp<Isa>(v, lerp<Isa>(u, gAA, gBA), lerp<Isa>(u, gAB, gBB));
+        });
+
+        begin = end;
+    }
+}
+
+/**
+ * perlin2DDerivatives() for a row of samples sharing the same y, with xs sorted in increasing order.
+ * Same cell walk as noise2DRow(), giving the same values: the corner gradients are constant within a cell, so the
+ * derivatives only add the fade() derivatives and a few interpolations per sample.
+ */
+template<typename Isa>
+inline void noise2DDerivativesRow(const int32_t *permutations, const typename Isa::Real *xs, typename Isa::Real y,
+                                  typename Isa::Real *out, typename Isa::Real *dxs, typename Isa::Real *dys,
+                                  size_t n) noexcept
+{
+    using Real = typename Isa::Real;
+    using Vec = typename Isa::Vec;
+    constexpr size_t MinSamplesPerCell = Isa::Width;
+
+    if (n == 0)
+        return;
+
+    const Real cellCount = std::floor(xs[n - 1]) - std::floor(xs[0]) + 1;
+
+    if (static_cast<Real>(n) < cellCount * static_cast<Real>(MinSamplesPerCell))
+    {
+        const auto ys = Isa::broadcast(y);
+
+        evaluateDerivativesRun<Isa>(xs, out, dxs, dys, 0, n, n, [&](Vec x, Vec &dx, Vec &dy) {
+            return perlin2DDerivatives<Isa>(permutations, x, ys, dx, dy);
+        });
+        return;
+    }
+
+    const Real floorY = std::floor(y);
+    const int32_t Y = static_cast<int32_t>(floorY) & 255;
+
+    y -= floorY;
+    const Real y1 = y - 1;
+
+    const auto v = fade<Isa>(Isa::broadcast(y));
+    const auto dv = fadeDerivative<Isa>(Isa::broadcast(y));
+    const auto one = Isa::set1(1);
+
+    for (size_t begin = 0; begin < n;)
+    {
+        const Real floorX = std::floor(xs[begin]);
+        const int32_t X = static_cast<int32_t>(floorX) & 255;
+
+        size_t end = begin + 1;
+        while (end < n && xs[end] < floorX + 1)
+            ++end;
+
+        const int32_t A = permutations[X] + Y;
+        const int32_t B = permutations[X + 1] + Y;
+
+        const int32_t hashAA = permutations[permutations[A]];
+        const int32_t hashBA = permutations[permutations[B]];
+        const int32_t hashAB = permutations[permutations[A + 1]];
+        const int32_t hashBB = permutations[permutations[B + 1]];
+
+        const auto cellX = Isa::broadcast(floorX);
+
+        const auto gxAA = Isa::broadcast(gradientX<Real>(hashAA));
+        const auto gxBA = Isa::broadcast(gradientX<Real>(hashBA));
+        const auto gxAB = Isa::broadcast(gradientX<Real>(hashAB));
+        const auto gxBB = Isa::broadcast(gradientX<Real>(hashBB));
+
+        const auto gyAA = Isa::broadcast(gradientY<Real>(hashAA) * y);
+        const auto gyBA = Isa::broadcast(gradientY<Real>(hashBA) * y);
+        const auto gyAB = Isa::broadcast(gradientY<Real>(hashAB) * y1);
+        const auto gyBB = Isa::broadcast(gradientY<Real>(hashBB) * y1);
+
+        // Bilinear interpolations commute, and v is constant: the interpolated gradient is lerp(u, c0, c1), with
+        // c0 and c1 computed once per cell. u' multiplies lerp(v, gBA - gAA, gBB - gAB), linear in x: a x + b
+        const auto bilinear = [&v](Real aa, Real ab, Real ba, Real bb) {
+            return std::make_pair(lerp<Isa>(v, Isa::broadcast(aa), Isa::broadcast(ab)),
+                                  lerp<Isa>(v, Isa::broadcast(ba), Isa::broadcast(bb)));
+        };
+        const auto gx = bilinear(gradientX<Real>(hashAA), gradientX<Real>(hashAB), gradientX<Real>(hashBA),
+                                 gradientX<Real>(hashBB));
+        const auto gy = bilinear(gradientY<Real>(hashAA), gradientY<Real>(hashAB), gradientY<Real>(hashBA),
+                                 gradientY<Real>(hashBB));
+        const auto linear = bilinear(
+          gradientX<Real>(hashBA) - gradientX<Real>(hashAA), gradientX<Real>(hashBB) - gradientX<Real>(hashAB),
+          (gradientY<Real>(hashBA) - gradientY<Real>(hashAA)) * y - gradientX<Real>(hashBA),
+          (gradientY<Real>(hashBB) - gradientY<Real>(hashAB)) * y1 - gradientX<Real>(hashBB));
+
+        evaluateDerivativesRun<Isa>(xs, out, dxs, dys, begin, end, n, [&](Vec x, Vec &dx, Vec &dy) {
+            x = Isa::sub(x, cellX);
+
+            const auto u = fade<Isa>(x);
+            const auto x1 = Isa::sub(x, one);
+
+            const auto gAA = Isa::add(Isa::mul(gxAA, x), gyAA);
+            const auto gBA = Isa::add(Isa::mul(gxBA, x1), gyBA);
+            const auto gAB = Isa::add(Isa::mul(gxAB, x), gyAB);
+            const auto gBB = Isa::add(Isa::mul(gxBB, x1), gyBB);
+
+            const auto bottom = lerp<Isa>(u, gAA, gBA);
+            const auto top = lerp<Isa>(u, gAB, gBB);
+
+            const auto du = fadeDerivative<Isa>(x);
+
+            dx = Isa::add(lerp<Isa>(u, gx.first, gx.second),
+                          Isa::mul(du, Isa::add(Isa::mul(linear.first, x), linear.second)));
+            dy = Isa::add(lerp<Isa>(u, gy.first, gy.second), Isa::mul(dv, Isa::sub(top, bottom)));
+
+            return lerp<Isa>(v, bottom, top);
+        });
+
+        begin = end;
+    }
+}
+
+/**
+ * perlin3D() for a row of samples sharing the same y and z, with xs sorted in increasing order.
+ * Same walk as noise2DRow(): the 8 corner gradients are computed once per lattice cell, and their y and z terms
+ * are folded into one constant per corner.
+ */
+template<typename Isa>
+inline void noise3DRow(const int32_t *permutations, const typename Isa::Real *xs, typename Isa::Real y,
+                       typename Isa::Real z, typename Isa::Real *out, size_t n) noexcept
+{
+    using Real = typename Isa::Real;
+    constexpr size_t MinSamplesPerCell = Isa::Width;
+
+    if (n == 0)
+        return;
+
+    const Real cellCount = std::floor(xs[n - 1]) - std::floor(xs[0]) + 1;
+
+    if (static_cast<Real>(n) < cellCount * static_cast<Real>(MinSamplesPerCell))
+    {
+        const auto ys = Isa::broadcast(y);
+        const auto zs = Isa::broadcast(z);
+
+        evaluateRun<Isa>(xs, out, 0, n, n,
+                         [&](typename Isa::Vec x) { return perlin3D<Isa>(permutations, x, ys, zs); });
+        return;
+    }
+
+    const Real floorY = std::floor(y);
+    const Real floorZ = std::floor(z);
+    const int32_t Y = static_cast<int32_t>(floorY) & 255;
+    const int32_t Z = static_cast<int32_t>(floorZ) & 255;
+
+    y -= floorY;
+    z -= floorZ;
+    const Real y1 = y - 1;
+    const Real z1 = z - 1;
+
+    const auto v = fade<Isa>(Isa::broadcast(y));
+    const auto w = fade<Isa>(Isa::broadcast(z));
+    const auto one = Isa::set1(1);
+
+    // y and z terms of grad() for a corner, the x term is added per sample
+    const auto gradientYZ = [](int32_t hash, Real cornerY, Real cornerZ) {
+        return Isa::broadcast(gradientY<Real>(hash) * cornerY + gradientZ<Real>(hash) * cornerZ);
+    };
+
+    for (size_t begin = 0; begin < n;)
+    {
+        const Real floorX = std::floor(xs[begin]);
+        const int32_t X = static_cast<int32_t>(floorX) & 255;
+
+        size_t end = begin + 1;
+        while (end < n && xs[end] < floorX + 1)
+            ++end;
+
+        const int32_t A = permutations[X] + Y;
+        const int32_t AA = permutations[A] + Z;
+        const int32_t AB = permutations[A + 1] + Z;
+        const int32_t B = permutations[X + 1] + Y;
+        const int32_t BA = permutations[B] + Z;
+        const int32_t BB = permutations[B + 1] + Z;
+
+        const int32_t hashes[8] = {permutations[AA],     permutations[BA],     permutations[AB],
+                                   permutations[BB],     permutations[AA + 1], permutations[BA + 1],
+                                   permutations[AB + 1], permutations[BB + 1]};
+
+        const auto cellX = Isa::broadcast(floorX);
+
+        const auto gxAA = Isa::broadcast(gradientX<Real>(hashes[0]));
+        const auto gxBA = Isa::broadcast(gradientX<Real>(hashes[1]));
+        const auto gxAB = Isa::broadcast(gradientX<Real>(hashes[2]));
+        const auto gxBB = Isa::broadcast(gradientX<Real>(hashes[3]));
+        const auto gxAA1 = Isa::broadcast(gradientX<Real>(hashes[4]));
+        const auto gxBA1 = Isa::broadcast(gradientX<Real>(hashes[5]));
+        const auto gxAB1 = Isa::broadcast(gradientX<Real>(hashes[6]));
+        const auto gxBB1 = Isa::broadcast(gradientX<Real>(hashes[7]));
+
+        const auto gyzAA = gradientYZ(hashes[0], y, z);
+        const auto gyzBA = gradientYZ(hashes[1], y, z);
+        const auto gyzAB = gradientYZ(hashes[2], y1, z);
+        const auto gyzBB = gradientYZ(hashes[3], y1, z);
+        const auto gyzAA1 = gradientYZ(hashes[4], y, z1);
+        const auto gyzBA1 = gradientYZ(hashes[5], y, z1);
+        const auto gyzAB1 = gradientYZ(hashes[6], y1, z1);
+        const auto gyzBB1 = gradientYZ(hashes[7], y1, z1);
+
+        evaluateRun<Isa>(xs, out, begin, end, n, [&](typename Isa::Vec x) {
+            x = Isa::sub(x, cellX);
+
+            const auto u = fade<Isa>(x);
+            const auto x1 = Isa::sub(x, one);
+
+            const auto gAA = Isa::add(Isa::mul(gxAA, x), gyzAA);
+            const auto gBA = Isa::add(Isa::mul(gxBA, x1), gyzBA);
+            const auto gAB = Isa::add(Isa::mul(gxAB, x), gyzAB);
+            const auto gBB = Isa::add(Isa::mul(gxBB, x1), gyzBB);
+            const auto gAA1 = Isa::add(Isa::mul(gxAA1, x), gyzAA1);
+            const auto gBA1 = Isa::add(Isa::mul(gxBA1, x1), gyzBA1);
+            const auto gAB1 = Isa::add(Isa::mul(gxAB1, x), gyzAB1);
+            const auto gBB1 = Isa::add(Isa::mul(gxBB1, x1), gyzBB1);
+
+            return lerp<Isa>(w, lerp<Isa>(v, lerp<Isa>(u, gAA, gBA), lerp<Isa>(u, gAB, gBB)),
+                             lerp<Isa>(v, lerp<Isa>(u, gAA1, gBA1), lerp<Isa>(u, gAB1, gBB1)));
+        });
+
+        begin = end;
+    }
+}
+}  // namespace noisegen::simd
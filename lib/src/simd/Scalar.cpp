@@ -0,0 +1,175 @@
+/*
+**   Copyright 2021 Maxime Rayé
+**
+**   Licensed under the Apache License, Version 2.0 (the "License");
+**   you may not use this file except in compliance with the License.
+**   You may obtain a copy of the License at
+**
+**       http://www.apache.org/licenses/LICENSE-2.0
+**
+**   Unless required by applicable law or agreed to in writing, software
+**   distributed under the License is distributed on an "AS IS" BASIS,
+**   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**   See the License for the specific language governing permissions and
+**   limitations under the License.
+*/
+
+#include <cmath>
+
+#include "Kernels.hpp"
+#include "PerlinKernel.hpp"
+#include "SimplexKernel.hpp"
+
+namespace {
+template<typename T>
+struct ScalarTraits
+{
+    using Real = T;
+    using Vec = T;
+    using Index = int32_t;
+    static constexpr size_t Width = 1;
+
+    static inline Vec load(const Real *p) noexcept { return *p; }
+    static inline void store(Real *p, Vec v) noexcept { *p = v; }
+    static inline Vec set1(int value) noexcept { return static_cast<Real>(value); }
+    static inline Vec broadcast(Real value) noexcept { return value; }
+    static inline Vec add(Vec a, Vec b) noexcept { return a + b; }
+    static inline Vec sub(Vec a, Vec b) noexcept { return a - b; }
+    static inline Vec mul(Vec a, Vec b) noexcept { return a * b; }
+    static inline Vec floor(Vec v) noexcept { return std::floor(v); }
+    static inline Vec max(Vec a, Vec b) noexcept { return a > b ? a : b; }
+    static inline Vec greaterEqual(Vec a, Vec b) noexcept { return a >= b ? Real{1} : Real{0}; }
+
+    static inline Index toIndex(Vec floored) noexcept { return static_cast<Index>(floored) & 255; }
+    static inline Index addIndex(Index a, Index b) noexcept { return a + b; }
+    static inline Index increment(Index a) noexcept { return a + 1; }
+    static inline Index gather(const int32_t *table, Index index) noexcept { return table[index]; }
+
+    static inline Vec grad(Index hash, Vec x, Vec y, Vec z) noexcept
+    {
+        const Index h = hash & 15;
+        const Vec u = h < 8 ? x : y, v = h < 4 ? y : h == 12 || h == 14 ? x : z;
+        return ((h & 1) == 0 ? u : -u) + ((h & 2) == 0 ? v : -v);
+    }
+};
+}  // namespace
+
+void noisegen::simd::noise3DBatchScalar(const int32_t *permutations, const double *xs, const double *ys,
+                                        const double *zs, double *out, size_t n) noexcept
+{
+    noise3DBatch<ScalarTraits<double>>(permutations, xs, ys, zs, out, n);
+}
+
+void noisegen::simd::noise3DBatchScalar(const int32_t *permutations, const float *xs, const float *ys, const float *zs,
+                                        float *out, size_t n) noexcept
+{
+    noise3DBatch<ScalarTraits<float>>(permutations, xs, ys, zs, out, n);
+}
+
+void noisegen::simd::noise2DBatchScalar(const int32_t *permutations, const double *xs, const double *ys, double *out,
+                                        size_t n) noexcept
+{
+    noise2DBatch<ScalarTraits<double>>(permutations, xs, ys, out, n);
+}
+
+void noisegen::simd::noise2DBatchScalar(const int32_t *permutations, const float *xs, const float *ys, float *out,
+                                        size_t n) noexcept
+{
+    noise2DBatch<ScalarTraits<float>>(permutations, xs, ys, out, n);
+}
+
+void noisegen::simd::noise3DRowScalar(const int32_t *permutations, const double *xs, double y, double z, double *out,
+                                      size_t n) noexcept
+{
+    noise3DRow<ScalarTraits<double>>(permutations, xs, y, z, out, n);
+}
+
+void noisegen::simd::noise3DRowScalar(const int32_t *permutations, const float *xs, float y, float z, float *out,
+                                      size_t n) noexcept
+{
+    noise3DRow<ScalarTraits<float>>(permutations, xs, y, z, out, n);
+}
+
+void noisegen::simd::noise2DRowScalar(const int32_t *permutations, const double *xs, double y, double *out,
+                                      size_t n) noexcept
+{
+    noise2DRow<ScalarTraits<double>>(permutations, xs, y, out, n);
+}
+
+void noisegen::simd::noise2DRowScalar(const int32_t *permutations, const float *xs, float y, float *out,
+                                      size_t n) noexcept
+{
+    noise2DRow<ScalarTraits<float>>(permutations, xs, y, out, n);
+}
+
+void noisegen::simd::simplex3DBatchScalar(const int32_t *permutations, const double *xs, const double *ys,
+                                          const double *zs, double *out, size_t n) noexcept
+{
+    simplex3DBatch<ScalarTraits<double>>(permutations, xs, ys, zs, out, n);
+}
+
+void noisegen::simd::simplex3DBatchScalar(const int32_t *permutations, const float *xs, const float *ys,
+                                          const float *zs, float *out, size_t n) noexcept
+{
+    simplex3DBatch<ScalarTraits<float>>(permutations, xs, ys, zs, out, n);
+}
+
+void noisegen::simd::simplex2DBatchScalar(const int32_t *permutations, const double *xs, const double *ys,
+                                          double *out, size_t n) noexcept
+{
+    simplex2DBatch<ScalarTraits<double>>(permutations, xs, ys, out, n);
+}
+
+void noisegen::simd::simplex2DBatchScalar(const int32_t *permutations, const float *xs, const float *ys,
+                                          float *out, size_t n) noexcept
+{
+    simplex2DBatch<ScalarTraits<float>>(permutations, xs, ys, out, n);
+}
+
+void noisegen::simd::simplex3DRowScalar(const int32_t *permutations, const double *xs, double y, double z, double *out,
+                                        size_t n) noexcept
+{
+    simplex3DRow<ScalarTraits<double>>(permutations, xs, y, z, out, n);
+}
+
+void noisegen::simd::simplex3DRowScalar(const int32_t *permutations, const float *xs, float y, float z, float *out,
+                                        size_t n) noexcept
+{
+    simplex3DRow<ScalarTraits<float>>(permutations, xs, y, z, out, n);
+}
+
+void noisegen::simd::simplex2DRowScalar(const int32_t *permutations, const double *xs, double y, double *out,
+                                        size_t n) noexcept
+{
+    simplex2DRow<ScalarTraits<double>>(permutations, xs, y, out, n);
+}
+
+void noisegen::simd::simplex2DRowScalar(const int32_t *permutations, const float *xs, float y, float *out,
+                                        size_t n) noexcept
+{
+    simplex2DRow<ScalarTraits<float>>(permutations, xs, y, out, n);
+}
+
+void noisegen::simd::noise2DDerivativesRowScalar(const int32_t *permutations, const double *xs, double y, double *out,
+                                                 double *dxs, double *dys, size_t n) noexcept
+{
+    noise2DDerivativesRow<ScalarTraits<double>>(permutations, xs, y, out, dxs, dys, n);
+}
+
+void noisegen::simd::noise2DDerivativesRowScalar(const int32_t *permutations, const float *xs, float y, float *out,
+                                                 float *dxs, float *dys, size_t n) noexcept
+{
+    noise2DDerivativesRow<ScalarTraits<float>>(permutations, xs, y, out, dxs, dys, n);
+}
+
+void noisegen::simd::simplex2DDerivativesRowScalar(const int32_t *permutations, const double *xs, double y, double *out,
+                                                   double *dxs, double *dys, size_t n) noexcept
+{
+    simplex2DDerivativesRow<ScalarTraits<double>>(permutations, xs, y, out, dxs, dys, n);
+}
+
+void noisegen::simd::simplex2DDerivativesRowScalar(const int32_t *permutations, const float *xs, float y, float *out,
+                                                   float *dxs, float *dys, size_t n) noexcept
+{
+    simplex2DDerivativesRow<ScalarTraits<float>>(permutations, xs, y, out, dxs, dys, n);
+}
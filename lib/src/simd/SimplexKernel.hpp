@@ -0,0 +1,450 @@
+/*
+**   Copyright 2021 Maxime Rayé
+**
+**   Licensed under the Apache License, Version 2.0 (the "License");
+**   you may not use this file except in compliance with the License.
+**   You may obtain a copy of the License at
+**
+**       http://www.apache.org/licenses/LICENSE-2.0
+**
+**   Unless required by applicable law or agreed to in writing, software
+**   distributed under the License is distributed on an "AS IS" BASIS,
+**   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**   See the License for the specific language governing permissions and
+**   limitations under the License.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include "PerlinKernel.hpp"
+
+/*
+ * Simplex noise (Perlin 2001, as described by Stefan Gustavson), written against the same traits as PerlinKernel.hpp,
+ * plus max and greaterEqual (1 where a >= b, 0 elsewhere).
+ *
+ * Only n + 1 corners are evaluated instead of 2^n, and there is no interpolation: each corner contributes
+ * (r^2 - d^2)^4 * grad, with r^2 = 0.5 so that the noise is continuous.
+ * Corners are hashed with the same permutation table as Perlin noise, and use the same grad() gradients.
+ *
+ * The same inclusion rules as PerlinKernel.hpp apply.
+ */
+
+namespace noisegen::simd {
+/**
+ * Output scales bringing the noise to [-1, 1]: the largest unscaled values found by local search,
+ * over several permutations, are about 1 / 70.15 in 2D and 1 / 76.88 in 3D.
+ */
+constexpr double Simplex2DScale = 70.0;
+constexpr double Simplex3DScale = 76.0;
+
+template<typename Isa>
+inline typename Isa::Vec simplexFalloff(typename Isa::Vec x, typename Isa::Vec y, typename Isa::Vec z) noexcept
+{
+    using Real = typename Isa::Real;
+
+    const auto squaredDistance = Isa::add(Isa::add(Isa::mul(x, x), Isa::mul(y, y)), Isa::mul(z, z));
+    const auto t = Isa::max(Isa::sub(Isa::broadcast(Real{0.5}), squaredDistance), Isa::set1(0));
+    const auto t2 = Isa::mul(t, t);
+
+    return Isa::mul(t2, t2);
+}
+
+/**
+ * Contribution of the corner (i, j, k), given as floored lattice coordinates, to a point at (x, y, z) from it
+ */
+template<typename Isa>
+inline typename Isa::Vec simplexCorner3D(const int32_t *permutations, typename Isa::Vec i, typename Isa::Vec j,
+                                         typename Isa::Vec k, typename Isa::Vec x, typename Isa::Vec y,
+                                         typename Isa::Vec z) noexcept
+{
+    const auto hashK = Isa::gather(permutations, Isa::toIndex(k));
+    const auto hashJ = Isa::gather(permutations, Isa::addIndex(Isa::toIndex(j), hashK));
+    const auto hash = Isa::gather(permutations, Isa::addIndex(Isa::toIndex(i), hashJ));
+
+    return Isa::mul(simplexFalloff<Isa>(x, y, z), Isa::grad(hash, x, y, z));
+}
+
+template<typename Isa>
+inline typename Isa::Vec simplexCorner2D(const int32_t *permutations, typename Isa::Vec i, typename Isa::Vec j,
+                                         typename Isa::Vec x, typename Isa::Vec y) noexcept
+{
+    const auto zero = Isa::set1(0);
+    const auto hashJ = Isa::gather(permutations, Isa::toIndex(j));
+    const auto hash = Isa::gather(permutations, Isa::addIndex(Isa::toIndex(i), hashJ));
+
+    return Isa::mul(simplexFalloff<Isa>(x, y, zero), Isa::grad(hash, x, y, zero));
+}
+
+template<typename Isa>
+inline typename Isa::Vec simplex3D(const int32_t *permutations, typename Isa::Vec x, typename Isa::Vec y,
+                                   typename Isa::Vec z) noexcept
+{
+    using Real = typename Isa::Real;
+
+    const auto skew = Isa::broadcast(static_cast<Real>(1.0 / 3.0));
+    const auto unskew = Isa::broadcast(static_cast<Real>(1.0 / 6.0));
+    const auto unskew2 = Isa::broadcast(static_cast<Real>(2.0 / 6.0));
+    const auto unskew3 = Isa::broadcast(static_cast<Real>(3.0 / 6.0));
+    const auto one = Isa::set1(1);
+
+    // Simplex cell containing the point, and position of the point from its first corner
+    const auto s = Isa::mul(Isa::add(Isa::add(x, y), z), skew);
+    const auto i = Isa::floor(Isa::add(x, s));
+    const auto j = Isa::floor(Isa::add(y, s));
+    const auto k = Isa::floor(Isa::add(z, s));
+
+    const auto t = Isa::mul(Isa::add(Isa::add(i, j), k), unskew);
+    const auto x0 = Isa::sub(x, Isa::sub(i, t));
+    const auto y0 = Isa::sub(y, Isa::sub(j, t));
+    const auto z0 = Isa::sub(z, Isa::sub(k, t));
+
+    // Offsets of the second and third corners, from the order of x0, y0 and z0 (branchless, every value is 0 or 1)
+    const auto xGEy = Isa::greaterEqual(x0, y0);
+    const auto yGEz = Isa::greaterEqual(y0, z0);
+    const auto xGEz = Isa::greaterEqual(x0, z0);
+    const auto xLTy = Isa::sub(one, xGEy);
+
+    const auto i1 = Isa::mul(xGEy, xGEz);
+    const auto j1 = Isa::mul(xLTy, yGEz);
+    const auto k1 = Isa::mul(Isa::sub(one, xGEz), Isa::sub(one, yGEz));
+    const auto i2 = Isa::sub(Isa::add(xGEy, xGEz), Isa::mul(xGEy, xGEz));
+    const auto j2 = Isa::sub(Isa::add(xLTy, yGEz), Isa::mul(xLTy, yGEz));
+    const auto k2 = Isa::sub(one, Isa::mul(xGEz, yGEz));
+
+    const auto x1 = Isa::add(Isa::sub(x0, i1), unskew);
+    const auto y1 = Isa::add(Isa::sub(y0, j1), unskew);
+    const auto z1 = Isa::add(Isa::sub(z0, k1), unskew);
+    const auto x2 = Isa::add(Isa::sub(x0, i2), unskew2);
+    const auto y2 = Isa::add(Isa::sub(y0, j2), unskew2);
+    const auto z2 = Isa::add(Isa::sub(z0, k2), unskew2);
+    const auto x3 = Isa::add(Isa::sub(x0, one), unskew3);
+    const auto y3 = Isa::add(Isa::sub(y0, one), unskew3);
+    const auto z3 = Isa::add(Isa::sub(z0, one), unskew3);
+
+    const auto n0 = simplexCorner3D<Isa>(permutations, i, j, k, x0, y0, z0);
+    const auto n1 = simplexCorner3D<Isa>(permutations, Isa::add(i, i1), Isa::add(j, j1), Isa::add(k, k1), x1, y1, z1);
+    const auto n2 = simplexCorner3D<Isa>(permutations, Isa::add(i, i2), Isa::add(j, j2), Isa::add(k, k2), x2, y2, z2);
+    const auto n3 =
+      simplexCorner3D<Isa>(permutations, Isa::add(i, one), Isa::add(j, one), Isa::add(k, one), x3, y3, z3);
+
+    return Isa::mul(Isa::add(Isa::add(n0, n1), Isa::add(n2, n3)), Isa::broadcast(static_cast<Real>(Simplex3DScale)));
+}
+
+/**
+ * simplexCorner2D() along with its partial derivatives, stored in dx and dy:
+ * d/dx (t^4 g) = t^4 gx - 8 t^3 x g, with t = 0.5 - x^2 - y^2 (and no contribution when it is clamped to 0)
+ */
+template<typename Isa>
+inline typename Isa::Vec simplexCorner2DDerivatives(const int32_t *permutations, typename Isa::Vec i,
+                                                    typename Isa::Vec j, typename Isa::Vec x, typename Isa::Vec y,
+                                                    typename Isa::Vec &dx, typename Isa::Vec &dy) noexcept
+{
+    using Real = typename Isa::Real;
+
+    const auto zero = Isa::set1(0);
+    const auto one = Isa::set1(1);
+    const auto hashJ = Isa::gather(permutations, Isa::toIndex(j));
+    const auto hash = Isa::gather(permutations, Isa::addIndex(Isa::toIndex(i), hashJ));
+
+    // Same operations as simplexFalloff(), so that the value matches simplexCorner2D()
+    const auto squaredDistance = Isa::add(Isa::add(Isa::mul(x, x), Isa::mul(y, y)), Isa::mul(zero, zero));
+    const auto t = Isa::max(Isa::sub(Isa::broadcast(Real{0.5}), squaredDistance), zero);
+    const auto t2 = Isa::mul(t, t);
+    const auto t4 = Isa::mul(t2, t2);
+
+    const auto g = Isa::grad(hash, x, y, zero);
+    const auto t3g8 = Isa::mul(Isa::mul(t2, t), Isa::mul(g, Isa::set1(8)));
+
+    dx = Isa::sub(Isa::mul(t4, Isa::grad(hash, one, zero, zero)), Isa::mul(t3g8, x));
+    dy = Isa::sub(Isa::mul(t4, Isa::grad(hash, zero, one, zero)), Isa::mul(t3g8, y));
+
+    return Isa::mul(t4, g);
+}
+
+template<typename Isa>
+inline typename Isa::Vec simplex2D(const int32_t *permutations, typename Isa::Vec x, typename Isa::Vec y) noexcept
+{
+    using Real = typename Isa::Real;
+
+    // (sqrt(3) - 1) / 2 and (3 - sqrt(3)) / 6
+    const auto skew = Isa::broadcast(static_cast<Real>(0.36602540378443864676));
+    const auto unskew = Isa::broadcast(static_cast<Real>(0.21132486540518711775));
+    const auto unskew2 = Isa::broadcast(static_cast<Real>(2 * 0.21132486540518711775));
+    const auto one = Isa::set1(1);
+
+    const auto s = Isa::mul(Isa::add(x, y), skew);
+    const auto i = Isa::floor(Isa::add(x, s));
+    const auto j = Isa::floor(Isa::add(y, s));
+
+    const auto t = Isa::mul(Isa::add(i, j), unskew);
+    const auto x0 = Isa::sub(x, Isa::sub(i, t));
+    const auto y0 = Isa::sub(y, Isa::sub(j, t));
+
+    // Lower triangle (1, 0) when x0 >= y0, upper triangle (0, 1) otherwise
+    const auto i1 = Isa::greaterEqual(x0, y0);
+    const auto j1 = Isa::sub(one, i1);
+
+    const auto x1 = Isa::add(Isa::sub(x0, i1), unskew);
+    const auto y1 = Isa::add(Isa::sub(y0, j1), unskew);
+    const auto x2 = Isa::add(Isa::sub(x0, one), unskew2);
+    const auto y2 = Isa::add(Isa::sub(y0, one), unskew2);
+
+    const auto n0 = simplexCorner2D<Isa>(permutations, i, j, x0, y0);
+    const auto n1 = simplexCorner2D<Isa>(permutations, Isa::add(i, i1), Isa::add(j, j1), x1, y1);
+    const auto n2 = simplexCorner2D<Isa>(permutations, Isa::add(i, one), Isa::add(j, one), x2, y2);
+
+    return Isa::mul(Isa::add(Isa::add(n0, n1), n2), Isa::broadcast(static_cast<Real>(Simplex2DScale)));
+}
+
+template<typename Isa>
+inline void simplex3DBatch(const int32_t *permutations, const typename Isa::Real *xs, const typename Isa::Real *ys,
+                           const typename Isa::Real *zs, typename Isa::Real *out, size_t n) noexcept
+{
+    using Real = typename Isa::Real;
+    constexpr size_t Width = Isa::Width;
+
+    size_t i = 0;
+    for (; i + Width <= n; i += Width)
+        Isa::store(out + i, simplex3D<Isa>(permutations, Isa::load(xs + i), Isa::load(ys + i), Isa::load(zs + i)));
+
+    if (i == n)
+        return;
+
+    Real tailX[Width]{}, tailY[Width]{}, tailZ[Width]{}, tailOut[Width]{};
+    for (size_t j = 0; i + j < n; ++j)
+    {
+        tailX[j] = xs[i + j];
+        tailY[j] = ys[i + j];
+        tailZ[j] = zs[i + j];
+    }
+
+    Isa::store(tailOut, simplex3D<Isa>(permutations, Isa::load(tailX), Isa::load(tailY), Isa::load(tailZ)));
+
+    for (size_t j = 0; i + j < n; ++j)
+        out[i + j] = tailOut[j];
+}
+
+/**
+ * simplex2D() along with its partial derivatives along x and y, stored in dx and dy.
+ * The corner offsets only differ from (x, y) by constants within a simplex, so they share its derivatives.
+ */
+template<typename Isa>
+inline typename Isa::Vec simplex2DDerivatives(const int32_t *permutations, typename Isa::Vec x, typename Isa::Vec y,
+                                              typename Isa::Vec &dx, typename Isa::Vec &dy) noexcept
+{
+    using Real = typename Isa::Real;
+
+    const auto skew = Isa::broadcast(static_cast<Real>(0.36602540378443864676));
+    const auto unskew = Isa::broadcast(static_cast<Real>(0.21132486540518711775));
+    const auto unskew2 = Isa::broadcast(static_cast<Real>(2 * 0.21132486540518711775));
+    const auto one = Isa::set1(1);
+
+    const auto s = Isa::mul(Isa::add(x, y), skew);
+    const auto i = Isa::floor(Isa::add(x, s));
+    const auto j = Isa::floor(Isa::add(y, s));
+
+    const auto t = Isa::mul(Isa::add(i, j), unskew);
+    const auto x0 = Isa::sub(x, Isa::sub(i, t));
+    const auto y0 = Isa::sub(y, Isa::sub(j, t));
+
+    const auto i1 = Isa::greaterEqual(x0, y0);
+    const auto j1 = Isa::sub(one, i1);
+
+    const auto x1 = Isa::add(Isa::sub(x0, i1), unskew);
+    const auto y1 = Isa::add(Isa::sub(y0, j1), unskew);
+    const auto x2 = Isa::add(Isa::sub(x0, one), unskew2);
+    const auto y2 = Isa::add(Isa::sub(y0, one), unskew2);
+
+    typename Isa::Vec dx0{}, dy0{}, dx1{}, dy1{}, dx2{}, dy2{};
+    const auto n0 = simplexCorner2DDerivatives<Isa>(permutations, i, j, x0, y0, dx0, dy0);
+    const auto n1 = simplexCorner2DDerivatives<Isa>(permutations, Isa::add(i, i1), Isa::add(j, j1), x1, y1, dx1, dy1);
+    const auto n2 = simplexCorner2DDerivatives<Isa>(permutations, Isa::add(i, one), Isa::add(j, one), x2, y2, dx2, dy2);
+
+    const auto scale = Isa::broadcast(static_cast<Real>(Simplex2DScale));
+    dx = Isa::mul(Isa::add(Isa::add(dx0, dx1), dx2), scale);
+    dy = Isa::mul(Isa::add(Isa::add(dy0, dy1), dy2), scale);
+
+    return Isa::mul(Isa::add(Isa::add(n0, n1), n2), scale);
+}
+
+template<typename Isa>
+inline void simplex2DBatch(const int32_t *permutations, const typename Isa::Real *xs, const typename Isa::Real *ys,
+                           typename Isa::Real *out, size_t n) noexcept
+{
+    using Real = typename Isa::Real;
+    constexpr size_t Width = Isa::Width;
+
+    size_t i = 0;
+    for (; i + Width <= n; i += Width)
+        Isa::store(out + i, simplex2D<Isa>(permutations, Isa::load(xs + i), Isa::load(ys + i)));
+
+    if (i == n)
+        return;
+
+    Real tailX[Width]{}, tailY[Width]{}, tailOut[Width]{};
+    for (size_t j = 0; i + j < n; ++j)
+    {
+        tailX[j] = xs[i + j];
+        tailY[j] = ys[i + j];
+    }
+
+    Isa::store(tailOut, simplex2D<Isa>(permutations, Isa::load(tailX), Isa::load(tailY)));
+
+    for (size_t j = 0; i + j < n; ++j)
+        out[i + j] = tailOut[j];
+}
+
+/**
+ * simplex2DDerivatives() for a row of samples sharing the same y
+ */
+template<typename Isa>
+inline void simplex2DDerivativesRow(const int32_t *permutations, const typename Isa::Real *xs, typename Isa::Real y,
+                                    typename Isa::Real *out, typename Isa::Real *dxs, typename Isa::Real *dys,
+                                    size_t n) noexcept
+{
+    const auto ys = Isa::broadcast(y);
+
+    evaluateDerivativesRun<Isa>(xs, out, dxs, dys, 0, n, n,
+                                [&](typename Isa::Vec x, typename Isa::Vec &dx, typename Isa::Vec &dy) {
+                                    return simplex2DDerivatives<Isa>(permutations, x, ys, dx, dy);
+                                });
+}
+
+/**
+ * simplex2D() for a row of samples sharing the same y, with xs sorted in increasing order.
+ *
+ * Both skewed cell coordinates only grow along a row, so samples are walked simplex cell by simplex cell:
+ * the four candidate corner gradients are computed once per cell and y0 is constant, leaving the falloffs per sample,
+ * without any gather. Rows with only a few samples per cell (high frequencies) use the gather kernel instead.
+ */
+template<typename Isa>
+inline void simplex2DRow(const int32_t *permutations, const typename Isa::Real *xs, typename Isa::Real y,
+                         typename Isa::Real *out, size_t n) noexcept
+{
+    using Real = typename Isa::Real;
+    // A row crosses about 1.7 simplex cells per unit, each one usually ending mid-vector: needs longer runs than Perlin
+    constexpr size_t MinSamplesPerCell = 2 * Isa::Width;
+
+    if (n == 0)
+        return;
+
+    // Same constants and operations as simplex2D(), so that both kernels give the same values
+    const Real skew = static_cast<Real>(0.36602540378443864676);
+    const Real unskew = static_cast<Real>(0.21132486540518711775);
+    const Real unskew2 = static_cast<Real>(2 * 0.21132486540518711775);
+
+    const auto cellOf = [&](Real x) {
+        const Real s = (x + y) * skew;
+        return std::make_pair(std::floor(x + s), std::floor(y + s));
+    };
+
+    const auto first = cellOf(xs[0]);
+    const auto last = cellOf(xs[n - 1]);
+    const Real cellCount = (last.first - first.first) + (last.second - first.second) + 1;
+
+    if (static_cast<Real>(n) < cellCount * static_cast<Real>(MinSamplesPerCell))
+    {
+        const auto ys = Isa::broadcast(y);
+
+        evaluateRun<Isa>(xs, out, 0, n, n, [&](typename Isa::Vec x) { return simplex2D<Isa>(permutations, x, ys); });
+        return;
+    }
+
+    const auto zero = Isa::set1(0);
+    const auto one = Isa::set1(1);
+    const auto scale = Isa::broadcast(static_cast<Real>(Simplex2DScale));
+
+    for (size_t begin = 0; begin < n;)
+    {
+        const auto cell = cellOf(xs[begin]);
+
+        // Cell coordinates never decrease along the row (every rounding step is monotonic), so the samples still
+        // in the cell are the ones below its upper bounds: gallop past the last of them, then binary search it
+        const auto [i, j] = cell;
+        const auto inCell = [&, i = i, j = j](Real x) {
+            const Real s = (x + y) * skew;
+            return x + s < i + 1 && y + s < j + 1;
+        };
+
+        size_t step = 1;
+        while (begin + step < n && inCell(xs[begin + step]))
+            step *= 2;
+
+        const Real *const stepEnd = xs + std::min(begin + step, n);
+        const size_t end = static_cast<size_t>(std::partition_point(xs + begin + step / 2 + 1, stepEnd, inCell) - xs);
+
+        const Real t = (i + j) * unskew;
+        const Real y0 = y - (j - t);
+
+        const int32_t I = static_cast<int32_t>(i) & 255;
+        const int32_t J = static_cast<int32_t>(j) & 255;
+        const int32_t I1 = static_cast<int32_t>(i + 1) & 255;
+        const int32_t J1 = static_cast<int32_t>(j + 1) & 255;
+
+        const int32_t hash00 = permutations[I + permutations[J]];
+        const int32_t hash10 = permutations[I1 + permutations[J]];
+        const int32_t hash01 = permutations[I + permutations[J1]];
+        const int32_t hash11 = permutations[I1 + permutations[J1]];
+
+        const auto cellX = Isa::broadcast(i - t);
+        const auto y0s = Isa::broadcast(y0);
+        const auto y2s = Isa::broadcast((y0 - 1) + unskew2);
+
+        const auto gx00 = Isa::broadcast(gradientX<Real>(hash00));
+        const auto gy00 = Isa::broadcast(gradientY<Real>(hash00));
+        const auto gx11 = Isa::broadcast(gradientX<Real>(hash11));
+        const auto gy11 = Isa::broadcast(gradientY<Real>(hash11));
+
+        // Middle corner (1, 0) or (0, 1): gradient coefficients are -1, 0 or 1, so blending them by 1 or 0 is exact
+        const auto gx01 = Isa::broadcast(gradientX<Real>(hash01));
+        const auto gy01 = Isa::broadcast(gradientY<Real>(hash01));
+        const auto gxDelta = Isa::broadcast(gradientX<Real>(hash10) - gradientX<Real>(hash01));
+        const auto gyDelta = Isa::broadcast(gradientY<Real>(hash10) - gradientY<Real>(hash01));
+
+        evaluateRun<Isa>(xs, out, begin, end, n, [&](typename Isa::Vec x) {
+            const auto x0 = Isa::sub(x, cellX);
+
+            const auto i1 = Isa::greaterEqual(x0, y0s);
+            const auto j1 = Isa::sub(one, i1);
+
+            const auto x1 = Isa::add(Isa::sub(x0, i1), Isa::broadcast(unskew));
+            const auto y1 = Isa::add(Isa::sub(y0s, j1), Isa::broadcast(unskew));
+            const auto x2 = Isa::add(Isa::sub(x0, one), Isa::broadcast(unskew2));
+
+            const auto gx1 = Isa::add(gx01, Isa::mul(i1, gxDelta));
+            const auto gy1 = Isa::add(gy01, Isa::mul(i1, gyDelta));
+
+            const auto g0 = Isa::add(Isa::mul(gx00, x0), Isa::mul(gy00, y0s));
+            const auto g1 = Isa::add(Isa::mul(gx1, x1), Isa::mul(gy1, y1));
+            const auto g2 = Isa::add(Isa::mul(gx11, x2), Isa::mul(gy11, y2s));
+
+            const auto n0 = Isa::mul(simplexFalloff<Isa>(x0, y0s, zero), g0);
+            const auto n1 = Isa::mul(simplexFalloff<Isa>(x1, y1, zero), g1);
+            const auto n2 = Isa::mul(simplexFalloff<Isa>(x2, y2s, zero), g2);
+
+            return Isa::mul(Isa::add(Isa::add(n0, n1), n2), scale);
+        });
+
+        begin = end;
+    }
+}
+
+/**
+ * simplex3DBatch() with a shared y and z, every sample still goes through the gathers.
+ */
+template<typename Isa>
+inline void simplex3DRow(const int32_t *permutations, const typename Isa::Real *xs, typename Isa::Real y,
+                         typename Isa::Real z, typename Isa::Real *out, size_t n) noexcept
+{
+    const auto ys = Isa::broadcast(y);
+    const auto zs = Isa::broadcast(z);
+
+    evaluateRun<Isa>(xs, out, 0, n, n, [&](typename Isa::Vec x) { return simplex3D<Isa>(permutations, x, ys, zs); });
+}
+}  // namespace noisegen::simd
@@ -0,0 +1,97 @@
+/*
+**   Copyright 2021 Maxime Rayé
+**
+**   Licensed under the Apache License, Version 2.0 (the "License");
+**   you may not use this file except in compliance with the License.
+**   You may obtain a copy of the License at
+**
+**       http://www.apache.org/licenses/LICENSE-2.0
+**
+**   Unless required by applicable law or agreed to in writing, software
+**   distributed under the License is distributed on an "AS IS" BASIS,
+**   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**   See the License for the specific language governing permissions and
+**   limitations under the License.
+*/
+
+/*
+ * GeneratorF renders the same images as Generator, up to one quantization step.
+ * Each case renders the same settings with both precisions through generateInto<uint8_t> and generateInto<uint16_t>
+ * and fails if any sample differs by more than 1.
+ */
+
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+#include <string>
+#include <iostream>
+#include <algorithm>
+
+#include <noisegen/Generator.hpp>
+
+namespace {
+
+template<typename T>
+uint32_t maxDifference(const noisegen::Settings &settings)
+{
+    const size_t samples = static_cast<size_t>(settings.width) * settings.height;
+    std::vector<T> doubles(samples);
+    std::vector<T> floats(samples);
+
+    noisegen::Generator{settings}.generateInto(doubles.data());
+    noisegen::GeneratorF{settings}.generateInto(floats.data());
+
+    uint32_t difference = 0;
+    for (size_t i = 0; i < samples; ++i)
+        difference = std::max(difference, static_cast<uint32_t>(std::abs(int32_t{doubles[i]} - int32_t{floats[i]})));
+    return difference;
+}
+
+bool check(const std::string &name, const noisegen::Settings &settings)
+{
+    const uint32_t difference8 = maxDifference<uint8_t>(settings);
+    const uint32_t difference16 = maxDifference<uint16_t>(settings);
+    const bool bPassed = difference8 <= 1 && difference16 <= 1;
+
+    std::cout << (bPassed ? "ok     " : "FAILED ") << name << ": max difference " << difference8 << " (8-bit), "
+              << difference16 << " (16-bit)\n";
+    return bPassed;
+}
+
+}  // namespace
+
+int main()
+{
+    noisegen::Settings base{};
+    base.width = 640;
+    base.height = 480;
+    base.threads = 1;
+
+    bool bPassed = true;
+
+    noisegen::Settings settings = base;
+    settings.bUseKenPerlinPermutations = true;
+    bPassed &= check("Ken Perlin, min/max", settings);
+
+    settings = base;
+    settings.seed = 42;
+    settings.octaves = 11;
+    bPassed &= check("seed 42, 11 octaves", settings);
+
+    settings = base;
+    settings.seed = 7;
+    settings.normalization = noisegen::Normalization::Analytic;
+    bPassed &= check("seed 7, analytic range", settings);
+
+    settings = base;
+    settings.seed = 7;
+    settings.basis = noisegen::Basis::Simplex;
+    bPassed &= check("seed 7, simplex", settings);
+
+    settings = base;
+    settings.seed = 3;
+    settings.depth = 4;
+    bPassed &= check("seed 3, first slice of a volume", settings);
+
+    return bPassed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
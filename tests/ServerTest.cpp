@@ -0,0 +1,154 @@
+/*
+**   Copyright 2021 Maxime Rayé
+**
+**   Licensed under the Apache License, Version 2.0 (the "License");
+**   you may not use this file except in compliance with the License.
+**   You may obtain a copy of the License at
+**
+**       http://www.apache.org/licenses/LICENSE-2.0
+**
+**   Unless required by applicable law or agreed to in writing, software
+**   distributed under the License is distributed on an "AS IS" BASIS,
+**   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**   See the License for the specific language governing permissions and
+**   limitations under the License.
+*/
+
+/*
+ * Protocol of `noisegencli serve`, exercised through Client: a server runs on a temporary socket, the test sends
+ * requests on one connection and checks the responses and the bytes of the images.
+ */
+
+#include <thread>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <memory>
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+
+#include <unistd.h>
+
+#include <noisegen/Generator.hpp>
+#include <noisegen/PGMWriter.hpp>
+#include <noisegen/Exception.hpp>
+
+#include "Client.hpp"
+#include "Server.hpp"
+
+namespace {
+
+bool s_bPassed = true;
+
+void check(bool bCondition, const std::string &name)
+{
+    std::cout << (bCondition ? "ok     " : "FAILED ") << name << '\n';
+    s_bPassed &= bCondition;
+}
+
+bool isError(const Client::Response &response, const std::string &message)
+{
+    const auto status = response.members.find("status");
+    const auto text = response.members.find("message");
+    return status != response.members.end() && status->second.string == "error" && text != response.members.end()
+           && text->second.string.find(message) != std::string::npos;
+}
+
+std::unique_ptr<Client> connect(const std::string &socketPath)
+{
+    // The server starts listening asynchronously
+    for (uint32_t attempt = 0;; ++attempt)
+    {
+        try
+        {
+            return std::make_unique<Client>(socketPath);
+        } catch (const noisegen::Exception &)
+        {
+            if (attempt == 100)
+                throw;
+            std::this_thread::sleep_for(std::chrono::milliseconds{50});
+        }
+    }
+}
+
+}  // namespace
+
+int main()
+{
+    const std::string socketPath = "/tmp/noisegen_server_test_" + std::to_string(::getpid()) + ".sock";
+
+    Server server{socketPath, 2, ""};
+    std::thread serverThread{[&server] { server.run(); }};
+
+    try
+    {
+        auto client = connect(socketPath);
+
+        // Same bytes as a local render
+        noisegen::Settings settings{};
+        settings.width = 64;
+        settings.height = 32;
+        settings.seed = 7;
+        std::vector<uint8_t> pixels(size_t{settings.width} * settings.height);
+        noisegen::Generator{settings}.generateInto(pixels.data());
+        const std::string expected = noisegen::PGMWriter::header(settings.format, settings.width, settings.height)
+                                     + std::string{pixels.cbegin(), pixels.cend()};
+
+        auto response = client->request(R"({"id": 1, "width": 64, "height": 32, "seed": 7})");
+        check(response.members["status"].string == "ok" && response.members["id"].raw == "1", "inline request");
+        check(response.members["seed"].raw == "7", "seed echoed");
+        check(response.payload == expected, "inline image matches a local render");
+
+        response = client->request(R"({"id": 2, "width": 8, "height": 8, "octaves": 65})");
+        check(isError(response, "octaves"), "octaves capped");
+
+        response = client->request(R"({"id": 2, "width": 8, "height": 8, "pipeline": "fbm(octaves=40) * 0.5 + 0.5"})");
+        check(response.members["status"].string == "ok", "pipeline within the octave budget");
+
+        response = client->request(
+          R"({"id": 2, "width": 8, "height": 8, "pipeline": "fbm(octaves=40) + fbm(octaves=40) * 0.5"})");
+        check(isError(response, "octaves"), "pipeline octaves capped");
+
+        response = client->request(R"({"id": 2, "width": 8, "height": 8, "persistence": "0.5"})");
+        check(isError(response, "persistence must be a number"), "non-number persistence named");
+
+        response = client->request(R"({"id": 3, "width": 8, "height": 8, "output": "image.pgm"})");
+        check(isError(response, "--output-dir"), "output refused without --output-dir");
+
+        response = client->request(R"({"id": 4, "width": 8, "height": 8, "pipeline": ")" + std::string(1000, '(')
+                                   + R"("})");
+        check(isError(response, "nested deeper"), "pipeline nesting bounded");
+
+        response = client->request(R"({"id": 5, "width": 8, "height": 8, "seed": 5, "kenperlin": true})");
+        check(isError(response, "kenperlin and seed"), "kenperlin and seed rejected together");
+
+        response = client->request(R"({"id": 5, "width": 8})");
+        check(isError(response, "required"), "missing height");
+
+        response = client->request(R"({"id": 5, "width": -8, "height": 8})");
+        check(isError(response, "width must be an unsigned integer"), "negative width named");
+
+        response = client->request(R"({"id": nan, "width": 8, "height": 8})");
+        check(isError(response, "unexpected value"), "nan rejected");
+
+        response = client->request(R"({"id": +1, "width": 8, "height": 8})");
+        check(isError(response, "unexpected value"), "non-JSON number rejected");
+
+        response = client->request("not json");
+        check(isError(response, "expected"), "invalid request");
+
+        response = client->request(R"({"id": 6, "width": 16, "height": 16, "format": "p5-16"})");
+        const size_t size = noisegen::PGMWriter::header(noisegen::ImageFormat::PGMBinary16, 16, 16).size() + 512;
+        check(response.members["status"].string == "ok" && response.payload.size() == size,
+              "connection still usable after errors");
+    } catch (const noisegen::Exception &e)
+    {
+        check(false, e.what());
+    }
+
+    std::raise(SIGINT);
+    serverThread.join();
+
+    return s_bPassed ? EXIT_SUCCESS : EXIT_FAILURE;
+}